@@ -0,0 +1,365 @@
+// Benchmark of the stages of the cloth simulation for several resolutions and numbers of cloths.
+//  Each configuration runs warmup steps, then times every stage for each repetition over all the cloths (one task
+//  per cloth, as in the interactive application). The results are printed as a table and written as JSON so that two
+//  runs (ex. before and after a change) can be compared.
+//
+//  Usage: projet_benchmark [options]
+//    --edges LIST        samples per edge of the cloths, default 20,40,80,160,320
+//    --cloths LIST       numbers of cloths, default 1,12,100
+//    --warmup N          untimed steps before the measures, default 5
+//    --repetitions N     timed repetitions of each stage, default 50
+//    --solver NAME       solver of the full substep: explicit, implicit, xpbd or projective, default explicit
+//    --wind L            wind level of the fan (0: off, 1 to 3), default 2
+//    --threads N         number of worker threads, default one per hardware thread
+//    --max-vertices N    skip the configurations with more vertices in total (memory), 0: no limit, default 4194304
+//    --label TEXT        label stored in the JSON output (ex. the commit), default empty
+//    --output FILE       JSON output, default benchmark.json
+
+#include "cgp_headless.hpp"
+#include "cloth/cloth.hpp"
+#include "constraint/constraint.hpp"
+#include "simulation/simulation.hpp"
+#include "scene_description/scene_description.hpp"
+#include "task_pool/task_pool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace cgp;
+
+
+struct benchmark_options
+{
+    std::vector<int> edges = { 20, 40, 80, 160, 320 };
+    std::vector<int> cloths = { 1, 12, 100 };
+    int warmup = 5;
+    int repetitions = 50;
+    simulation_solver solver = simulation_solver::explicit_euler;
+    std::string solver_name = "explicit";
+    int wind = 2;
+    int threads = 0;
+    long long max_vertices = 4194304;
+    std::string label;
+    std::string output = "benchmark.json";
+};
+
+// Timing statistics of a stage, in microseconds
+struct benchmark_statistics
+{
+    double mean = 0;
+    double min = 0;
+    double p50 = 0;
+    double p90 = 0;
+    double p99 = 0;
+    double max = 0;
+};
+
+struct benchmark_result
+{
+    int edge;
+    int N_cloth;
+    long long N_vertex;
+    bool skipped = false;  // over the vertex budget
+    bool diverged = false; // a cloth contains NaN or infinite values at the end of the measures
+    std::vector<benchmark_statistics> stages;
+};
+
+// The timed stages, in the order of a step of the explicit solver
+static std::vector<std::string> const stage_names = { "compute_force", "numerical_integration", "apply_constraints", "update_normal", "substep" };
+
+
+static void print_usage()
+{
+    std::cout << "Usage: projet_benchmark [--edges 20,40,...] [--cloths 1,12,...] [--warmup N] [--repetitions N]" << std::endl;
+    std::cout << "                        [--solver explicit|implicit|xpbd|projective] [--wind 0-3] [--threads N]" << std::endl;
+    std::cout << "                        [--max-vertices N] [--label TEXT] [--output FILE]" << std::endl;
+}
+
+static bool parse_list(std::string const& text, std::vector<int>& values)
+{
+    values.clear();
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        int const value = std::atoi(item.c_str());
+        if (value <= 0)
+            return false;
+        values.push_back(value);
+    }
+    return !values.empty();
+}
+
+static bool parse_solver(std::string const& name, simulation_solver& solver)
+{
+    if (name == "explicit") solver = simulation_solver::explicit_euler;
+    else if (name == "implicit") solver = simulation_solver::implicit_euler;
+    else if (name == "xpbd") solver = simulation_solver::xpbd;
+    else if (name == "projective") solver = simulation_solver::projective;
+    else return false;
+    return true;
+}
+
+static bool parse_options(int argc, char** argv, benchmark_options& options)
+{
+    for (int k = 1; k < argc; ++k)
+    {
+        std::string const arg = argv[k];
+        bool const has_value = k + 1 < argc;
+        bool valid = true;
+        if (arg == "--edges" && has_value) valid = parse_list(argv[++k], options.edges);
+        else if (arg == "--cloths" && has_value) valid = parse_list(argv[++k], options.cloths);
+        else if (arg == "--warmup" && has_value) options.warmup = std::atoi(argv[++k]);
+        else if (arg == "--repetitions" && has_value) options.repetitions = std::atoi(argv[++k]);
+        else if (arg == "--solver" && has_value) {
+            options.solver_name = argv[++k];
+            valid = parse_solver(options.solver_name, options.solver);
+        }
+        else if (arg == "--wind" && has_value) options.wind = std::atoi(argv[++k]);
+        else if (arg == "--threads" && has_value) options.threads = std::atoi(argv[++k]);
+        else if (arg == "--max-vertices" && has_value) options.max_vertices = std::atoll(argv[++k]);
+        else if (arg == "--label" && has_value) options.label = argv[++k];
+        else if (arg == "--output" && has_value) options.output = argv[++k];
+        else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return false;
+        }
+        if (!valid) {
+            std::cerr << "Invalid value for " << arg << std::endl;
+            return false;
+        }
+    }
+
+    for (int edge : options.edges) {
+        if (edge <= 5) {
+            std::cerr << "The cloths need more than 5 samples per edge (pins)" << std::endl;
+            return false;
+        }
+    }
+    if (options.warmup < 0 || options.repetitions <= 0) {
+        std::cerr << "Invalid option value (warmup >= 0, repetitions > 0)" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Nearest-rank percentile of sorted samples
+static double percentile(std::vector<double> const& sorted, double p)
+{
+    size_t const rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+    return sorted[std::min(sorted.size() - 1, rank > 0 ? rank - 1 : 0)];
+}
+
+static benchmark_statistics compute_statistics(std::vector<double> samples)
+{
+    std::sort(samples.begin(), samples.end());
+    benchmark_statistics statistics;
+    double sum = 0;
+    for (double s : samples)
+        sum += s;
+    statistics.mean = sum / samples.size();
+    statistics.min = samples.front();
+    statistics.p50 = percentile(samples, 50);
+    statistics.p90 = percentile(samples, 90);
+    statistics.p99 = percentile(samples, 99);
+    statistics.max = samples.back();
+    return statistics;
+}
+
+// Wall time of a call in microseconds
+static double time_call(std::function<void()> const& call)
+{
+    auto const time_start = std::chrono::steady_clock::now();
+    call();
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - time_start).count();
+}
+
+static benchmark_result run_configuration(benchmark_options const& options, simulation_parameters const& parameters, task_pool& tasks, int edge, int N_cloth)
+{
+    benchmark_result result;
+    result.edge = edge;
+    result.N_cloth = N_cloth;
+    result.N_vertex = static_cast<long long>(edge) * edge * N_cloth;
+    if (options.max_vertices > 0 && result.N_vertex > options.max_vertices) {
+        result.skipped = true;
+        return result;
+    }
+
+    // The cloths of the scene, repeated when more cloths are needed
+    std::vector<cloth_description> const clothes = scene_description_clothes();
+    std::vector<cloth_structure> cloths(N_cloth);
+    std::vector<constraint_structure> constraints(N_cloth);
+    for (int k = 0; k < N_cloth; ++k)
+        scene_description_initialize_cloth(clothes[k % clothes.size()], edge, cloths[k], constraints[k]);
+
+    // Explicit time step bounded by the stability of the resolution: the cloths stay finite whatever the number of steps
+    std::vector<float> dt(N_cloth);
+    for (int k = 0; k < N_cloth; ++k)
+        dt[k] = std::min(parameters.dt, simulation_stable_time_step(cloths[k]));
+    float const substep_dt = simulation_time_step(parameters);
+
+    std::vector<std::function<void(int)>> const stages = {
+        [&](int k) { simulation_compute_force(cloths[k], parameters); },
+        [&](int k) { simulation_numerical_integration(cloths[k], constraints[k], dt[k]); },
+        [&](int k) { simulation_apply_constraints(cloths[k], constraints[k], parameters); },
+        [&](int k) { cloths[k].update_normal(); },
+        [&](int k) { simulation_step(cloths[k], constraints[k], parameters, parameters.solver == simulation_solver::explicit_euler ? dt[k] : substep_dt); }
+    };
+    int const N_stage = stages.size();
+
+    std::vector<std::vector<double>> samples(N_stage);
+    for (int k_repetition = 0; k_repetition < options.warmup + options.repetitions; ++k_repetition)
+    {
+        for (int k_stage = 0; k_stage < N_stage; ++k_stage)
+        {
+            double const time = time_call([&]() { tasks.run(N_cloth, stages[k_stage]); });
+            if (k_repetition >= options.warmup)
+                samples[k_stage].push_back(time);
+        }
+    }
+
+    for (int k_stage = 0; k_stage < N_stage; ++k_stage)
+        result.stages.push_back(compute_statistics(samples[k_stage]));
+    for (cloth_structure const& cloth : cloths)
+        result.diverged = result.diverged || simulation_detect_divergence(cloth);
+    return result;
+}
+
+// Text as a JSON string
+static std::string json_string(std::string const& text)
+{
+    std::string escaped = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') escaped += '\\';
+        escaped += c;
+    }
+    return escaped + "\"";
+}
+
+static void write_json(std::ostream& stream, benchmark_options const& options, int N_worker, std::vector<benchmark_result> const& results)
+{
+    stream << std::setprecision(6);
+    stream << "{\n";
+    stream << "  \"label\": " << json_string(options.label) << ",\n";
+    stream << "  \"kernels\": \"" << simd_kernels().name << "\",\n";
+    stream << "  \"threads\": " << N_worker << ",\n";
+    stream << "  \"solver\": \"" << options.solver_name << "\",\n";
+    stream << "  \"wind\": " << options.wind << ",\n";
+    stream << "  \"warmup\": " << options.warmup << ",\n";
+    stream << "  \"repetitions\": " << options.repetitions << ",\n";
+    stream << "  \"max_vertices\": " << options.max_vertices << ",\n";
+
+    // Configurations left out by --max-vertices, listed so that two runs with different limits are not compared silently
+    stream << "  \"skipped\": [";
+    bool first_skipped = true;
+    for (benchmark_result const& result : results) {
+        if (!result.skipped)
+            continue;
+        stream << (first_skipped ? "" : ", ") << "{\"edge\": " << result.edge << ", \"cloths\": " << result.N_cloth << "}";
+        first_skipped = false;
+    }
+    stream << "],\n";
+    stream << "  \"unit\": \"us\",\n";
+    stream << "  \"results\": [\n";
+    for (size_t k = 0; k < results.size(); ++k)
+    {
+        benchmark_result const& result = results[k];
+        stream << "    {\"edge\": " << result.edge << ", \"cloths\": " << result.N_cloth << ", \"vertices\": " << result.N_vertex;
+        stream << ", \"skipped\": " << (result.skipped ? "true" : "false") << ", \"diverged\": " << (result.diverged ? "true" : "false");
+        stream << ", \"stages\": {";
+        for (size_t k_stage = 0; k_stage < result.stages.size(); ++k_stage)
+        {
+            benchmark_statistics const& s = result.stages[k_stage];
+            stream << (k_stage > 0 ? ", " : "") << "\n      \"" << stage_names[k_stage] << "\": {";
+            stream << "\"mean\": " << s.mean << ", \"min\": " << s.min << ", \"p50\": " << s.p50 << ", \"p90\": " << s.p90;
+            stream << ", \"p99\": " << s.p99 << ", \"max\": " << s.max << ", \"ns_per_vertex\": " << 1000.0 * s.p50 / result.N_vertex << "}";
+        }
+        stream << (result.stages.empty() ? "}}" : "\n    }}") << (k + 1 < results.size() ? "," : "") << "\n";
+    }
+    stream << "  ]\n";
+    stream << "}\n";
+}
+
+int main(int argc, char** argv)
+{
+    benchmark_options options;
+    if (!parse_options(argc, argv, options)) {
+        print_usage();
+        return 1;
+    }
+
+    // Same scene settings as projet_headless: fixed time steps, fan at the center with a fixed orientation
+    simulation_parameters parameters;
+    parameters.solver = options.solver;
+    parameters.adaptive.enabled = false;
+    parameters.fan_position = { 0, 0, 1 };
+    simulation_initialize_obstacles(parameters, constraint_structure().ground_z);
+    parameters.wind.magnitude = scene_description_wind_magnitude(options.wind);
+    parameters.wind.source = { 0, 0, parameters.wind.initial_direction.z };
+    parameters.wind.direction = normalize(parameters.wind.initial_direction);
+    wind_field_structure wind_field;
+    simulation_update_wind_field(wind_field, parameters);
+
+    task_pool tasks;
+    tasks.initialize(options.threads);
+
+    std::cout << "Benchmark: " << tasks.N_worker() << " threads, vectorized kernels: " << simd_kernels().name
+        << ", solver: " << options.solver_name << ", " << options.warmup << " warmup + " << options.repetitions << " repetitions" << std::endl;
+    std::cout << "Median time in us (p90)" << std::endl;
+    std::cout << std::setw(6) << "edge" << std::setw(8) << "cloths";
+    for (std::string const& name : stage_names)
+        std::cout << std::setw(24) << name;
+    std::cout << std::endl;
+
+    std::vector<benchmark_result> results;
+    for (int N_cloth : options.cloths)
+    {
+        for (int edge : options.edges)
+        {
+            benchmark_result const result = run_configuration(options, parameters, tasks, edge, N_cloth);
+            results.push_back(result);
+
+            std::cout << std::setw(6) << edge << std::setw(8) << N_cloth;
+            if (result.skipped)
+                std::cout << "  skipped (" << result.N_vertex << " vertices > --max-vertices)";
+            for (benchmark_statistics const& s : result.stages) {
+                std::stringstream cell;
+                cell << std::fixed << std::setprecision(1) << s.p50 << " (" << s.p90 << ")";
+                std::cout << std::setw(24) << cell.str();
+            }
+            if (result.diverged)
+                std::cout << "  diverged";
+            std::cout << std::endl;
+        }
+    }
+
+    // Summary of the configurations without measures, so that an incomplete run is visible at the end of the report
+    std::stringstream skipped;
+    int N_skipped = 0;
+    for (benchmark_result const& result : results) {
+        if (result.skipped) {
+            skipped << (N_skipped > 0 ? ", " : "") << result.edge << "x" << result.edge << "x" << result.N_cloth;
+            ++N_skipped;
+        }
+    }
+    if (N_skipped > 0)
+        std::cout << N_skipped << " configuration(s) skipped with --max-vertices " << options.max_vertices << " (edge x edge x cloths): " << skipped.str() << std::endl;
+
+    std::ofstream stream(options.output);
+    if (!stream.is_open()) {
+        std::cerr << "Cannot write " << options.output << std::endl;
+        return 1;
+    }
+    write_json(stream, options, tasks.N_worker(), results);
+    std::cout << "Results written in " << options.output << std::endl;
+
+    return 0;
+}
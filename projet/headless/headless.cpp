@@ -0,0 +1,319 @@
+// Command line runner of the cloth simulation, without any window or OpenGL context.
+//  Runs the cloths of the scene for a number of steps and reports the simulation speed.
+//
+//  Usage: projet_headless [options]
+//    --steps N        number of simulation steps (frames of the interactive application), default 500
+//    --scene FILE     scene description of the cloths (format of assets/clothes.txt), default the built-in scene
+//    --samples N      number of samples per edge of each cloth, default 20
+//    --solver NAME    explicit, implicit, xpbd or projective, default explicit
+//    --wind L         wind level of the fan (0: off, 1 to 3), default 0
+//    --threads N      number of worker threads, default one per hardware thread
+//    --fixed          fixed time steps (the simulation stops at the first divergence) instead of adaptive ones
+//    --no-self-collision  disable the collisions of the cloths with themselves
+//    --no-clothesline     disable the collisions of the cloths with the wires of the clotheslines
+//    --no-cloth-collision disable the collisions between the cloths
+//    --no-sleeping    simulate the cloths at rest too
+//    --lod            levels of detail seen from the initial camera of the interactive application (1080 pixels high)
+//    --load FILE      start from the cloths of the checkpoint FILE (simulated with the options of the command line)
+//    --save FILE      write a checkpoint of the cloths and the settings in FILE at the end of the run
+//    --record FILE    record the positions of the cloths at each step in the cache FILE
+//    --play FILE      decode the frames of the cache FILE instead of simulating (with --dump: the decoded frames)
+//    --dump DIR       write the cloths as .obj files in the existing directory DIR
+//    --dump-every K   dump a frame every K steps, default 10
+
+#include "cgp_headless.hpp"
+#include "cloth/cloth.hpp"
+#include "constraint/constraint.hpp"
+#include "simulation/simulation.hpp"
+#include "scene_description/scene_description.hpp"
+#include "cloth_world/cloth_world.hpp"
+#include "task_pool/task_pool.hpp"
+#include "checkpoint/checkpoint.hpp"
+#include "cache/cache.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace cgp;
+
+
+struct headless_options
+{
+    int steps = 500;
+    std::string scene_filename;
+    int samples = 20;
+    simulation_solver solver = simulation_solver::explicit_euler;
+    int wind = 0;
+    int threads = 0;
+    bool adaptive = true;
+    bool self_collision = true;
+    bool clothesline = true;
+    bool cloth_collision = true;
+    bool sleeping = true;
+    bool lod = false;
+    std::string load_filename;
+    std::string save_filename;
+    std::string record_filename;
+    std::string play_filename;
+    std::string dump_directory;
+    int dump_every = 10;
+};
+
+static void print_usage()
+{
+    std::cout << "Usage: projet_headless [--steps N] [--scene FILE] [--samples N] [--solver explicit|implicit|xpbd|projective] [--wind 0-3]" << std::endl;
+    std::cout << "                       [--threads N] [--fixed] [--no-self-collision] [--no-clothesline]" << std::endl;
+    std::cout << "                       [--no-cloth-collision] [--no-sleeping] [--lod] [--load FILE] [--save FILE]" << std::endl;
+    std::cout << "                       [--record FILE] [--play FILE] [--dump DIR] [--dump-every K]" << std::endl;
+}
+
+static bool parse_solver(std::string const& name, simulation_solver& solver)
+{
+    if (name == "explicit") solver = simulation_solver::explicit_euler;
+    else if (name == "implicit") solver = simulation_solver::implicit_euler;
+    else if (name == "xpbd") solver = simulation_solver::xpbd;
+    else if (name == "projective") solver = simulation_solver::projective;
+    else return false;
+    return true;
+}
+
+static bool parse_options(int argc, char** argv, headless_options& options)
+{
+    for (int k = 1; k < argc; ++k)
+    {
+        std::string const arg = argv[k];
+        bool const has_value = k + 1 < argc;
+        if (arg == "--steps" && has_value) options.steps = std::atoi(argv[++k]);
+        else if (arg == "--scene" && has_value) options.scene_filename = argv[++k];
+        else if (arg == "--samples" && has_value) options.samples = std::atoi(argv[++k]);
+        else if (arg == "--solver" && has_value) {
+            if (!parse_solver(argv[++k], options.solver)) {
+                std::cerr << "Unknown solver " << argv[k] << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--wind" && has_value) options.wind = std::atoi(argv[++k]);
+        else if (arg == "--threads" && has_value) options.threads = std::atoi(argv[++k]);
+        else if (arg == "--fixed") options.adaptive = false;
+        else if (arg == "--no-self-collision") options.self_collision = false;
+        else if (arg == "--no-clothesline") options.clothesline = false;
+        else if (arg == "--no-cloth-collision") options.cloth_collision = false;
+        else if (arg == "--no-sleeping") options.sleeping = false;
+        else if (arg == "--lod") options.lod = true;
+        else if (arg == "--load" && has_value) options.load_filename = argv[++k];
+        else if (arg == "--save" && has_value) options.save_filename = argv[++k];
+        else if (arg == "--record" && has_value) options.record_filename = argv[++k];
+        else if (arg == "--play" && has_value) options.play_filename = argv[++k];
+        else if (arg == "--dump" && has_value) options.dump_directory = argv[++k];
+        else if (arg == "--dump-every" && has_value) options.dump_every = std::atoi(argv[++k]);
+        else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return false;
+        }
+    }
+
+    if (options.samples <= 3 || options.steps < 0 || options.dump_every <= 0) {
+        std::cerr << "Invalid option value (samples > 3, steps >= 0, dump-every > 0)" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Export the cloth as a triangle mesh with normals
+static bool dump_cloth(std::string const& filename, cloth_structure const& cloth)
+{
+    std::ofstream stream(filename);
+    if (!stream.is_open())
+        return false;
+
+    for (vec3 const& p : cloth.position.data)
+        stream << "v " << p.x << " " << p.y << " " << p.z << "\n";
+    for (vec3 const& n : cloth.normal.data)
+        stream << "vn " << n.x << " " << n.y << " " << n.z << "\n";
+    for (uint3 const& t : cloth.triangle_connectivity) {
+        stream << "f " << t[0] + 1 << "//" << t[0] + 1 << " " << t[1] + 1 << "//" << t[1] + 1 << " " << t[2] + 1 << "//" << t[2] + 1 << "\n";
+    }
+    return true;
+}
+
+// Export the cloths of the frame (numbered from 1) in the dump directory
+static bool dump_frame(headless_options const& options, cloth_world_structure const& world, int frame)
+{
+    for (int k = 0; k < world.size(); ++k) {
+        std::string const filename = options.dump_directory + "/frame_" + str_zero_fill(str(frame), 5) + "_" + world.descriptions[k].name + ".obj";
+        if (!dump_cloth(filename, world.cloths[k])) {
+            std::cerr << "Cannot write " << filename << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Settings of the simulation given by the command line
+static void apply_options(headless_options const& options, simulation_parameters& parameters)
+{
+    parameters.solver = options.solver;
+    parameters.adaptive.enabled = options.adaptive;
+    parameters.self_collision.enabled = options.self_collision;
+    parameters.clothesline_collision.enabled = options.clothesline;
+    parameters.cloth_collision.enabled = options.cloth_collision;
+    parameters.sleeping.enabled = options.sleeping;
+    parameters.lod.enabled = options.lod;
+    parameters.fan_position = { 0, 0, 1 };
+    parameters.wind.magnitude = scene_description_wind_magnitude(options.wind);
+    parameters.wind.source = { 0, 0, parameters.wind.initial_direction.z };
+    parameters.wind.direction = normalize(parameters.wind.initial_direction);
+}
+
+int main(int argc, char** argv)
+{
+    headless_options options;
+    if (!parse_options(argc, argv, options)) {
+        print_usage();
+        return 1;
+    }
+
+    // Scene: the cloths of the interactive application, fan at the center with a fixed orientation
+    simulation_parameters parameters;
+    apply_options(options, parameters);
+    simulation_initialize_obstacles(parameters, constraint_structure().ground_z);
+    wind_field_structure wind_field;
+    simulation_update_wind_field(wind_field, parameters);
+
+    std::vector<cloth_description> clothes = scene_description_clothes();
+    if (!options.scene_filename.empty() && !scene_description_load(options.scene_filename, clothes))
+        return 1;
+    cloth_world_structure world;
+    world.initialize(clothes, options.samples);
+    int const N_cloth = world.size();
+    std::vector<cloth_structure> const& cloths = world.cloths;
+    cloth_structure* const* cloth_pointers = world.cloth_pointers.data();
+    constraint_structure* const* constraint_pointers = world.constraint_pointers.data();
+    if (!options.load_filename.empty()) {
+        auto const time_load = std::chrono::steady_clock::now();
+        if (!simulation_checkpoint_load(options.load_filename, cloth_pointers, constraint_pointers, N_cloth, parameters))
+            return 1;
+        double const milliseconds = 1000 * std::chrono::duration<double>(std::chrono::steady_clock::now() - time_load).count();
+        std::cout << "Checkpoint " << options.load_filename << " restored in " << milliseconds << " ms" << std::endl;
+        apply_options(options, parameters);
+        simulation_update_obstacles(parameters);
+        simulation_update_wind_field(wind_field, parameters);
+    }
+    lod_view const view = { { 15, 0, 10 }, 1080 / (50 * Pi / 180) };
+
+    task_pool tasks;
+    tasks.initialize(options.threads);
+
+    std::cout << "Cloths: " << N_cloth << " x " << options.samples << "x" << options.samples << " samples, "
+        << tasks.N_worker() << " threads, vectorized kernels: " << simd_kernels().name << std::endl;
+
+    // Playback of a cache instead of the simulation
+    if (!options.play_filename.empty()) {
+        cache_player_structure player;
+        if (!player.open(options.play_filename, N_cloth))
+            return 1;
+        auto const time_start = std::chrono::steady_clock::now();
+        for (int frame = 0; frame < player.N_frame(); ++frame) {
+            if (!player.read(frame, cloth_pointers, N_cloth))
+                return 1;
+            if (!options.dump_directory.empty() && (frame + 1) % options.dump_every == 0 && !dump_frame(options, world, frame + 1))
+                return 1;
+        }
+        double const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - time_start).count();
+        std::cout << "Frames decoded: " << player.N_frame() << ", " << player.N_frame() / seconds << " frames/s" << std::endl;
+        return 0;
+    }
+
+    // Simulation (recorded in the cache after each step)
+    cache_recorder_structure cache;
+    if (!options.record_filename.empty() && !cache.open(options.record_filename, N_cloth))
+        return 1;
+    auto const time_start = std::chrono::steady_clock::now();
+    int k_step = 0;
+    long long sleeping_steps = 0; // steps skipped by the sleeping cloths
+    bool diverged = false;
+    for (; k_step < options.steps && !diverged; ++k_step)
+    {
+        // The cloths which can touch each other are advanced by the same task, then pushed apart
+        //  (the islands whose cloths are all asleep are skipped)
+        std::vector<int> switched;
+        simulation_world_lod(world, view, parameters, switched);
+        diverged = !simulation_world_advance(world, tasks, parameters, 1);
+        for (cloth_structure const& cloth : cloths)
+            sleeping_steps += cloth.sleeping.asleep ? 1 : 0;
+
+        if (cache.is_open() && !cache.append(cloth_pointers, N_cloth)) {
+            std::cerr << "Cannot write the cache " << options.record_filename << std::endl;
+            return 1;
+        }
+        if (!options.dump_directory.empty() && (k_step + 1) % options.dump_every == 0 && !dump_frame(options, world, k_step + 1))
+            return 1;
+    }
+    if (cache.is_open())
+        cache.close();
+    double const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - time_start).count();
+
+    // Report
+    int substeps = 0, rollbacks = 0, halted = 0;
+    for (cloth_structure const& cloth : cloths) {
+        substeps += cloth.stepper.step_count;
+        rollbacks += cloth.stepper.rollback_count;
+        halted += cloth.stepper.halted ? 1 : 0;
+    }
+    if (!options.adaptive)
+        substeps = (k_step * N_cloth - sleeping_steps) * simulation_steps_per_frame(parameters);
+
+    float const simulated_time = k_step * simulation_steps_per_frame(parameters) * simulation_time_step(parameters);
+    std::cout << "Steps: " << k_step << (diverged ? " (diverged)" : "") << ", simulated time: " << simulated_time << " s" << std::endl;
+    std::cout << "Wall time: " << seconds << " s, " << k_step / seconds << " steps/s, " << substeps / seconds << " cloth substeps/s" << std::endl;
+    if (options.adaptive)
+        std::cout << "Substeps: " << substeps << ", rollbacks: " << rollbacks << ", halted cloths: " << halted << std::endl;
+    if (options.self_collision) {
+        int contacts = 0;
+        for (cloth_structure const& cloth : cloths)
+            contacts += cloth.self_collision.contact_count;
+        std::cout << "Self-collision contacts (last substep): " << contacts << std::endl;
+    }
+    if (options.clothesline) {
+        int contacts = 0;
+        for (cloth_structure const& cloth : cloths)
+            contacts += cloth.clothesline.contact_count;
+        std::cout << "Clothesline contacts (last substep): " << contacts << std::endl;
+    }
+    if (options.cloth_collision) {
+        int contacts = 0;
+        for (cloth_structure const& cloth : cloths)
+            contacts += cloth.cloth_collision.contact_count;
+        std::cout << "Cloth-cloth contacts (last step): " << contacts / 2 << ", islands: " << world.islands.N_island() << std::endl;
+    }
+    if (options.sleeping) {
+        std::cout << "Sleeping cloths (last step): " << simulation_world_asleep(world) << ", skipped cloth steps: " << 100.0 * sleeping_steps / std::max(1, k_step * N_cloth) << "%" << std::endl;
+    }
+
+    if (options.lod) {
+        int switches = 0;
+        std::cout << "Levels of detail (samples per edge):";
+        for (int k = 0; k < N_cloth; ++k) {
+            std::cout << " " << world.descriptions[k].name << ":" << cloths[k].N_samples_x();
+            switches += cloths[k].lod.switch_count;
+        }
+        std::cout << ", switches: " << switches << std::endl;
+    }
+
+    if (!options.record_filename.empty()) {
+        std::cout << "Cache: " << cache.N_frame() << " frames, " << cache.written_size / 1024 << " KiB (" << 100.0 * cache.written_size / std::max<uint64_t>(1, cache.raw_size)
+            << "% of the positions as floats)" << std::endl;
+    }
+    if (!options.save_filename.empty()) {
+        if (!simulation_checkpoint_save(options.save_filename, cloth_pointers, constraint_pointers, N_cloth, parameters))
+            return 1;
+        std::cout << "Checkpoint written in " << options.save_filename << std::endl;
+    }
+
+    return diverged ? 2 : 0;
+}
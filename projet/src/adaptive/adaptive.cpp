@@ -0,0 +1,137 @@
+#include "adaptive.hpp"
+
+#include "../simulation/simulation.hpp"
+
+#include <cmath>
+
+using namespace cgp;
+
+
+float simulation_stable_time_step(cloth_structure const& cloth)
+{
+    // Springs: the largest eigenvalue of the stiffness matrix is bounded by twice the sum of the stiffnesses around
+    //  a vertex (Gershgorin), and the semi-implicit Euler step is stable for dt < 2/omega_max = sqrt(4m/lambda_max).
+    int const max_degree = 12; // structural, shear and bending springs of an interior vertex
+    float const m = cloth.mass_total / cloth.position.size();
+    float const lambda_max = 2.0f * max_degree * cloth.K;
+    float const dt_spring = std::sqrt(4.0f * m / lambda_max);
+
+    // Drag (dv/dt = -mu v): stable for dt < 2/mu
+    float const dt_drag = 2.0f / cloth.mu;
+
+    return std::min(dt_spring, dt_drag);
+}
+
+void simulation_adaptive_measure(cloth_structure& cloth, vec3 const* start)
+{
+    adaptive_stepper_structure& stepper = cloth.stepper;
+    if (!stepper.measuring)
+        return;
+    float displacement2_max = stepper.displacement2_max;
+    size_t const N = cloth.position.size();
+    for (size_t k = 0; k < N; ++k) {
+        vec3 const d = cloth.position.data.at_unsafe(k) - start[k];
+        displacement2_max = std::max(displacement2_max, dot(d, d));
+    }
+    stepper.displacement2_max = displacement2_max;
+}
+
+// Largest displacement of a vertex during a substep
+static float displacement_bound(cloth_structure const& cloth, adaptive_parameters const& adaptive)
+{
+    float const L0 = std::min(cloth.lenght_x / (cloth.N_samples_x() - 1.0f), cloth.lenght_y / (cloth.N_samples_y() - 1.0f));
+    return adaptive.displacement_max * L0;
+}
+
+// Check the state after a substep: no NaN, no force spike and no vertex moved too far by the solver
+static bool valid_step(cloth_structure const& cloth, adaptive_stepper_structure const& stepper, adaptive_parameters const& adaptive)
+{
+    float const displacement_max = displacement_bound(cloth, adaptive);
+    float const force_max = adaptive.force_max;
+    if (!(stepper.displacement2_max <= displacement_max * displacement_max))
+        return false;
+
+    size_t const N = cloth.position.size();
+    for (size_t k = 0; k < N; ++k)
+    {
+        vec3 const& p = cloth.position.data.at_unsafe(k);
+        vec3 const& v = cloth.velocity.data.at_unsafe(k);
+        vec3 const& f = cloth.force.data.at_unsafe(k);
+        if (!std::isfinite(p.x + p.y + p.z) || !std::isfinite(v.x + v.y + v.z))
+            return false;
+        if (!(dot(f, f) <= force_max * force_max))
+            return false;
+    }
+    return true;
+}
+
+bool simulation_adaptive_step(cloth_structure& cloth, constraint_structure const& constraint, simulation_parameters const& parameters, float frame_dt)
+{
+    adaptive_stepper_structure& stepper = cloth.stepper;
+    adaptive_parameters const& adaptive = parameters.adaptive;
+    if (stepper.halted)
+        return false;
+
+    // Bounds of the substep: the time step of the solver is the largest one, limited by the stability estimation
+    //  for the explicit integrator (the other solvers are stable with large steps)
+    float const dt_nominal = simulation_time_step(parameters);
+    float dt_max = dt_nominal;
+    if (parameters.solver == simulation_solver::explicit_euler)
+        dt_max = std::min(dt_max, adaptive.cfl * simulation_stable_time_step(cloth));
+    float const dt_min = adaptive.min_step_ratio * dt_nominal;
+
+    // The projective solver factorizes its system for each time step: its substeps are powers of two fractions of the
+    //  nominal step, so that the factorization is only rebuilt when the substep changes of level. They grow by doubling
+    //  instead of adaptive.growth, which would leave the powers of two and refactorize at each growth.
+    bool const quantized = parameters.solver == simulation_solver::projective;
+
+    if (stepper.dt <= 0.0f || stepper.dt > dt_max)
+        stepper.dt = dt_max;
+
+    float t = 0.0f;
+    while (frame_dt - t > 1e-6f * frame_dt)
+    {
+        float h = std::min(stepper.dt, frame_dt - t);
+        if (quantized) {
+            h = stepper.dt;
+            while (h > frame_dt - t + 1e-6f * frame_dt && h > dt_min)
+                h *= 0.5f;
+        }
+
+        stepper.saved_position = cloth.position.data;
+        stepper.saved_velocity = cloth.velocity.data;
+
+        stepper.measuring = true;
+        stepper.displacement2_max = 0.0f;
+        simulation_step(cloth, constraint, parameters, h);
+        stepper.measuring = false;
+        stepper.step_count++;
+
+        if (valid_step(cloth, stepper, adaptive))
+        {
+            t += h;
+            stepper.stable_steps++;
+            if (stepper.stable_steps >= adaptive.stable_steps_before_growth && stepper.dt < dt_max) {
+                stepper.dt = std::min((quantized ? 2.0f : adaptive.growth) * stepper.dt, dt_max);
+                stepper.stable_steps = 0;
+            }
+            continue;
+        }
+
+        // Rollback and retry with half the substep (the bounding box starts the sweep of the wires of the retry)
+        cloth.position.data = stepper.saved_position;
+        cloth.velocity.data = stepper.saved_velocity;
+        cloth.update_bounding_box();
+        stepper.rollback_count++;
+        stepper.stable_steps = 0;
+        if (0.5f * stepper.dt < dt_min)
+        {
+            std::cout << "\n *** Simulation of a cloth has diverged even with a time step of " << stepper.dt << " ***" << std::endl;
+            std::cout << " > The simulation of this cloth is stoped" << std::endl;
+            stepper.halted = true;
+            return false;
+        }
+        stepper.dt *= 0.5f;
+    }
+    return true;
+}
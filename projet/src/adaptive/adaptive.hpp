@@ -0,0 +1,55 @@
+#pragma once
+
+#include "../cgp_headless.hpp"
+
+struct cloth_structure;
+struct constraint_structure;
+struct simulation_parameters;
+
+
+// Settings of the adaptive time stepping
+struct adaptive_parameters
+{
+    bool enabled = true;
+    float cfl = 0.9f;                    // safety factor on the stability limit of the explicit integrator
+    float min_step_ratio = 1.0f / 64.0f; // smallest substep, relative to the nominal time step of the solver
+    float growth = 1.5f;                 // growth of the substep after a series of stable substeps
+    int stable_steps_before_growth = 8;  // number of stable substeps before increasing the substep
+    float force_max = 600.0f;            // force magnitude considered as a spike
+    float displacement_max = 0.5f;       // maximal displacement of a vertex during a substep, relative to the rest length
+};
+
+// State of the adaptive time stepping of one cloth
+struct adaptive_stepper_structure
+{
+    float dt = 0.0f;       // current substep (0: not estimated yet)
+    int stable_steps = 0;  // number of stable substeps since the last change of dt
+    bool halted = false;   // the cloth could not be advanced even with the smallest substep
+
+    // State at the beginning of the current substep, restored on rollback
+    cgp::numarray<cgp::vec3> saved_position;
+    cgp::numarray<cgp::vec3> saved_velocity;
+
+    // Largest squared displacement of a vertex by the solver during the current substep, measured before the
+    //  projections of the collisions (they do not depend on the time step: halving it would not reduce them)
+    bool measuring = false;
+    float displacement2_max = 0.0f;
+
+    // Counters since the initialization of the cloth
+    int step_count = 0;     // substeps computed (including the rejected ones)
+    int rollback_count = 0; // rejected substeps
+};
+
+
+// Advance the cloth by the duration frame_dt using substeps adapted to the stability of the cloth.
+//  A substep producing NaN, a force spike or a too large displacement (before the collisions) is rolled back and retried
+//  with half the step.
+//  Returns false if the cloth is halted (the smallest substep still fails): the other cloths are not affected.
+bool simulation_adaptive_step(cloth_structure& cloth, constraint_structure const& constraint, simulation_parameters const& parameters, float frame_dt);
+
+// Measure the displacement of the vertices from the positions start (beginning of the step or of the substep of the
+//  solver) before the collision projections, during a substep of the adaptive time stepping
+void simulation_adaptive_measure(cloth_structure& cloth, cgp::vec3 const* start);
+
+// Estimation of the largest stable time step of the explicit integrator for this cloth
+float simulation_stable_time_step(cloth_structure const& cloth);
@@ -0,0 +1,461 @@
+#include "cache.hpp"
+
+#include "../cloth/cloth.hpp"
+#include "../sleeping/sleeping.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+
+using namespace cgp;
+
+
+// Layout of the file: header, frames, index, trailer
+// ********************************************** //
+
+static char const cache_magic[8] = { 'A', 'N', 'I', '3', 'D', 'C', 'C', 'H' };
+static char const cache_index_magic[4] = { 'C', 'I', 'D', 'X' };
+
+struct cache_header
+{
+    char magic[8];
+    int32_t version;
+    int32_t N_cloth;
+    int32_t normals;
+    int32_t keyframe_interval;
+};
+
+// Each frame starts with a marker (found again by the scan of a recording without index), its size (header included)
+//  and its kind. A cloth of a keyframe starts with its grid and box.
+static uint32_t const cache_frame_marker = 0x4d415246; // "FRAM"
+struct cache_frame_header
+{
+    uint32_t marker;
+    uint32_t size;
+    uint32_t keyframe;
+};
+struct cache_keyframe_cloth
+{
+    int32_t N_x;
+    int32_t N_y;
+    float box[6];
+};
+
+// Index: offset and keyframe of each frame, then the trailer at the very end of the file
+struct cache_index_entry
+{
+    uint64_t offset;
+    int32_t keyframe;
+    int32_t padding;
+};
+struct cache_trailer
+{
+    uint64_t index_offset;
+    int32_t N_frame;
+    char magic[4];
+};
+
+// Margin around the bounding box of a cloth at a keyframe: relative to its size, and absolute (m)
+static float const box_margin_relative = 0.5f;
+static float const box_margin = 0.5f;
+
+
+// Quantization and encoding of the values
+// ********************************************** //
+
+static uint16_t quantize(float x, float x_min, float x_max)
+{
+    float const t = (x - x_min) / (x_max - x_min);
+    return uint16_t(std::lround(std::min(std::max(t, 0.0f), 1.0f) * 65535.0f));
+}
+static float dequantize(uint16_t q, float x_min, float x_max)
+{
+    return x_min + (x_max - x_min) * (q / 65535.0f);
+}
+
+static void put_varint(std::vector<char>& out, uint32_t v)
+{
+    while (v >= 0x80) {
+        out.push_back(char((v & 0x7f) | 0x80));
+        v >>= 7;
+    }
+    out.push_back(char(v));
+}
+static bool get_varint(unsigned char const*& p, unsigned char const* end, uint32_t& v)
+{
+    v = 0;
+    for (int shift = 0; shift < 35 && p < end; shift += 7) {
+        unsigned char const byte = *p++;
+        v |= uint32_t(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+// Differences with the reference (previous frame), or with the same coordinate of the previous vertex (keyframe), as
+//  zigzag varints (small magnitudes of both signs on few bits). A run of null differences (sleeping or pinned parts)
+//  is a 0 followed by the length of the run.
+static void encode(std::vector<char>& out, std::vector<uint16_t> const& q, std::vector<uint16_t> const* reference)
+{
+    auto difference = [&](size_t i) { return int32_t(q[i]) - (reference != nullptr ? (*reference)[i] : (i >= 3 ? q[i - 3] : 0)); };
+    for (size_t i = 0; i < q.size(); ++i) {
+        int32_t const d = difference(i);
+        put_varint(out, uint32_t((d << 1) ^ (d >> 31)));
+        if (d == 0) {
+            size_t run = 1;
+            while (i + run < q.size() && difference(i + run) == 0)
+                run++;
+            put_varint(out, uint32_t(run - 1));
+            i += run - 1;
+        }
+    }
+}
+static bool decode_values(unsigned char const*& p, unsigned char const* end, std::vector<uint16_t>& q, bool keyframe)
+{
+    auto predicted = [&](size_t i) { return !keyframe ? int32_t(q[i]) : (i >= 3 ? int32_t(q[i - 3]) : 0); };
+    for (size_t i = 0; i < q.size(); ++i) {
+        uint32_t z;
+        if (!get_varint(p, end, z))
+            return false;
+        int32_t const d = int32_t(z >> 1) ^ -int32_t(z & 1);
+        if (d != 0) {
+            q[i] = uint16_t(predicted(i) + d);
+            continue;
+        }
+        uint32_t run;
+        if (!get_varint(p, end, run) || run >= q.size() - i)
+            return false;
+        for (size_t j = i; j <= i + run; ++j)
+            q[j] = uint16_t(predicted(j));
+        i += run;
+    }
+    return true;
+}
+
+template <typename T>
+static void put(std::vector<char>& out, T const& value)
+{
+    char const* bytes = reinterpret_cast<char const*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+template <typename T>
+static bool get(unsigned char const*& p, unsigned char const* end, T& value)
+{
+    if (size_t(end - p) < sizeof(T))
+        return false;
+    std::memcpy(&value, p, sizeof(T));
+    p += sizeof(T);
+    return true;
+}
+
+
+// Recorder
+// ********************************************** //
+
+bool cache_recorder_structure::open(std::string const& filename, int N_cloth)
+{
+    if (file.is_open())
+        close();
+    file.open(filename, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cout << "Cannot write the cache " << filename << std::endl;
+        return false;
+    }
+
+    cache_header header;
+    std::memcpy(header.magic, cache_magic, sizeof(header.magic));
+    header.version = cache_version;
+    header.N_cloth = N_cloth;
+    header.normals = normals ? 1 : 0;
+    header.keyframe_interval = keyframe_interval;
+    file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+
+    state.assign(N_cloth, cache_cloth_state());
+    frame_offset.clear();
+    frame_keyframe.clear();
+    raw_size = 0;
+    written_size = 0;
+    return bool(file);
+}
+
+bool cache_recorder_structure::append(cloth_structure const* const* cloths, int N_cloth)
+{
+    assert_cgp(file.is_open() && N_cloth == int(state.size()), "The cache must be opened for these cloths");
+
+    // Keyframe at the interval, or if a cloth changed its grid or left its box (the box of the integration does not
+    //  include the last corrections of the constraints)
+    int const frame = N_frame();
+    bool keyframe = frame == 0 || frame - frame_keyframe.back() >= keyframe_interval;
+    box_min.resize(N_cloth);
+    box_max.resize(N_cloth);
+    for (int k = 0; k < N_cloth; ++k) {
+        cloth_structure const& cloth = *cloths[k];
+        cache_cloth_state const& s = state[k];
+        cloth.bounding_box(0, cloth.position.size(), box_min[k], box_max[k]);
+        keyframe = keyframe || cloth.N_samples_x() != s.N_x || cloth.N_samples_y() != s.N_y
+            || box_min[k].x < s.box_min.x || box_min[k].y < s.box_min.y || box_min[k].z < s.box_min.z
+            || box_max[k].x > s.box_max.x || box_max[k].y > s.box_max.y || box_max[k].z > s.box_max.z;
+    }
+
+    buffer.clear();
+    put(buffer, cache_frame_header{ cache_frame_marker, 0, keyframe ? 1u : 0u });
+    std::vector<uint16_t> q;
+    for (int k = 0; k < N_cloth; ++k) {
+        cloth_structure const& cloth = *cloths[k];
+        cache_cloth_state& s = state[k];
+        size_t const N = cloth.position.size();
+
+        if (keyframe) {
+            vec3 const margin = box_margin_relative * (box_max[k] - box_min[k]) + vec3(box_margin, box_margin, box_margin);
+            s.N_x = cloth.N_samples_x();
+            s.N_y = cloth.N_samples_y();
+            s.box_min = box_min[k] - margin;
+            s.box_max = box_max[k] + margin;
+            put(buffer, cache_keyframe_cloth{ s.N_x, s.N_y, { s.box_min.x, s.box_min.y, s.box_min.z, s.box_max.x, s.box_max.y, s.box_max.z } });
+        }
+
+        q.resize(3 * N);
+        for (size_t i = 0; i < N; ++i) {
+            vec3 const& p = cloth.position.data[i];
+            q[3 * i + 0] = quantize(p.x, s.box_min.x, s.box_max.x);
+            q[3 * i + 1] = quantize(p.y, s.box_min.y, s.box_max.y);
+            q[3 * i + 2] = quantize(p.z, s.box_min.z, s.box_max.z);
+        }
+        encode(buffer, q, keyframe ? nullptr : &s.position);
+        s.position.swap(q);
+
+        if (normals) {
+            q.resize(3 * N);
+            for (size_t i = 0; i < N; ++i) {
+                vec3 const& n = cloth.normal.data[i];
+                q[3 * i + 0] = quantize(n.x, -1, 1);
+                q[3 * i + 1] = quantize(n.y, -1, 1);
+                q[3 * i + 2] = quantize(n.z, -1, 1);
+            }
+            encode(buffer, q, keyframe ? nullptr : &s.normal);
+            s.normal.swap(q);
+        }
+        raw_size += (normals ? 2 : 1) * N * sizeof(vec3);
+    }
+
+    uint32_t const size = uint32_t(buffer.size());
+    std::memcpy(buffer.data() + offsetof(cache_frame_header, size), &size, sizeof(size));
+    frame_offset.push_back(uint64_t(file.tellp()));
+    frame_keyframe.push_back(keyframe ? frame : frame_keyframe.back());
+    file.write(buffer.data(), buffer.size());
+    written_size += buffer.size();
+    return bool(file);
+}
+
+bool cache_recorder_structure::close()
+{
+    if (!file.is_open())
+        return false;
+
+    cache_trailer trailer;
+    trailer.index_offset = uint64_t(file.tellp());
+    trailer.N_frame = N_frame();
+    std::memcpy(trailer.magic, cache_index_magic, sizeof(trailer.magic));
+    for (int frame = 0; frame < N_frame(); ++frame) {
+        cache_index_entry const entry = { frame_offset[frame], frame_keyframe[frame], 0 };
+        file.write(reinterpret_cast<char const*>(&entry), sizeof(entry));
+    }
+    file.write(reinterpret_cast<char const*>(&trailer), sizeof(trailer));
+
+    bool const success = bool(file);
+    file.close();
+    return success;
+}
+
+
+// Player
+// ********************************************** //
+
+// Check the index read at the end of the file: increasing offsets of whole frame headers between the header of the file
+//  and the index, and each frame decoded from a keyframe at or before it
+static bool valid_index(std::vector<cache_index_entry> const& index, uint64_t index_offset)
+{
+    for (size_t k = 0; k < index.size(); ++k) {
+        cache_index_entry const& entry = index[k];
+        uint64_t const offset_min = k == 0 ? sizeof(cache_header) : index[k - 1].offset + sizeof(cache_frame_header);
+        if (entry.offset < offset_min || entry.offset + sizeof(cache_frame_header) > index_offset)
+            return false;
+        if (entry.keyframe < 0 || size_t(entry.keyframe) > k || index[entry.keyframe].keyframe != entry.keyframe)
+            return false;
+    }
+    return true;
+}
+
+bool cache_player_structure::open(std::string const& filename, int N_cloth)
+{
+    close();
+    file.open(filename, std::ios::binary);
+    cache_header header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || std::memcmp(header.magic, cache_magic, sizeof(header.magic)) != 0
+        || header.version != cache_version || header.N_cloth != N_cloth) {
+        std::cout << "Cannot read the cache " << filename << " (missing, another version or another number of cloths)" << std::endl;
+        close();
+        return false;
+    }
+    normals = header.normals != 0;
+    state.assign(N_cloth, cache_cloth_state());
+
+    // Index at the end of the file, or rebuilt from the sizes of the frames
+    file.seekg(0, std::ios::end);
+    uint64_t const file_size = uint64_t(file.tellg());
+    cache_trailer trailer;
+    bool indexed = false;
+    if (file_size >= sizeof(header) + sizeof(trailer)) {
+        file.seekg(file_size - sizeof(trailer));
+        file.read(reinterpret_cast<char*>(&trailer), sizeof(trailer));
+        indexed = std::memcmp(trailer.magic, cache_index_magic, sizeof(trailer.magic)) == 0 && trailer.N_frame >= 0
+            && trailer.index_offset + uint64_t(trailer.N_frame) * sizeof(cache_index_entry) + sizeof(trailer) == file_size;
+    }
+    if (indexed) {
+        std::vector<cache_index_entry> index(trailer.N_frame);
+        file.seekg(trailer.index_offset);
+        if (!file.read(reinterpret_cast<char*>(index.data()), index.size() * sizeof(cache_index_entry)) || !valid_index(index, trailer.index_offset)) {
+            std::cout << "Cannot read the cache " << filename << " (invalid index)" << std::endl;
+            close();
+            return false;
+        }
+        for (cache_index_entry const& entry : index) {
+            frame_offset.push_back(entry.offset);
+            frame_keyframe.push_back(entry.keyframe);
+        }
+        frame_offset.push_back(trailer.index_offset);
+    }
+    else {
+        uint64_t offset = sizeof(header);
+        cache_frame_header frame_header;
+        file.clear();
+        while (offset + sizeof(frame_header) <= file_size) {
+            file.seekg(offset);
+            if (!file.read(reinterpret_cast<char*>(&frame_header), sizeof(frame_header)) || frame_header.marker != cache_frame_marker
+                || frame_header.size < sizeof(frame_header) || offset + frame_header.size > file_size)
+                break;
+            frame_keyframe.push_back(frame_header.keyframe ? N_frame() : (frame_keyframe.empty() ? -1 : frame_keyframe.back()));
+            frame_offset.push_back(offset);
+            offset += frame_header.size;
+        }
+        frame_offset.push_back(offset);
+    }
+    file.clear();
+    if (N_frame() > 0 && frame_keyframe[0] != 0) {
+        std::cout << "Cannot read the cache " << filename << " (no keyframe)" << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void cache_player_structure::close()
+{
+    if (file.is_open())
+        file.close();
+    file.clear();
+    frame_offset.clear();
+    frame_keyframe.clear();
+    state.clear();
+    decoded = -1;
+    chunk.clear();
+    chunk_begin = chunk_end = 0;
+}
+
+bool cache_player_structure::read(int frame, cloth_structure* const* cloths, int N_cloth)
+{
+    if (!file.is_open() || frame < 0 || frame >= N_frame() || N_cloth != int(state.size()))
+        return false;
+
+    // Decode from the keyframe, unless the previous frame is the last decoded one
+    int const start = (decoded >= frame_keyframe[frame] && decoded < frame) ? decoded + 1 : frame_keyframe[frame];
+    for (int f = start; f < frame; ++f) {
+        if (!decode(f, cloths, N_cloth, false))
+            return false;
+    }
+    return decode(frame, cloths, N_cloth, true);
+}
+
+bool cache_player_structure::decode(int frame, cloth_structure* const* cloths, int N_cloth, bool output)
+{
+    // Read ahead the encoded frames from this one (a single read of consecutive frames)
+    if (frame < chunk_begin || frame >= chunk_end) {
+        chunk_begin = frame;
+        chunk_end = std::min(frame + std::max(1, read_ahead), N_frame());
+        chunk.resize(frame_offset[chunk_end] - frame_offset[chunk_begin]);
+        file.seekg(frame_offset[chunk_begin]);
+        if (!file.read(chunk.data(), chunk.size())) {
+            file.clear();
+            chunk_begin = chunk_end = 0;
+            decoded = -1;
+            return false;
+        }
+    }
+    unsigned char const* p = reinterpret_cast<unsigned char const*>(chunk.data()) + (frame_offset[frame] - frame_offset[chunk_begin]);
+    unsigned char const* const end = p + (frame_offset[frame + 1] - frame_offset[frame]);
+
+    cache_frame_header frame_header;
+    bool valid = get(p, end, frame_header) && frame_header.marker == cache_frame_marker;
+    bool const keyframe = frame_header.keyframe != 0;
+    valid = valid && (keyframe || decoded == frame - 1);
+    for (int k = 0; k < N_cloth && valid; ++k) {
+        cache_cloth_state& s = state[k];
+        if (keyframe) {
+            cache_keyframe_cloth c;
+            valid = get(p, end, c) && c.N_x > 3 && c.N_x == c.N_y;
+            if (!valid)
+                break;
+            s.N_x = c.N_x;
+            s.N_y = c.N_y;
+            s.box_min = { c.box[0], c.box[1], c.box[2] };
+            s.box_max = { c.box[3], c.box[4], c.box[5] };
+            s.position.assign(3 * size_t(s.N_x) * s.N_y, 0);
+            s.normal.assign(normals ? s.position.size() : 0, 0);
+        }
+        valid = decode_values(p, end, s.position, keyframe) && (!normals || decode_values(p, end, s.normal, keyframe));
+    }
+    if (!valid) {
+        std::cout << "Invalid frame " << frame << " in the cache" << std::endl;
+        decoded = -1;
+        return false;
+    }
+    decoded = frame;
+    if (!output)
+        return true;
+
+    // State of the cloths
+    for (int k = 0; k < N_cloth; ++k) {
+        cloth_structure& cloth = *cloths[k];
+        cache_cloth_state const& s = state[k];
+        if (cloth.N_samples_x() != s.N_x || cloth.N_samples_y() != s.N_y) {
+            if (cloth.lod.corners.size() != 4)
+                return false;
+            cloth.initialize(s.N_x, cloth.lod.corners, cloth.lenght_x, cloth.lenght_y);
+        }
+        simulation_sleeping_wake_up(cloth); // displayed again
+
+        size_t const N = cloth.position.size();
+        for (size_t i = 0; i < N; ++i) {
+            cloth.position.data[i] = { dequantize(s.position[3 * i + 0], s.box_min.x, s.box_max.x),
+                                       dequantize(s.position[3 * i + 1], s.box_min.y, s.box_max.y),
+                                       dequantize(s.position[3 * i + 2], s.box_min.z, s.box_max.z) };
+            cloth.velocity.data[i] = { 0, 0, 0 };
+        }
+        if (normals) {
+            for (size_t i = 0; i < N; ++i) {
+                vec3 const n = { dequantize(s.normal[3 * i + 0], -1, 1), dequantize(s.normal[3 * i + 1], -1, 1), dequantize(s.normal[3 * i + 2], -1, 1) };
+                float const n_norm = norm(n);
+                cloth.normal.data[i] = n_norm > 1e-6f ? n / n_norm : vec3(0, 0, 1);
+            }
+        }
+        else
+            cloth.update_normal();
+        cloth.update_bounding_box();
+        cloth.previous_position.clear();
+        cloth.previous_normal.clear();
+    }
+    return true;
+}
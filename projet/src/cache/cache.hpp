@@ -0,0 +1,89 @@
+#pragma once
+
+#include "../cgp_headless.hpp"
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+struct cloth_structure;
+
+
+// Cache of the frames of a simulation, recorded as a stream and played back without simulating.
+//  Each frame stores the positions (and optionally the normals) of every cloth quantized on 16 bits: the positions in
+//  the bounding box of the cloth at the last keyframe (inflated by a margin), the normals in [-1,1]. A keyframe encodes
+//  each value as the difference with the same coordinate of the previous vertex, the other frames as the difference
+//  with the previous frame, both as zigzag varints (1 byte for a small motion, runs of unchanged values coded once). A
+//  keyframe is written every keyframe_interval frames, and as soon as a cloth leaves its box or changes its grid.
+//  The end of the file is an index of the offsets of the frames and of their keyframe: a frame is reached by decoding at
+//  most keyframe_interval frames. The index of a recording which was not closed is rebuilt by scanning the frames.
+int const cache_version = 1;
+
+// Quantized state of the cloths at the last frame (shared by the encoder and the decoder)
+struct cache_cloth_state
+{
+    int N_x = 0;
+    int N_y = 0;
+    cgp::vec3 box_min;
+    cgp::vec3 box_max;
+    std::vector<uint16_t> position;
+    std::vector<uint16_t> normal;
+};
+
+struct cache_recorder_structure
+{
+    int keyframe_interval = 30;
+    bool normals = false; // record the normals (recomputed from the positions at playback otherwise)
+
+    // Create the file for N_cloth cloths (replaces an existing file)
+    bool open(std::string const& filename, int N_cloth);
+    // Append the current state of the cloths
+    bool append(cloth_structure const* const* cloths, int N_cloth);
+    // Write the index at the end of the file and close it
+    bool close();
+
+    bool is_open() const { return file.is_open(); }
+    int N_frame() const { return int(frame_offset.size()); }
+    uint64_t raw_size = 0;     // size of the recorded positions and normals as floats
+    uint64_t written_size = 0; // size of the encoded frames
+
+private:
+    std::ofstream file;
+    std::vector<cache_cloth_state> state;
+    std::vector<uint64_t> frame_offset;
+    std::vector<int> frame_keyframe;
+    std::vector<char> buffer; // encoded frame
+    std::vector<cgp::vec3> box_min; // bounding boxes of the cloths at this frame
+    std::vector<cgp::vec3> box_max;
+};
+
+struct cache_player_structure
+{
+    int read_ahead = 16; // number of frames read from the file at once (bound of the memory of the encoded frames)
+
+    // Open a cache of N_cloth cloths and read its index
+    bool open(std::string const& filename, int N_cloth);
+    void close();
+    bool is_open() const { return file.is_open(); }
+    int N_frame() const { return int(frame_keyframe.size()); }
+
+    // Decode the frame into the cloths (initialized from their description: a cloth recorded with another grid is
+    //  rebuilt on it). Consecutive frames decode a single frame, other ones start from their keyframe.
+    bool read(int frame, cloth_structure* const* cloths, int N_cloth);
+
+private:
+    std::ifstream file;
+    bool normals = false;
+    std::vector<uint64_t> frame_offset; // one more entry: end of the last frame
+    std::vector<int> frame_keyframe;
+    std::vector<cache_cloth_state> state;
+    int decoded = -1; // last frame decoded in the state
+
+    // Encoded frames [chunk_begin, chunk_end) read ahead
+    std::vector<char> chunk;
+    int chunk_begin = 0;
+    int chunk_end = 0;
+
+    bool decode(int frame, cloth_structure* const* cloths, int N_cloth, bool output);
+};
@@ -0,0 +1,13 @@
+#pragma once
+
+// Part of the CGP library used by the simulation: containers, vectors/matrices and mesh structures.
+//  It does not include the graphics part (OpenGL, GLFW, drawables) so that the simulation can be compiled in the
+//  headless library (see CMakeLists.txt). Code that displays something includes "cgp/cgp.hpp" instead.
+
+#include "cgp/cgp_parameters.hpp"
+#include "cgp/core/core.hpp"
+#include "cgp/geometry/vec/vec.hpp"
+#include "cgp/geometry/mat/mat.hpp"
+#include "cgp/geometry/transform/transform.hpp"
+#include "cgp/geometry/shape/mesh/structure/mesh.hpp"
+#include "cgp/geometry/shape/mesh/primitive/mesh_primitive.hpp"
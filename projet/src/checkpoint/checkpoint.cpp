@@ -0,0 +1,395 @@
+#include "checkpoint.hpp"
+
+#include "../cloth/cloth.hpp"
+#include "../constraint/constraint.hpp"
+#include "../simulation/simulation.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <type_traits>
+#include <vector>
+
+#ifdef _WIN32
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace cgp;
+
+
+// Layout of the file
+// ********************************************** //
+
+static char const checkpoint_magic[8] = { 'A', 'N', 'I', '3', 'D', 'C', 'K', 'P' };
+
+struct checkpoint_header
+{
+    char magic[8];
+    int32_t version;
+    int32_t N_cloth;
+    uint64_t size;           // size of the whole file
+    int32_t settings_size;   // sizeof(checkpoint_settings) and sizeof(checkpoint_cloth) of the writer
+    int32_t cloth_size;
+};
+
+// Settings of the simulation (without the obstacles and the wind field, rebuilt by the application)
+struct checkpoint_settings
+{
+    float dt;
+    simulation_solver solver;
+    implicit_parameters implicit;
+    xpbd_parameters xpbd;
+    projective_parameters projective;
+    adaptive_parameters adaptive;
+    self_collision_parameters self_collision;
+    clothesline_parameters clothesline_collision;
+    cloth_collision_parameters cloth_collision;
+    sleeping_parameters sleeping;
+    lod_parameters lod;
+    vec3 fan_position;
+    float wind_magnitude;
+    vec3 wind_direction;
+    vec3 wind_source;
+    float wind_aperture;
+    float air_density;
+    float drag_coefficient;
+    float lift_coefficient;
+};
+
+// Record of a cloth. Its buffers start at offset: position, velocity and normal (N_x N_y vec3 each), previous position
+//  and normal if has_previous, the fixed positions (N_fixed position_contraint), then the pins of the level of detail
+//  (N_lod_pin vec2 then N_lod_pin vec3).
+struct checkpoint_cloth
+{
+    int32_t N_x;
+    int32_t N_y;
+    float lenght_x;
+    float lenght_y;
+    float mass_total;
+    float K;
+    float mu;
+    float ground_z;
+    float stepper_dt;
+    int32_t stepper_stable_steps;
+    int32_t halted;
+    int32_t has_previous;
+    int32_t N_fixed;
+    int32_t lod_N_sample_finest;
+    int32_t lod_level;
+    int32_t N_lod_pin;
+    uint64_t offset;
+};
+
+static_assert(std::is_trivially_copyable<checkpoint_settings>::value, "The settings are copied as raw memory");
+static_assert(std::is_trivially_copyable<position_contraint>::value, "The fixed positions are copied as raw memory");
+static_assert(sizeof(vec3) == 3 * sizeof(float) && sizeof(vec2) == 2 * sizeof(float), "The buffers are copied as raw memory");
+
+static size_t align8(size_t size)
+{
+    return (size + 7) & ~size_t(7);
+}
+
+static size_t cloth_data_size(checkpoint_cloth const& record)
+{
+    size_t const N = size_t(record.N_x) * record.N_y;
+    return align8((record.has_previous ? 5 : 3) * N * sizeof(vec3) + record.N_fixed * sizeof(position_contraint)
+        + record.N_lod_pin * (sizeof(vec2) + sizeof(vec3)));
+}
+
+// Copy of count elements at the cursor, which is moved after them
+template <typename T>
+static void write(char*& cursor, T const* value, size_t count)
+{
+    if (count > 0)
+        std::memcpy(cursor, value, count * sizeof(T));
+    cursor += count * sizeof(T);
+}
+template <typename T>
+static void read(char const*& cursor, T* value, size_t count)
+{
+    if (count > 0)
+        std::memcpy(value, cursor, count * sizeof(T));
+    cursor += count * sizeof(T);
+}
+
+
+// Read-only mapping of a whole file (read in memory where mmap is not available)
+// ********************************************** //
+
+struct checkpoint_mapping
+{
+    char const* data = nullptr;
+    size_t size = 0;
+
+    bool open(std::string const& filename)
+    {
+#ifdef _WIN32
+        std::ifstream file(filename, std::ios::binary);
+        if (!file)
+            return false;
+        buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        data = buffer.data();
+        size = buffer.size();
+        return true;
+#else
+        int const descriptor = ::open(filename.c_str(), O_RDONLY);
+        if (descriptor < 0)
+            return false;
+        struct stat status;
+        if (fstat(descriptor, &status) != 0 || status.st_size <= 0) {
+            ::close(descriptor);
+            return false;
+        }
+        void* const address = mmap(nullptr, size_t(status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+        ::close(descriptor); // the mapping keeps the file
+        if (address == MAP_FAILED)
+            return false;
+        data = static_cast<char const*>(address);
+        size = size_t(status.st_size);
+        return true;
+#endif
+    }
+
+    ~checkpoint_mapping()
+    {
+#ifndef _WIN32
+        if (data != nullptr)
+            munmap(const_cast<char*>(data), size);
+#endif
+    }
+
+private:
+#ifdef _WIN32
+    std::vector<char> buffer;
+#endif
+};
+
+
+// Save and restore
+// ********************************************** //
+
+bool simulation_checkpoint_save(std::string const& filename, cloth_structure* const* cloths, constraint_structure* const* constraints, int N_cloth, simulation_parameters const& parameters)
+{
+    // Records and size of the file
+    std::vector<checkpoint_cloth> records(N_cloth);
+    size_t size = align8(sizeof(checkpoint_header) + sizeof(checkpoint_settings) + N_cloth * sizeof(checkpoint_cloth));
+    for (int k = 0; k < N_cloth; ++k) {
+        cloth_structure const& cloth = *cloths[k];
+        constraint_structure const& constraint = *constraints[k];
+        bool const lod_pins = cloth.lod.constraint_version == constraint.version; // otherwise read from the constraint at the next switch
+
+        checkpoint_cloth& record = records[k];
+        record.N_x = cloth.N_samples_x();
+        record.N_y = cloth.N_samples_y();
+        record.lenght_x = cloth.lenght_x;
+        record.lenght_y = cloth.lenght_y;
+        record.mass_total = cloth.mass_total;
+        record.K = cloth.K;
+        record.mu = cloth.mu;
+        record.ground_z = constraint.ground_z;
+        record.stepper_dt = cloth.stepper.dt;
+        record.stepper_stable_steps = cloth.stepper.stable_steps;
+        record.halted = cloth.stepper.halted ? 1 : 0;
+        record.has_previous = cloth.previous_position.size() == cloth.position.size() && cloth.previous_normal.size() == cloth.position.size();
+        record.N_fixed = int32_t(constraint.fixed_sample.size());
+        record.lod_N_sample_finest = cloth.lod.N_sample_finest;
+        record.lod_level = cloth.lod.level;
+        record.N_lod_pin = lod_pins ? int32_t(cloth.lod.pin_uv.size()) : 0;
+        record.offset = size;
+        size += cloth_data_size(record);
+    }
+
+    checkpoint_header header;
+    std::memcpy(header.magic, checkpoint_magic, sizeof(header.magic));
+    header.version = checkpoint_version;
+    header.N_cloth = N_cloth;
+    header.size = size;
+    header.settings_size = sizeof(checkpoint_settings);
+    header.cloth_size = sizeof(checkpoint_cloth);
+
+    checkpoint_settings settings;
+    settings.dt = parameters.dt;
+    settings.solver = parameters.solver;
+    settings.implicit = parameters.implicit;
+    settings.xpbd = parameters.xpbd;
+    settings.projective = parameters.projective;
+    settings.adaptive = parameters.adaptive;
+    settings.self_collision = parameters.self_collision;
+    settings.clothesline_collision = parameters.clothesline_collision;
+    settings.cloth_collision = parameters.cloth_collision;
+    settings.sleeping = parameters.sleeping;
+    settings.lod = parameters.lod;
+    settings.fan_position = parameters.fan_position;
+    settings.wind_magnitude = parameters.wind.magnitude;
+    settings.wind_direction = parameters.wind.direction;
+    settings.wind_source = parameters.wind.source;
+    settings.wind_aperture = parameters.wind.aperture;
+    settings.air_density = parameters.wind.air_density;
+    settings.drag_coefficient = parameters.wind.drag_coefficient;
+    settings.lift_coefficient = parameters.wind.lift_coefficient;
+
+    // The whole file is assembled in memory, then written at once
+    std::vector<char> buffer(size, 0);
+    char* cursor = buffer.data();
+    write(cursor, &header, 1);
+    write(cursor, &settings, 1);
+    write(cursor, records.data(), records.size());
+    for (int k = 0; k < N_cloth; ++k) {
+        cloth_structure const& cloth = *cloths[k];
+        checkpoint_cloth const& record = records[k];
+        size_t const N = cloth.position.size();
+        cursor = buffer.data() + record.offset;
+        write(cursor, cloth.position.data.data.data(), N);
+        write(cursor, cloth.velocity.data.data.data(), N);
+        write(cursor, cloth.normal.data.data.data(), N);
+        if (record.has_previous) {
+            write(cursor, cloth.previous_position.data.data(), N);
+            write(cursor, cloth.previous_normal.data.data(), N);
+        }
+        write(cursor, constraints[k]->fixed_sample.data(), record.N_fixed);
+        write(cursor, cloth.lod.pin_uv.data(), record.N_lod_pin);
+        write(cursor, cloth.lod.pin_position.data(), record.N_lod_pin);
+    }
+
+    std::ofstream file(filename, std::ios::binary);
+    file.write(buffer.data(), buffer.size());
+    if (!file) {
+        std::cout << "Cannot write the checkpoint " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Check the records of the cloths against the file (returns an explanation of the first error, empty if none)
+static std::string check_records(checkpoint_mapping const& mapping, checkpoint_cloth const* records, cloth_structure* const* cloths, int N_cloth)
+{
+    for (int k = 0; k < N_cloth; ++k) {
+        checkpoint_cloth const& record = records[k];
+        if (record.N_x <= 3 || record.N_x != record.N_y || record.N_fixed < 0 || record.N_lod_pin < 0)
+            return "invalid grid of the cloth " + str(k);
+        if (record.offset % 8 != 0 || record.offset > mapping.size || cloth_data_size(record) > mapping.size - record.offset)
+            return "truncated buffers of the cloth " + str(k);
+        if (cloths[k]->lod.corners.size() != 4)
+            return "the cloth " + str(k) + " was not initialized from a description";
+
+        // Fixed positions inside the grid
+        size_t const N = size_t(record.N_x) * record.N_y;
+        char const* cursor = mapping.data + record.offset + (record.has_previous ? 5 : 3) * N * sizeof(vec3);
+        for (int i = 0; i < record.N_fixed; ++i) {
+            position_contraint c;
+            read(cursor, &c, 1);
+            if (c.ku < 0 || c.ku >= record.N_x || c.kv < 0 || c.kv >= record.N_y || c.k != c.ku + record.N_x * c.kv)
+                return "invalid fixed position of the cloth " + str(k);
+        }
+    }
+    return "";
+}
+
+bool simulation_checkpoint_load(std::string const& filename, cloth_structure* const* cloths, constraint_structure* const* constraints, int N_cloth, simulation_parameters& parameters)
+{
+    checkpoint_mapping mapping;
+    if (!mapping.open(filename)) {
+        std::cout << "Cannot read the checkpoint " << filename << std::endl;
+        return false;
+    }
+
+    // Validation of the whole file before any change
+    checkpoint_header header;
+    std::string error;
+    if (mapping.size < sizeof(checkpoint_header))
+        error = "truncated header";
+    else {
+        std::memcpy(&header, mapping.data, sizeof(header));
+        if (std::memcmp(header.magic, checkpoint_magic, sizeof(header.magic)) != 0)
+            error = "not a checkpoint";
+        else if (header.version != checkpoint_version || header.settings_size != int32_t(sizeof(checkpoint_settings)) || header.cloth_size != int32_t(sizeof(checkpoint_cloth)))
+            error = "version " + str(header.version) + " instead of " + str(checkpoint_version) + " (or another layout of the settings)";
+        else if (header.size != mapping.size || mapping.size < sizeof(checkpoint_header) + sizeof(checkpoint_settings) + size_t(N_cloth) * sizeof(checkpoint_cloth))
+            error = "truncated file";
+        else if (header.N_cloth != N_cloth)
+            error = str(header.N_cloth) + " cloths instead of " + str(N_cloth);
+    }
+    char const* cursor = mapping.data + sizeof(checkpoint_header);
+    checkpoint_settings settings;
+    std::vector<checkpoint_cloth> records(N_cloth);
+    if (error.empty()) {
+        read(cursor, &settings, 1);
+        read(cursor, records.data(), records.size());
+        error = check_records(mapping, records.data(), cloths, N_cloth);
+    }
+    if (!error.empty()) {
+        std::cout << "Cannot read the checkpoint " << filename << ": " << error << std::endl;
+        return false;
+    }
+
+    // Settings (the wind field is kept)
+    parameters.dt = settings.dt;
+    parameters.solver = settings.solver;
+    parameters.implicit = settings.implicit;
+    parameters.xpbd = settings.xpbd;
+    parameters.projective = settings.projective;
+    parameters.adaptive = settings.adaptive;
+    parameters.self_collision = settings.self_collision;
+    parameters.clothesline_collision = settings.clothesline_collision;
+    parameters.cloth_collision = settings.cloth_collision;
+    parameters.sleeping = settings.sleeping;
+    parameters.lod = settings.lod;
+    parameters.fan_position = settings.fan_position;
+    parameters.wind.magnitude = settings.wind_magnitude;
+    parameters.wind.direction = settings.wind_direction;
+    parameters.wind.source = settings.wind_source;
+    parameters.wind.aperture = settings.wind_aperture;
+    parameters.wind.air_density = settings.air_density;
+    parameters.wind.drag_coefficient = settings.drag_coefficient;
+    parameters.wind.lift_coefficient = settings.lift_coefficient;
+
+    // Cloths: rebuilt on their grid (reset of the solvers, collisions and sleeping), then their buffers are copied
+    for (int k = 0; k < N_cloth; ++k) {
+        cloth_structure& cloth = *cloths[k];
+        constraint_structure& constraint = *constraints[k];
+        checkpoint_cloth const& record = records[k];
+        size_t const N = size_t(record.N_x) * record.N_y;
+
+        cloth.mass_total = record.mass_total;
+        cloth.K = record.K;
+        cloth.mu = record.mu;
+        cloth.initialize(record.N_x, cloth.lod.corners, record.lenght_x, record.lenght_y);
+
+        cursor = mapping.data + record.offset;
+        read(cursor, cloth.position.data.data.data(), N);
+        read(cursor, cloth.velocity.data.data.data(), N);
+        read(cursor, cloth.normal.data.data.data(), N);
+        if (record.has_previous) {
+            cloth.previous_position.resize(N);
+            cloth.previous_normal.resize(N);
+            read(cursor, cloth.previous_position.data.data(), N);
+            read(cursor, cloth.previous_normal.data.data(), N);
+        }
+        cloth.stepper.dt = record.stepper_dt;
+        cloth.stepper.stable_steps = record.stepper_stable_steps;
+        cloth.stepper.halted = record.halted != 0;
+        cloth.update_bounding_box();
+
+        constraint.initialize(cloth);
+        constraint.ground_z = record.ground_z;
+        constraint.fixed_sample.resize(record.N_fixed);
+        read(cursor, constraint.fixed_sample.data(), record.N_fixed);
+        for (position_contraint const& c : constraint.fixed_sample)
+            constraint.inverse_mass[c.k] = { 0, 0, 0 };
+
+        cloth.lod.N_sample_finest = record.lod_N_sample_finest;
+        cloth.lod.level = record.lod_level;
+        cloth.lod.pin_uv.resize(record.N_lod_pin);
+        cloth.lod.pin_position.resize(record.N_lod_pin);
+        read(cursor, cloth.lod.pin_uv.data(), record.N_lod_pin);
+        read(cursor, cloth.lod.pin_position.data(), record.N_lod_pin);
+        cloth.lod.constraint_version = record.N_lod_pin > 0 ? constraint.version : -1;
+    }
+    return true;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "../cgp_headless.hpp"
+
+#include <string>
+
+struct cloth_structure;
+struct constraint_structure;
+struct simulation_parameters;
+
+
+// Binary checkpoint of the simulation: the settings of the simulation, then for each cloth its grid, its buffers
+//  (positions, velocities, normals and the previous state of the display), its fixed positions and its level of detail.
+//  The file is a header followed by fixed-size records and the raw buffers at the offsets given by the records: it is
+//  written at once and read back from a memory mapping without parsing. A checkpoint is only read by a program with the
+//  same checkpoint_version and the same layout of the settings (sizes checked in the header).
+int const checkpoint_version = 1;
+
+// Write the state of the N_cloth cloths and the settings of the simulation in the file. Returns false if the file
+//  cannot be written.
+bool simulation_checkpoint_save(std::string const& filename, cloth_structure* const* cloths, constraint_structure* const* constraints, int N_cloth, simulation_parameters const& parameters);
+
+// Restore the cloths (in the same order as they were saved) and the settings of the simulation from the file. The
+//  cloths must have been initialized from their description (the corners of their levels of detail rebuild their grids),
+//  the obstacles and the wind field are not updated. Returns false, and changes nothing, if the file is not a valid
+//  checkpoint of N_cloth cloths.
+bool simulation_checkpoint_load(std::string const& filename, cloth_structure* const* cloths, constraint_structure* const* constraints, int N_cloth, simulation_parameters& parameters);
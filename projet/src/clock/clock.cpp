@@ -0,0 +1,32 @@
+#include "clock.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+
+int simulation_clock_structure::advance(float elapsed, float step_dt)
+{
+    if (step_dt <= 0.0f)
+        return 0;
+
+    accumulator += std::max(elapsed, 0.0f);
+    steps = std::min(static_cast<int>(accumulator / step_dt), max_steps_per_frame);
+    accumulator -= steps * step_dt;
+
+    // Over budget: the late time is dropped instead of being accumulated frame after frame
+    if (accumulator >= step_dt) {
+        accumulator = std::fmod(accumulator, step_dt);
+        budget_exceeded++;
+    }
+
+    alpha = accumulator / step_dt;
+    return steps;
+}
+
+void simulation_clock_structure::reset()
+{
+    accumulator = 0.0f;
+    alpha = 1.0f;
+    steps = 0;
+    budget_exceeded = 0;
+}
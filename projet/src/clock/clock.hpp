@@ -0,0 +1,21 @@
+#pragma once
+
+
+// Fixed time step accumulator: decouples the simulated time from the display rate.
+//  The elapsed real time is accumulated and consumed by simulation steps of fixed duration. The remaining fraction
+//  of a step gives the interpolation factor between the two last simulated states used for the display.
+struct simulation_clock_structure
+{
+    float accumulator = 0.0f;     // elapsed time that has not been simulated yet
+    int max_steps_per_frame = 4;  // budget of simulation steps per displayed frame
+    float alpha = 1.0f;           // interpolation factor between the previous (0) and current (1) simulated states
+
+    // Counters
+    int steps = 0;                // number of steps of the last frame
+    int budget_exceeded = 0;      // number of frames where the budget was reached (the simulation runs slower than real time)
+
+    // Add the elapsed time, returns the number of steps of duration step_dt to simulate for this frame
+    int advance(float elapsed, float step_dt);
+
+    void reset();
+};
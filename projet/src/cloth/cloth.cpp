@@ -1,5 +1,8 @@
 #include "cloth.hpp"
 
+#include <algorithm>
+#include <limits>
+
 using namespace cgp;
 
 
@@ -25,47 +28,70 @@ void cloth_structure::initialize(int N_samples_edge_arg, std::vector<vec3> pos,
     position = grid_2D<vec3>::from_buffer(cloth_mesh.position, N_samples_edge_arg, N_samples_edge_arg);
     normal = grid_2D<vec3>::from_buffer(cloth_mesh.normal, N_samples_edge_arg, N_samples_edge_arg);
     triangle_connectivity = cloth_mesh.connectivity;
+
+    float const L0_x = lenght_x / (N_samples_edge_arg - 1.0f); // rest length between two direct neighboring particle
+    float const L0_y = lenght_y / (N_samples_edge_arg - 1.0f);
+    springs.initialize_grid(N_samples_edge_arg, N_samples_edge_arg, L0_x, L0_y);
+
+    int const N_total = N_samples_edge_arg * N_samples_edge_arg;
+    position_lanes.resize(N_total);
+    velocity_lanes.resize(N_total);
+    force_lanes.resize(N_total);
+    air_velocity_lanes.resize(N_total);
+    normal_lanes.resize(N_total);
+    normal_incidence = normal_incidence_structure();
+    for (simd_vec3_lanes& triangle_force : triangle_force_lanes) {
+        triangle_force = simd_vec3_lanes(); // the padding and the quads of the last column and row must be zero
+        triangle_force.resize(N_total + N_samples_edge_arg + 1);
+    }
+
+    update_bounding_box();
+
+    stepper = adaptive_stepper_structure(); // restart the adaptive time stepping (and its counters)
+    clothesline = clothesline_structure();  // no sweep from the previous positions
+    cloth_collision = cloth_collision_structure(); // no contact side from the previous positions
+    sleeping = sleeping_structure();               // awake
+    previous_position.clear();
+    previous_normal.clear();
 }
 
 void cloth_structure::update_normal()
 {
-    normal_per_vertex(position.data, triangle_connectivity, normal.data);
+    int const N_x = N_samples_x();
+    int const N_y = N_samples_y();
+    if (triangle_connectivity.size() == size_t(2 * (N_x - 1) * (N_y - 1))) {
+        simulation_normal_grid(*this);
+        return;
+    }
+
+    if (normal_incidence.N_vertex() != int(position.size()))
+        normal_incidence.initialize(triangle_connectivity, position.size());
+    simulation_normal_mesh(position.data, triangle_connectivity, normal_incidence, normal.data);
 }
 
-int cloth_structure::N_samples_x() const
+void cloth_structure::update_bounding_box()
 {
-    return position.dimension.x;
+    bounding_box(0, position.size(), bounding_box_min, bounding_box_max);
 }
 
-int cloth_structure::N_samples_y() const
+void cloth_structure::bounding_box(int k_begin, int k_end, vec3& p_min, vec3& p_max) const
 {
-    return position.dimension.y;
+    float const inf = std::numeric_limits<float>::max();
+    p_min = { inf, inf, inf };
+    p_max = { -inf, -inf, -inf };
+    for (int k = k_begin; k < k_end; ++k) {
+        vec3 const& p = position.data[k];
+        p_min = { std::min(p_min.x, p.x), std::min(p_min.y, p.y), std::min(p_min.z, p.z) };
+        p_max = { std::max(p_max.x, p.x), std::max(p_max.y, p.y), std::max(p_max.z, p.z) };
+    }
 }
 
-
-
-void cloth_structure_drawable::initialize(int N_samples_edge, int x_length, int y_length)
+int cloth_structure::N_samples_x() const
 {
-    mesh const cloth_mesh = mesh_primitive_grid({x_length,y_length,0}, {x_length,0,0}, {0,0,0}, {0,y_length,0}, N_samples_edge, N_samples_edge);
-
-    drawable.clear();
-    drawable.initialize_data_on_gpu(cloth_mesh);
-    drawable.material.phong.specular = 0.0f;
-    opengl_check;
-}
-
-
-void cloth_structure_drawable::update(cloth_structure const& cloth)
-{    
-    drawable.vbo_position.update(cloth.position.data);
-    drawable.vbo_normal.update(cloth.normal.data);
+    return position.dimension.x;
 }
 
-void draw(cloth_structure_drawable const& cloth_drawable, environment_generic_structure const& environment)
+int cloth_structure::N_samples_y() const
 {
-    draw(cloth_drawable.drawable, environment);
+    return position.dimension.y;
 }
-void draw_wireframe(cloth_structure_drawable const& cloth_drawable, environment_generic_structure const& environment)
-{
-    draw_wireframe(cloth_drawable.drawable, environment);
-}
\ No newline at end of file
@@ -1,8 +1,20 @@
 #pragma once
 
 
-#include "cgp/cgp.hpp"
-#include "../environment.hpp"
+#include "../cgp_headless.hpp"
+#include "../simd/simd.hpp"
+#include "../spring/spring.hpp"
+#include "../implicit/implicit.hpp"
+#include "../xpbd/xpbd.hpp"
+#include "../projective/projective.hpp"
+#include "../adaptive/adaptive.hpp"
+#include "../obstacle/obstacle.hpp"
+#include "../self_collision/self_collision.hpp"
+#include "../clothesline/clothesline.hpp"
+#include "../cloth_collision/cloth_collision.hpp"
+#include "../sleeping/sleeping.hpp"
+#include "../lod/lod.hpp"
+#include "../normal/normal.hpp"
 
 #include <vector>
 
@@ -15,38 +27,70 @@ struct cloth_structure
     cgp::grid_2D<cgp::vec3> force;
     cgp::grid_2D<cgp::vec3> normal;
 
-    // Also stores the triangle connectivity used to update the normals
+    // Structure-of-arrays copy of the positions, velocities and forces used by the vectorized force kernels
+    simd_vec3_lanes position_lanes;
+    simd_vec3_lanes velocity_lanes;
+    simd_vec3_lanes force_lanes;
+    simd_vec3_lanes normal_lanes;
+
+    // Air velocity at the vertices and aerodynamic forces of the two triangles of each quad (see simd_aerodynamic_lanes)
+    simd_vec3_lanes air_velocity_lanes;
+    simd_vec3_lanes triangle_force_lanes[2];
+
+    // Also stores the triangle connectivity used to update the normals (gathered from the grid neighbors while it is the
+    //  connectivity of the grid, from the incidence of the triangles otherwise)
     cgp::numarray<cgp::uint3> triangle_connectivity;
+    normal_incidence_structure normal_incidence;
+
+    // Springs between the vertices (structural, shear and bending), built once at initialization
+    spring_structure springs;
 
     // The size of the cloth
     float lenght_x;
     float lenght_y;
 
-    // The texture of the cloth
-    cgp::opengl_texture_image_structure texture;
-
     // Simulation parameters
     float mass_total = 0.5f; // total mass of the cloth
     float K = 5.0f;         // stiffness parameter
     float mu = 15.0f;        // damping parameter
+
+    // Buffers of the implicit, position-based and projective solvers
+    implicit_solver_structure implicit_solver;
+    xpbd_solver_structure xpbd_solver;
+    projective_solver_structure projective_solver;
+
+    // Substep, saved state and counters of the adaptive time stepping
+    adaptive_stepper_structure stepper;
+
+    // Axis aligned bounding box of the positions, updated by the integration of each solver, and obstacles overlapping it
+    cgp::vec3 bounding_box_min;
+    cgp::vec3 bounding_box_max;
+    obstacle_candidates_structure obstacle_candidates;
+
+    // Spatial hash and contacts of the collisions of the cloth with itself
+    self_collision_structure self_collision;
+
+    // Swept positions of the continuous collisions with the wires of the clotheslines
+    clothesline_structure clothesline;
+
+    // Positions at the beginning of the step and buffers of the collisions with the other cloths
+    cloth_collision_structure cloth_collision;
+
+    // Rest state: a sleeping cloth is skipped by the simulation and the display
+    sleeping_structure sleeping;
+
+    // Resolutions of the cloth (level of detail), kept by initialize when the cloth switches to another one
+    lod_structure lod;
+
+    // State before the last simulation step, used to interpolate the display between two steps
+    cgp::numarray<cgp::vec3> previous_position;
+    cgp::numarray<cgp::vec3> previous_normal;
     
     
-    void initialize(int N_samples_edge, std::vector<vec3> pos, float x_lenght, float y_lenght);  // Initialize a square flat cloth
+    void initialize(int N_samples_edge, std::vector<cgp::vec3> pos, float x_lenght, float y_lenght);  // Initialize a square flat cloth
     void update_normal();       // Call this function every time the cloth is updated before its draw
+    void update_bounding_box(); // Call this function every time the positions are integrated
+    void bounding_box(int k_begin, int k_end, cgp::vec3& p_min, cgp::vec3& p_max) const; // Bounding box of the vertices [k_begin, k_end)
     int N_samples_x() const;      // Number of vertex along x dimension of the grid
     int N_samples_y() const;      // Number of vertex along y dimension of the grid
 };
-
-
-// Helper structure and functions to draw a cloth
-// ********************************************** //
-struct cloth_structure_drawable
-{
-    cgp::mesh_drawable drawable;
-
-    void initialize(int N_sample_edge, int x_length, int y_length);
-    void update(cloth_structure const& cloth);
-};
-
-void draw(cloth_structure_drawable const& cloth_drawable, environment_generic_structure const& environment);
-void draw_wireframe(cloth_structure_drawable const& cloth_drawable, environment_generic_structure const& environment);
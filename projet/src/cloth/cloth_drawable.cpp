@@ -0,0 +1,68 @@
+#include "cloth_drawable.hpp"
+
+using namespace cgp;
+
+
+void cloth_structure_drawable::initialize(int N_samples_edge, int x_length, int y_length)
+{
+    mesh const cloth_mesh = mesh_primitive_grid({x_length,y_length,0}, {x_length,0,0}, {0,0,0}, {0,y_length,0}, N_samples_edge, N_samples_edge);
+
+    drawable.clear();
+    drawable.initialize_data_on_gpu(cloth_mesh);
+    drawable.material.phong.specular = 0.0f;
+    asleep_sent = false;
+    opengl_check;
+}
+
+
+void cloth_structure_drawable::resize(int N_samples_edge, int x_length, int y_length)
+{
+    opengl_texture_image_structure const texture = drawable.texture;
+    material_mesh_drawable_phong const material = drawable.material;
+    initialize(N_samples_edge, x_length, y_length);
+    drawable.texture = texture;
+    drawable.material = material;
+}
+
+void cloth_structure_drawable::update(cloth_structure const& cloth)
+{    
+    drawable.vbo_position.update(cloth.position.data);
+    drawable.vbo_normal.update(cloth.normal.data);
+}
+
+void cloth_structure_drawable::update(cloth_structure const& cloth, float alpha)
+{
+    // A sleeping cloth does not move: its state is sent once
+    if (cloth.sleeping.asleep && asleep_sent)
+        return;
+    asleep_sent = cloth.sleeping.asleep;
+
+    size_t const N = cloth.position.size();
+    if (alpha >= 1.0f || cloth.previous_position.size() != N || cloth.previous_normal.size() != N) {
+        update(cloth);
+        return;
+    }
+
+    interpolated_position.resize(N);
+    interpolated_normal.resize(N);
+    for (size_t k = 0; k < N; ++k)
+    {
+        interpolated_position[k] = (1 - alpha) * cloth.previous_position[k] + alpha * cloth.position.data[k];
+
+        vec3 const n = (1 - alpha) * cloth.previous_normal[k] + alpha * cloth.normal.data[k];
+        float const n_norm = norm(n);
+        interpolated_normal[k] = n_norm > 1e-6f ? n / n_norm : cloth.normal.data[k];
+    }
+
+    drawable.vbo_position.update(interpolated_position);
+    drawable.vbo_normal.update(interpolated_normal);
+}
+
+void draw(cloth_structure_drawable const& cloth_drawable, environment_generic_structure const& environment)
+{
+    draw(cloth_drawable.drawable, environment);
+}
+void draw_wireframe(cloth_structure_drawable const& cloth_drawable, environment_generic_structure const& environment)
+{
+    draw_wireframe(cloth_drawable.drawable, environment);
+}
\ No newline at end of file
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "cgp/cgp.hpp"
+#include "cloth.hpp"
+
+
+// Helper structure and functions to draw a cloth (the texture of the cloth is stored in the drawable)
+// ********************************************** //
+struct cloth_structure_drawable
+{
+    cgp::mesh_drawable drawable;
+
+    // Interpolated state sent to the GPU
+    cgp::numarray<cgp::vec3> interpolated_position;
+    cgp::numarray<cgp::vec3> interpolated_normal;
+    bool asleep_sent = false; // the buffers hold the state of the sleeping cloth (not sent again)
+
+    void initialize(int N_sample_edge, int x_length, int y_length);
+    void resize(int N_sample_edge, int x_length, int y_length); // new grid (level of detail) with the same texture and material
+    void update(cloth_structure const& cloth);
+    void update(cloth_structure const& cloth, float alpha); // display the state between the previous (alpha=0) and current (alpha=1) steps
+};
+
+void draw(cloth_structure_drawable const& cloth_drawable, cgp::environment_generic_structure const& environment);
+void draw_wireframe(cloth_structure_drawable const& cloth_drawable, cgp::environment_generic_structure const& environment);
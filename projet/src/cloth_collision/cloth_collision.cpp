@@ -0,0 +1,496 @@
+#include "cloth_collision.hpp"
+
+#include "../self_collision/self_collision_geometry.hpp"
+#include "../cloth/cloth.hpp"
+#include "../constraint/constraint.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+using namespace cgp;
+
+
+int cloth_islands_structure::N_island() const
+{
+    return int(island_start.size()) - 1;
+}
+
+// Smallest and largest distance between two neighboring vertices of the grid of the cloth
+static float spacing_min(cloth_structure const& cloth)
+{
+    return std::min(cloth.lenght_x / (cloth.N_samples_x() - 1.0f), cloth.lenght_y / (cloth.N_samples_y() - 1.0f));
+}
+
+static float spacing_max(cloth_structure const& cloth)
+{
+    return std::max(cloth.lenght_x / (cloth.N_samples_x() - 1.0f), cloth.lenght_y / (cloth.N_samples_y() - 1.0f));
+}
+
+static bool finite_box(vec3 const& p_min, vec3 const& p_max)
+{
+    for (int c = 0; c < 3; ++c)
+        if (!std::isfinite(p_min[c]) || !std::isfinite(p_max[c]))
+            return false;
+    return true;
+}
+
+static bool overlap(vec3 const& a_min, vec3 const& a_max, vec3 const& b_min, vec3 const& b_max)
+{
+    return a_min.x <= b_max.x && a_min.y <= b_max.y && a_min.z <= b_max.z && b_min.x <= a_max.x && b_min.y <= a_max.y && b_min.z <= a_max.z;
+}
+
+static vec3 component_min(vec3 const& a, vec3 const& b)
+{
+    return { std::min(a.x, b.x), std::min(a.y, b.y), std::min(a.z, b.z) };
+}
+
+static vec3 component_max(vec3 const& a, vec3 const& b)
+{
+    return { std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z) };
+}
+
+static int find_root(std::vector<int>& parent, int k)
+{
+    while (parent[k] != k) {
+        parent[k] = parent[parent[k]];
+        k = parent[k];
+    }
+    return k;
+}
+
+void simulation_cloth_islands(cloth_islands_structure& islands, cloth_structure* const* cloths, int N_cloth, cloth_collision_parameters const& parameters, int N_step)
+{
+    std::vector<int>& parent = islands.parent;
+    parent.resize(N_cloth);
+    for (int k = 0; k < N_cloth; ++k)
+        parent[k] = k;
+
+    if (parameters.enabled)
+    {
+        // Each cloth of a pair covers its share of the thickness and its own motion, estimated from the displacement of its
+        //  vertices during the last step
+        islands.box_min.resize(N_cloth);
+        islands.box_max.resize(N_cloth);
+        for (int k = 0; k < N_cloth; ++k)
+        {
+            cloth_structure const& cloth = *cloths[k];
+            numarray<vec3> const& start = cloth.cloth_collision.start;
+            float displacement2 = 0.0f;
+            if (start.size() == cloth.position.size())
+                for (int i = 0; i < int(start.size()); ++i) {
+                    vec3 const d = cloth.position.data[i] - start[i];
+                    displacement2 = std::max(displacement2, dot(d, d));
+                }
+            float const margin = parameters.thickness * spacing_min(cloth) + 2.0f * N_step * std::sqrt(displacement2);
+            islands.box_min[k] = cloth.bounding_box_min - vec3(margin, margin, margin);
+            islands.box_max[k] = cloth.bounding_box_max + vec3(margin, margin, margin);
+        }
+
+        // A diverging cloth (non finite box or speed) stays alone
+        for (int i = 0; i < N_cloth; ++i) {
+            if (!finite_box(islands.box_min[i], islands.box_max[i]))
+                continue;
+            for (int j = i + 1; j < N_cloth; ++j)
+                if (finite_box(islands.box_min[j], islands.box_max[j]) && overlap(islands.box_min[i], islands.box_max[i], islands.box_min[j], islands.box_max[j]))
+                    parent[find_root(parent, j)] = find_root(parent, i);
+        }
+    }
+
+    // Islands in the order of their first cloth (a scene without contact keeps one task per cloth, in the same order),
+    //  the cloths of each island in increasing order
+    std::vector<int> island_of_root(N_cloth, -1);
+    std::vector<int> island_of(N_cloth);
+    int N_island = 0;
+    for (int k = 0; k < N_cloth; ++k) {
+        int const root = find_root(parent, k);
+        if (island_of_root[root] < 0)
+            island_of_root[root] = N_island++;
+        island_of[k] = island_of_root[root];
+    }
+
+    islands.island_start.assign(N_island + 1, 0);
+    for (int k = 0; k < N_cloth; ++k)
+        islands.island_start[island_of[k] + 1]++;
+    for (int i = 0; i < N_island; ++i)
+        islands.island_start[i + 1] += islands.island_start[i];
+    islands.cloth_index.resize(N_cloth);
+    std::vector<int> cursor(islands.island_start.begin(), islands.island_start.end() - 1);
+    for (int k = 0; k < N_cloth; ++k)
+        islands.cloth_index[cursor[island_of[k]]++] = k;
+}
+
+void simulation_cloth_collision_begin_step(cloth_structure& cloth)
+{
+    cloth_collision_structure& collision = cloth.cloth_collision;
+    collision.start = cloth.position.data;
+    cloth.bounding_box(0, cloth.position.size(), collision.start_min, collision.start_max);
+    collision.contact_count = 0;
+}
+
+
+// Positions of a vertex at the beginning (p0) and at the end (p1) of the step
+struct swept_vertex
+{
+    vec3 p0;
+    vec3 p1;
+};
+
+static swept_vertex swept(cloth_structure const& cloth, int k)
+{
+    return { cloth.cloth_collision.start[k], cloth.position.data[k] };
+}
+
+static float displacement(swept_vertex const& v)
+{
+    return norm(v.p1 - v.p0);
+}
+
+// Box of the swept quad q inflated by margin
+static void swept_quad_box(cloth_structure const& cloth, int q, float margin, vec3& p_min, vec3& p_max)
+{
+    int const N_x = cloth.N_samples_x();
+    vec3 s_min, s_max;
+    quad_box(q, cloth.cloth_collision.start, N_x, margin, s_min, s_max);
+    quad_box(q, cloth.position.data, N_x, margin, p_min, p_max);
+    p_min = component_min(p_min, s_min);
+    p_max = component_max(p_max, s_max);
+}
+
+// Box of the swept edge inflated by margin
+static void swept_edge_box(cloth_structure const& cloth, int edge, float margin, vec3& p_min, vec3& p_max)
+{
+    int const N_x = cloth.N_samples_x();
+    vec3 s_min, s_max;
+    edge_box(edge, cloth.cloth_collision.start, N_x, margin, s_min, s_max);
+    edge_box(edge, cloth.position.data, N_x, margin, p_min, p_max);
+    p_min = component_min(p_min, s_min);
+    p_max = component_max(p_max, s_max);
+}
+
+// Vertex v closer than the thickness to the triangle (a,b,c) at the end of the step, or which crossed it: side of the
+//  vertex at the beginning of the step
+static bool vertex_triangle_contact(swept_vertex const& v, swept_vertex const& a, swept_vertex const& b, swept_vertex const& c, float thickness, float& side)
+{
+    vec3 n1, w;
+    float d1;
+    if (!vertex_triangle(v.p1, a.p1, b.p1, c.p1, FLT_MAX, n1, d1, w))
+        return false;
+
+    vec3 const n0 = cross(b.p0 - a.p0, c.p0 - a.p0);
+    float const d0 = dot(v.p0 - a.p0, n0);
+    side = (d0 != 0.0f ? d0 : d1) >= 0 ? 1.0f : -1.0f;
+    if (side * d1 >= thickness)
+        return false;
+
+    // A crossing is only considered within the distance covered during the step
+    float const motion = displacement(v) + std::max(displacement(a), std::max(displacement(b), displacement(c)));
+    return side * d1 > 0 || -side * d1 < thickness + motion;
+}
+
+// Signed distance d between the lines of the edges (p1,q1) and (p2,q2) along their common normal m. Its sign changes
+//  when the edges cross each other. Nearly parallel edges have no reliable normal (their contacts are left to the
+//  vertex-triangle tests).
+static bool edge_edge_distance(vec3 const& p1, vec3 const& q1, vec3 const& p2, vec3 const& q2, float& d, vec3& m)
+{
+    vec3 const e1 = q1 - p1;
+    vec3 const e2 = q2 - p2;
+    m = cross(e1, e2);
+    float const length = norm(m);
+    if (length < 0.1f * norm(e1) * norm(e2))
+        return false;
+    m /= length;
+    d = dot(p1 - p2, m);
+    return true;
+}
+
+// Edges (p1,q1) and (p2,q2) closer than the thickness at the end of the step, or which crossed each other: side of the
+//  first edge relative to the second at the beginning of the step
+static bool edge_edge_contact(swept_vertex const& p1, swept_vertex const& q1, swept_vertex const& p2, swept_vertex const& q2, float thickness, float& side)
+{
+    float s, t, distance;
+    vec3 n;
+    if (!edge_edge(p1.p1, q1.p1, p2.p1, q2.p1, FLT_MAX, s, t, n, distance))
+        return false;
+
+    vec3 m0, m1;
+    float d0, d1;
+    if (!edge_edge_distance(p1.p0, q1.p0, p2.p0, q2.p0, d0, m0) || !edge_edge_distance(p1.p1, q1.p1, p2.p1, q2.p1, d1, m1) || dot(m0, m1) <= 0)
+        return false;
+    side = d0 >= 0 ? 1.0f : -1.0f;
+    if (side * d1 >= thickness)
+        return false;
+    if (side * d1 > 0)
+        return distance < thickness;
+
+    float const motion = std::max(displacement(p1), displacement(q1)) + std::max(displacement(p2), displacement(q2));
+    return distance < thickness + motion;
+}
+
+// Axis aligned box (swept by a cloth, or overlap of the swept boxes of two cloths)
+struct swept_box
+{
+    vec3 p_min;
+    vec3 p_max;
+};
+
+// Vertices of the cloth_v against the triangles of the cloth_t, in the region of the pair (the vertices of cloth_v
+//  are in vertices). first_is_vertex gives the type of the contacts (see cloth_collision_contact).
+static void detect_vertex_triangle(cloth_structure const& cloth_t, cloth_structure const& cloth_v, self_collision_hash const& vertices, self_collision_grid const& grid, swept_box const& region, float thickness, bool first_is_vertex, std::vector<cloth_collision_contact>& contacts)
+{
+    int const N_x = cloth_t.N_samples_x();
+    int const N_y = cloth_t.N_samples_y();
+    vec3 const* vertex_boxes = vertices.boxes.data();
+    int const* vertex_start = vertices.cell_start.data();
+    int const* vertex_entries = vertices.entries.data();
+
+    for (int q = 0; q < N_x * N_y; ++q)
+    {
+        if (!quad_exists(q, N_x, N_y))
+            continue;
+        vec3 q_min, q_max;
+        swept_quad_box(cloth_t, q, thickness, q_min, q_max);
+        int3 c0, c1;
+        if (!overlap(q_min, q_max, region.p_min, region.p_max) || !grid.cells(q_min, q_max, c0, c1))
+            continue;
+
+        // Each pair is tested in the cell of the lowest corner of the overlap of the boxes
+        for (int iz = c0.z; iz <= c1.z; ++iz) for (int iy = c0.y; iy <= c1.y; ++iy) for (int ix = c0.x; ix <= c1.x; ++ix)
+        {
+            int const h = grid.hash(ix, iy, iz);
+            for (int e = vertex_start[h]; e < vertex_start[h + 1]; ++e)
+            {
+                int const k = vertex_entries[e];
+                vec3 const& v_min = vertex_boxes[2 * k];
+                vec3 const& v_max = vertex_boxes[2 * k + 1];
+                if (!overlap(q_min, q_max, v_min, v_max))
+                    continue;
+                if (grid.coordinate(std::max(q_min.x, v_min.x)) != ix || grid.coordinate(std::max(q_min.y, v_min.y)) != iy || grid.coordinate(std::max(q_min.z, v_min.z)) != iz)
+                    continue;
+
+                swept_vertex const v = swept(cloth_v, k);
+                for (int triangle = 2 * q; triangle < 2 * q + 2; ++triangle)
+                {
+                    int a, b, c;
+                    triangle_vertices(triangle, N_x, a, b, c);
+                    float side;
+                    if (vertex_triangle_contact(v, swept(cloth_t, a), swept(cloth_t, b), swept(cloth_t, c), thickness, side))
+                        contacts.push_back(first_is_vertex ? cloth_collision_contact{ k, triangle, 0, side } : cloth_collision_contact{ triangle, k, 1, side });
+                }
+            }
+        }
+    }
+}
+
+// Edges of the cloth a against the edges of the cloth b (in edges_b), in the region of the pair
+static void detect_edge_edge(cloth_structure const& cloth_a, cloth_structure const& cloth_b, self_collision_hash const& edges_b, self_collision_grid const& grid, swept_box const& region, float thickness, std::vector<cloth_collision_contact>& contacts)
+{
+    int const N_x = cloth_a.N_samples_x();
+    int const N_y = cloth_a.N_samples_y();
+    int const N_x_b = cloth_b.N_samples_x();
+    vec3 const* edge_boxes = edges_b.boxes.data();
+    int const* edge_start = edges_b.cell_start.data();
+    int const* edge_entries = edges_b.entries.data();
+
+    for (int edge = 0; edge < 2 * N_x * N_y; ++edge)
+    {
+        if (!edge_exists(edge, N_x, N_y))
+            continue;
+        vec3 p_min, p_max;
+        swept_edge_box(cloth_a, edge, 0.5f * thickness, p_min, p_max);
+        int3 c0, c1;
+        if (!overlap(p_min, p_max, region.p_min, region.p_max) || !grid.cells(p_min, p_max, c0, c1))
+            continue;
+        int p1, q1;
+        edge_vertices(edge, N_x, p1, q1);
+
+        for (int iz = c0.z; iz <= c1.z; ++iz) for (int iy = c0.y; iy <= c1.y; ++iy) for (int ix = c0.x; ix <= c1.x; ++ix)
+        {
+            int const h = grid.hash(ix, iy, iz);
+            for (int e = edge_start[h]; e < edge_start[h + 1]; ++e)
+            {
+                int const other = edge_entries[e];
+                vec3 const& o_min = edge_boxes[2 * other];
+                vec3 const& o_max = edge_boxes[2 * other + 1];
+                if (!overlap(p_min, p_max, o_min, o_max))
+                    continue;
+                if (grid.coordinate(std::max(p_min.x, o_min.x)) != ix || grid.coordinate(std::max(p_min.y, o_min.y)) != iy || grid.coordinate(std::max(p_min.z, o_min.z)) != iz)
+                    continue;
+                int p2, q2;
+                edge_vertices(other, N_x_b, p2, q2);
+                float side;
+                if (edge_edge_contact(swept(cloth_a, p1), swept(cloth_a, q1), swept(cloth_b, p2), swept(cloth_b, q2), thickness, side))
+                    contacts.push_back({ edge, other, 2, side });
+            }
+        }
+    }
+}
+
+// Vertex of a cloth and its pin
+struct contact_vertex
+{
+    vec3& p;
+    vec3& v;
+    float w; // 0 for a pinned vertex
+};
+
+static contact_vertex vertex_of(cloth_structure& cloth, constraint_structure const& constraint, int k)
+{
+    return { cloth.position.data[k], cloth.velocity.data[k], constraint.weight(k) };
+}
+
+// Displacement of a vertex by a contact. The velocity towards the other cloth is cancelled (inelastic contact), otherwise
+//  the solver keeps pushing the vertex into the contact at the next step.
+static void displace(contact_vertex const& x, vec3 const& dp)
+{
+    float const d = norm(dp);
+    if (x.w == 0 || d == 0)
+        return;
+
+    x.p += dp;
+    vec3 const n = dp / d;
+    float const vn = dot(x.v, n);
+    if (vn < 0)
+        x.v -= vn * n;
+}
+
+// Position-based projection of the vertex v at the thickness on its side of the triangle (a,b,c) (equal masses)
+static void resolve_vertex_triangle(contact_vertex v, contact_vertex a, contact_vertex b, contact_vertex c, float side, float thickness)
+{
+    vec3 n, w;
+    float d;
+    if (!vertex_triangle(v.p, a.p, b.p, c.p, FLT_MAX, n, d, w) || side * d >= thickness)
+        return;
+    float const denominator = v.w + a.w * w.x * w.x + b.w * w.y * w.y + c.w * w.z * w.z;
+    if (denominator <= 0)
+        return;
+    vec3 const dp = ((side * thickness - d) / denominator) * n;
+    displace(v, dp);
+    displace(a, -w.x * dp);
+    displace(b, -w.y * dp);
+    displace(c, -w.z * dp);
+}
+
+// Position-based projection of the edge (p1,q1) at the thickness on its side of the edge (p2,q2)
+static void resolve_edge_edge(contact_vertex p1, contact_vertex q1, contact_vertex p2, contact_vertex q2, float side, float thickness)
+{
+    float s, t, distance;
+    vec3 n, m;
+    if (!edge_edge(p1.p, q1.p, p2.p, q2.p, FLT_MAX, s, t, n, distance))
+        return;
+    float d;
+    if (!edge_edge_distance(p1.p, q1.p, p2.p, q2.p, d, m) || side * d >= thickness)
+        return;
+    float const denominator = p1.w * (1 - s) * (1 - s) + q1.w * s * s + p2.w * (1 - t) * (1 - t) + q2.w * t * t;
+    if (denominator <= 0)
+        return;
+    vec3 const dp = ((side * thickness - d) / denominator) * m;
+    displace(p1, (1 - s) * dp);
+    displace(q1, s * dp);
+    displace(p2, -(1 - t) * dp);
+    displace(q2, -t * dp);
+}
+
+// Collisions between the cloths a and b, whose swept boxes are given
+static void collide_pair(cloth_structure& cloth_a, constraint_structure const& constraint_a, cloth_structure& cloth_b, constraint_structure const& constraint_b, swept_box const& box_a, swept_box const& box_b, cloth_collision_parameters const& parameters)
+{
+    float const thickness = parameters.thickness * std::max(spacing_min(cloth_a), spacing_min(cloth_b));
+    if (!overlap(box_a.p_min, box_a.p_max, box_b.p_min - vec3(thickness, thickness, thickness), box_b.p_max + vec3(thickness, thickness, thickness)))
+        return;
+    swept_box const region = { component_max(box_a.p_min, box_b.p_min) - vec3(thickness, thickness, thickness), component_min(box_a.p_max, box_b.p_max) + vec3(thickness, thickness, thickness) };
+
+    int const N_a = cloth_a.position.size();
+    int const N_b = cloth_b.position.size();
+    int const N_x_a = cloth_a.N_samples_x();
+    int const N_x_b = cloth_b.N_samples_x(), N_y_b = cloth_b.N_samples_y();
+
+    // Cells of the size of the largest springs, hashed in tables larger than the number of primitives
+    self_collision_grid grid;
+    grid.inv_cell_size = 1.0f / std::max(std::max(spacing_max(cloth_a), spacing_max(cloth_b)), thickness);
+    grid.mask = 1;
+    while (grid.mask < 2 * std::max(N_a, N_b))
+        grid.mask = 2 * grid.mask + 1;
+
+    // Swept vertices of both cloths and swept edges of b in the region of the pair
+    auto const vertex_box = [&region](cloth_structure const& cloth, int k, vec3& p_min, vec3& p_max) {
+        box(cloth.cloth_collision.start[k], cloth.position.data[k], 0.0f, p_min, p_max);
+        return overlap(p_min, p_max, region.p_min, region.p_max);
+    };
+    cloth_collision_structure& collision_a = cloth_a.cloth_collision;
+    cloth_collision_structure& collision_b = cloth_b.cloth_collision;
+    build_hash(collision_a.vertices, N_a, grid, false, [&](int k, vec3& p_min, vec3& p_max) { return vertex_box(cloth_a, k, p_min, p_max); });
+    build_hash(collision_b.vertices, N_b, grid, false, [&](int k, vec3& p_min, vec3& p_max) { return vertex_box(cloth_b, k, p_min, p_max); });
+    build_hash(collision_b.edges, 2 * N_b, grid, false, [&](int edge, vec3& p_min, vec3& p_max) {
+        if (!edge_exists(edge, N_x_b, N_y_b))
+            return false;
+        swept_edge_box(cloth_b, edge, 0.5f * thickness, p_min, p_max);
+        return overlap(p_min, p_max, region.p_min, region.p_max);
+    });
+
+    std::vector<cloth_collision_contact>& contacts = collision_a.contacts;
+    contacts.clear();
+    detect_vertex_triangle(cloth_b, cloth_a, collision_a.vertices, grid, region, thickness, true, contacts);
+    detect_vertex_triangle(cloth_a, cloth_b, collision_b.vertices, grid, region, thickness, false, contacts);
+    detect_edge_edge(cloth_a, cloth_b, collision_b.edges, grid, region, thickness, contacts);
+    if (contacts.empty())
+        return;
+
+    // Resolution in order, repeated as the contacts share vertices (a vertex left on the wrong side would stay there)
+    for (int iteration = 0; iteration < parameters.iterations; ++iteration)
+    {
+        for (cloth_collision_contact const& contact : contacts)
+        {
+            int a, b, c;
+            if (contact.type == 0) {
+                triangle_vertices(contact.b, N_x_b, a, b, c);
+                resolve_vertex_triangle(vertex_of(cloth_a, constraint_a, contact.a), vertex_of(cloth_b, constraint_b, a), vertex_of(cloth_b, constraint_b, b), vertex_of(cloth_b, constraint_b, c), contact.side, thickness);
+            }
+            else if (contact.type == 1) {
+                triangle_vertices(contact.a, N_x_a, a, b, c);
+                resolve_vertex_triangle(vertex_of(cloth_b, constraint_b, contact.b), vertex_of(cloth_a, constraint_a, a), vertex_of(cloth_a, constraint_a, b), vertex_of(cloth_a, constraint_a, c), contact.side, thickness);
+            }
+            else {
+                int p1, q1, p2, q2;
+                edge_vertices(contact.a, N_x_a, p1, q1);
+                edge_vertices(contact.b, N_x_b, p2, q2);
+                resolve_edge_edge(vertex_of(cloth_a, constraint_a, p1), vertex_of(cloth_a, constraint_a, q1), vertex_of(cloth_b, constraint_b, p2), vertex_of(cloth_b, constraint_b, q2), contact.side, thickness);
+            }
+        }
+    }
+    collision_a.contact_count += contacts.size();
+    collision_b.contact_count += contacts.size();
+}
+
+void simulation_cloth_collision(cloth_islands_structure const& islands, int island, cloth_structure* const* cloths, constraint_structure* const* constraints, cloth_collision_parameters const& parameters)
+{
+    int const k_begin = islands.island_start[island];
+    int const k_end = islands.island_start[island + 1];
+    if (!parameters.enabled || k_end - k_begin < 2)
+        return;
+
+    // Swept boxes of the cloths of the island (a diverging cloth is not processed)
+    std::vector<swept_box> boxes(k_end - k_begin);
+    std::vector<char> valid(k_end - k_begin);
+    for (int i = k_begin; i < k_end; ++i)
+    {
+        cloth_structure const& cloth = *cloths[islands.cloth_index[i]];
+        cloth_collision_structure const& collision = cloth.cloth_collision;
+        swept_box& b = boxes[i - k_begin];
+        cloth.bounding_box(0, cloth.position.size(), b.p_min, b.p_max);
+        b.p_min = component_min(b.p_min, collision.start_min);
+        b.p_max = component_max(b.p_max, collision.start_max);
+        valid[i - k_begin] = collision.start.size() == cloth.position.size() && finite_box(b.p_min, b.p_max);
+    }
+
+    for (int i = k_begin; i < k_end; ++i)
+    {
+        for (int j = i + 1; j < k_end; ++j)
+        {
+            if (!valid[i - k_begin] || !valid[j - k_begin])
+                continue;
+            int const a = islands.cloth_index[i];
+            int const b = islands.cloth_index[j];
+            collide_pair(*cloths[a], *constraints[a], *cloths[b], *constraints[b], boxes[i - k_begin], boxes[j - k_begin], parameters);
+        }
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "../cgp_headless.hpp"
+#include "../self_collision/self_collision.hpp"
+
+#include <vector>
+
+struct cloth_structure;
+struct constraint_structure;
+
+
+// Settings of the collisions between the cloths
+struct cloth_collision_parameters
+{
+    bool enabled = true;
+    float thickness = 0.25f; // minimal distance between two cloths, relative to the largest rest length of their springs
+    int iterations = 4;      // passes of resolution of the contacts
+};
+
+// Pair of primitives of two cloths in contact: vertex of one cloth - triangle of the other, or edge-edge (indices as in
+//  self_collision_contact). side is the side (+1 or -1) of the vertex relative to the triangle, or of the first edge
+//  relative to the second, at the beginning of the step.
+struct cloth_collision_contact
+{
+    int a;
+    int b;
+    int type; // 0: vertex of the first cloth - triangle of the second, 1: the opposite, 2: edge of each cloth
+    float side;
+};
+
+// Positions of a cloth at the beginning of a step and buffers of its collisions with the other cloths
+struct cloth_collision_structure
+{
+    cgp::numarray<cgp::vec3> start; // positions at the beginning of the step: side of the cloth at each contact
+    cgp::vec3 start_min;            // bounding box of the start positions
+    cgp::vec3 start_max;
+
+    self_collision_hash vertices; // swept vertices and edges of the cloth in the overlap with the other cloth of a pair
+    self_collision_hash edges;
+    std::vector<cloth_collision_contact> contacts; // contacts of a pair whose first cloth is this one
+
+    int contact_count = 0; // number of contacts with the other cloths during the last step (for display)
+};
+
+// Groups of cloths which can touch each other during the next steps: the cloths of the island k are
+//  cloth_index[island_start[k], island_start[k+1]). Two islands never interact and can be simulated concurrently.
+struct cloth_islands_structure
+{
+    std::vector<int> island_start;
+    std::vector<int> cloth_index;
+
+    std::vector<int> parent;       // union-find of the cloths
+    std::vector<cgp::vec3> box_min; // bounding boxes of the cloths inflated by their motion
+    std::vector<cgp::vec3> box_max;
+
+    int N_island() const;
+};
+
+
+// Group the cloths whose bounding boxes, inflated by the thickness and by the distance their vertices may cover during the
+//  next N_step steps (twice their largest displacement of the last step), overlap (union-find). Without collisions, each
+//  cloth is its own island.
+void simulation_cloth_islands(cloth_islands_structure& islands, cloth_structure* const* cloths, int N_cloth, cloth_collision_parameters const& parameters, int N_step);
+
+// Save the positions of the cloth at the beginning of a step: side of the contacts of the next collision
+void simulation_cloth_collision_begin_step(cloth_structure& cloth);
+
+// Push apart the cloths of an island after a step. Each pair of cloths whose swept bounding boxes overlap is tested in
+//  their overlap only: the swept vertices and edges of the cloths are sorted in spatial hashes, then each quad (edge)
+//  of a cloth queries the vertices (edges) of the other one. A vertex closer than the thickness to a triangle, or which
+//  crossed it, is moved back on its side at the beginning of the step (same for the edges), and its velocity
+//  towards the other cloth is cancelled.
+void simulation_cloth_collision(cloth_islands_structure const& islands, int island, cloth_structure* const* cloths, constraint_structure* const* constraints, cloth_collision_parameters const& parameters);
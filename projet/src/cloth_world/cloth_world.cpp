@@ -0,0 +1,102 @@
+#include "cloth_world.hpp"
+
+#include <atomic>
+
+using namespace cgp;
+
+
+void cloth_world_structure::initialize(std::vector<cloth_description> const& descriptions_arg, int N_sample)
+{
+    descriptions = descriptions_arg;
+    int const N_cloth = int(descriptions.size());
+    cloths.clear();
+    constraints.clear();
+    cloths.resize(N_cloth);
+    constraints.resize(N_cloth);
+
+    // The pointers are taken once the arrays are allocated: they stay valid until the next initialization
+    cloth_pointers.resize(N_cloth);
+    constraint_pointers.resize(N_cloth);
+    for (int k = 0; k < N_cloth; ++k) {
+        cloth_pointers[k] = &cloths[k];
+        constraint_pointers[k] = &constraints[k];
+    }
+    reset(N_sample);
+}
+
+void cloth_world_structure::reset(int N_sample)
+{
+    for (int k = 0; k < size(); ++k)
+        scene_description_initialize_cloth(descriptions[k], N_sample, cloths[k], constraints[k]);
+}
+
+void simulation_world_lod(cloth_world_structure& world, lod_view const& view, simulation_parameters const& parameters, std::vector<int>& switched)
+{
+    switched.clear();
+    for (int k = 0; k < world.size(); ++k) {
+        if (simulation_lod_update(world.cloths[k], world.constraints[k], view, parameters))
+            switched.push_back(k);
+    }
+}
+
+bool simulation_world_advance(cloth_world_structure& world, task_pool& tasks, simulation_parameters const& parameters, int N_step)
+{
+    int const N_cloth = world.size();
+    cloth_structure* const* cloths = world.cloth_pointers.data();
+    constraint_structure* const* constraints = world.constraint_pointers.data();
+    cloth_islands_structure& islands = world.islands;
+
+    for (int k = 0; k < N_cloth; ++k)
+        simulation_sleeping_check(world.cloths[k], world.constraints[k], parameters);
+    simulation_cloth_islands(islands, cloths, N_cloth, parameters.cloth_collision, N_step);
+
+    std::atomic<bool> diverged(false);
+    tasks.run(islands.N_island(), [&](int island)
+    {
+        if (!simulation_sleeping_island(islands, island, cloths))
+            return;
+        int const i_begin = islands.island_start[island];
+        int const i_end = islands.island_start[island + 1];
+        for (int k_step = 0; diverged == false && k_step < N_step; ++k_step)
+        {
+            for (int i = i_begin; i < i_end; ++i)
+            {
+                int const k_cloth = islands.cloth_index[i];
+                cloth_structure& cloth = *cloths[k_cloth];
+                if (cloth.sleeping.asleep) // fell asleep during the frame
+                    continue;
+
+                // Keep the state before the last step of the frame for the interpolation of the display
+                if (k_step == N_step - 1) {
+                    cloth.previous_position = cloth.position.data;
+                    cloth.previous_normal = cloth.normal.data;
+                }
+                simulation_cloth_collision_begin_step(cloth);
+
+                // With adaptive time steps, a cloth that cannot be advanced is halted alone
+                bool const success = simulation_advance(cloth, *constraints[k_cloth], parameters);
+                if (!success && !parameters.adaptive.enabled)
+                    diverged = true;
+            }
+
+            simulation_cloth_collision(islands, island, cloths, constraints, parameters.cloth_collision);
+            for (int i = i_begin; i < i_end; ++i)
+            {
+                int const k_cloth = islands.cloth_index[i];
+                if (cloths[k_cloth]->sleeping.asleep)
+                    continue;
+                cloths[k_cloth]->update_normal();
+                simulation_sleeping_update(*cloths[k_cloth], *constraints[k_cloth], parameters);
+            }
+        }
+    });
+    return !diverged;
+}
+
+int simulation_world_asleep(cloth_world_structure const& world)
+{
+    int asleep = 0;
+    for (cloth_structure const& cloth : world.cloths)
+        asleep += cloth.sleeping.asleep ? 1 : 0;
+    return asleep;
+}
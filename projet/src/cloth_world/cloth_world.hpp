@@ -0,0 +1,44 @@
+#pragma once
+
+#include "../cgp_headless.hpp"
+#include "../cloth/cloth.hpp"
+#include "../constraint/constraint.hpp"
+#include "../simulation/simulation.hpp"
+#include "../scene_description/scene_description.hpp"
+#include "../task_pool/task_pool.hpp"
+
+#include <vector>
+
+
+// All the cloths of the scene, in the order of their description: the state of the cloths and of their constraints is
+//  stored in contiguous arrays, and the stages of the simulation are passes over all of them. The arrays of pointers are
+//  the views taken by the passes over several cloths (islands, collisions, checkpoints and caches).
+struct cloth_world_structure
+{
+    std::vector<cloth_description> descriptions;
+    std::vector<cloth_structure> cloths;
+    std::vector<constraint_structure> constraints;
+    std::vector<cloth_structure*> cloth_pointers;
+    std::vector<constraint_structure*> constraint_pointers;
+    cloth_islands_structure islands; // islands of the last step
+
+    // Create the cloths of the descriptions in their initial position, with N_sample samples per edge
+    void initialize(std::vector<cloth_description> const& descriptions, int N_sample);
+    // Put the cloths back in their initial position
+    void reset(int N_sample);
+
+    int size() const { return int(cloths.size()); }
+};
+
+
+// Switch each cloth to its wanted level of detail. The indices of the cloths whose grid changed are written in switched.
+void simulation_world_lod(cloth_world_structure& world, lod_view const& view, simulation_parameters const& parameters, std::vector<int>& switched);
+
+// Advance all the cloths by N_step steps: the sleeping cloths are woken up if their surroundings changed, then each island
+//  of cloths which can touch each other is a task of the pool running the N_step steps (the cloths advanced one after the
+//  other, then pushed apart). The positions and normals before the last step are kept for the interpolation of the
+//  display. Returns false if a cloth diverged with fixed time steps (the other islands still complete their steps).
+bool simulation_world_advance(cloth_world_structure& world, task_pool& tasks, simulation_parameters const& parameters, int N_step);
+
+// Number of sleeping cloths
+int simulation_world_asleep(cloth_world_structure const& world);
@@ -0,0 +1,293 @@
+#include "clothesline.hpp"
+
+#include "../cloth/cloth.hpp"
+#include "../constraint/constraint.hpp"
+#include "../simd/parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace cgp;
+
+
+// The cloth is swept by tiles of tile_rows x tile_columns: only the tiles overlapping a wire are tested (in parallel if many)
+static int const tile_columns = 16;
+
+// Margin of the bounding boxes (covers the motion of the vertices by the other constraints since their update)
+static float const wire_margin = 0.05f;
+
+// Frame of the wire [a,b] (see simd_wire_parameters)
+static simd_wire_parameters wire_frame(vec3 const& a, vec3 const& b, float radius)
+{
+    vec3 const u = normalize(b - a);
+    vec3 const e1 = normalize(std::abs(u.z) < 0.9f ? cross(u, vec3(0, 0, 1)) : cross(u, vec3(1, 0, 0)));
+    vec3 const e2 = cross(u, e1);
+
+    simd_wire_parameters w;
+    w.ax = a.x; w.ay = a.y; w.az = a.z;
+    w.ux = u.x; w.uy = u.y; w.uz = u.z;
+    w.e1x = e1.x; w.e1y = e1.y; w.e1z = e1.z;
+    w.e2x = e2.x; w.e2y = e2.y; w.e2z = e2.z;
+    w.length = norm(b - a);
+    w.radius = radius;
+    return w;
+}
+
+// Coordinates (X,Y,S) of p in the frame of the wire, and back
+static vec3 wire_coordinates(simd_wire_parameters const& w, vec3 const& p)
+{
+    vec3 const d = p - vec3(w.ax, w.ay, w.az);
+    return { dot(d, vec3(w.e1x, w.e1y, w.e1z)), dot(d, vec3(w.e2x, w.e2y, w.e2z)), dot(d, vec3(w.ux, w.uy, w.uz)) };
+}
+
+static vec3 wire_point(simd_wire_parameters const& w, float X, float Y, float S)
+{
+    return vec3(w.ax, w.ay, w.az) + X * vec3(w.e1x, w.e1y, w.e1z) + Y * vec3(w.e2x, w.e2y, w.e2z) + S * vec3(w.ux, w.uy, w.uz);
+}
+
+// Lanes of the sweep from the start to the end positions
+static simd_sweep_lanes sweep_lanes(clothesline_structure& clothesline, int N_x, int N_y)
+{
+    simd_sweep_lanes sweep;
+    sweep.x0 = clothesline.start.x.data(); sweep.y0 = clothesline.start.y.data(); sweep.z0 = clothesline.start.z.data();
+    sweep.x1 = clothesline.end.x.data(); sweep.y1 = clothesline.end.y.data(); sweep.z1 = clothesline.end.z.data();
+    sweep.vertex_toi = clothesline.vertex_toi.data();
+    sweep.edge_toi_x = clothesline.edge_toi_x.data();
+    sweep.edge_toi_y = clothesline.edge_toi_y.data();
+    sweep.N_x = N_x;
+    sweep.N_y = N_y;
+    return sweep;
+}
+
+// Bounding boxes of the sweep of the tiles (with the first row and column of the next tiles, linked by the edges)
+static void tile_bounding_boxes(clothesline_structure& clothesline, simd_sweep_lanes const& sweep)
+{
+    int const N_x = sweep.N_x, N_y = sweep.N_y;
+    int const N_tile_x = (N_x + tile_columns - 1) / tile_columns;
+    int const N_tile = N_tile_x * ((N_y + tile_rows - 1) / tile_rows);
+    clothesline.tile_min.resize(N_tile);
+    clothesline.tile_max.resize(N_tile);
+
+    simd_kernel_table const& kernels = simd_kernels();
+    for (int t = 0; t < N_tile; ++t)
+    {
+        int const ku_begin = (t % N_tile_x) * tile_columns, ku_end = std::min(ku_begin + tile_columns + 1, N_x);
+        int const kv_begin = (t / N_tile_x) * tile_rows, kv_end = std::min(kv_begin + tile_rows + 1, N_y);
+        float box[6];
+        kernels.sweep_bounds(sweep, box, ku_begin, ku_end, kv_begin, kv_end);
+        clothesline.tile_min[t] = vec3(box[0], box[1], box[2]);
+        clothesline.tile_max[t] = vec3(box[3], box[4], box[5]);
+    }
+}
+
+static vec3 start_position(clothesline_structure const& clothesline, int k)
+{
+    return { clothesline.start.x[k], clothesline.start.y[k], clothesline.start.z[k] };
+}
+
+// The next wires are swept to the corrected positions. They stay in the swept tile boxes (up to the margin): the
+//  vertices are put back near their path, the edges are moved by about the radius.
+static void set_end_position(clothesline_structure& clothesline, int k, vec3 const& p)
+{
+    clothesline.end.x[k] = p.x;
+    clothesline.end.y[k] = p.y;
+    clothesline.end.z[k] = p.z;
+}
+
+// Inelastic contact: the velocity towards the wire along its normal n is removed. Otherwise the tension of a cloth folded
+//  over a wire keeps accelerating its vertices into it, and they move further at each substep.
+static void stop_velocity(vec3& velocity, vec3 const& n)
+{
+    float const v_n = dot(velocity, n);
+    if (v_n < 0.0f)
+        velocity -= v_n * n;
+}
+
+// Vertex k hitting the wire at the time toi: put back on the surface of the wire at the point of impact, then moved by
+//  the rest of its motion tangent to the surface (a vertex grazing the wire slides around it instead of being stopped at
+//  the impact, which would keep it in place while its tangential velocity grows), with its final position along the wire
+static void resolve_vertex(clothesline_structure const& clothesline, simd_wire_parameters const& w, int k, float toi, numarray<vec3>& position, numarray<vec3>& velocity)
+{
+    vec3 const c0 = wire_coordinates(w, start_position(clothesline, k));
+    vec3 const c1 = wire_coordinates(w, position[k]);
+    float X = c0.x + toi * (c1.x - c0.x);
+    float Y = c0.y + toi * (c1.y - c0.y);
+    float L = std::sqrt(X * X + Y * Y);
+    if (L < 1e-12f) {
+        X = c0.x;
+        Y = c0.y;
+        L = std::sqrt(X * X + Y * Y);
+    }
+    float const nx = X / L, ny = Y / L;
+
+    // Rest of the motion in the plane of the wire, without its component towards the wire (the tangent of the circle
+    //  stays outside of it)
+    float dx = (1 - toi) * (c1.x - c0.x), dy = (1 - toi) * (c1.y - c0.y);
+    float const d_n = dx * nx + dy * ny;
+    if (d_n < 0.0f) {
+        dx -= d_n * nx;
+        dy -= d_n * ny;
+    }
+    position[k] = wire_point(w, w.radius * nx + dx, w.radius * ny + dy, c1.z);
+    stop_velocity(velocity[k], nx * vec3(w.e1x, w.e1y, w.e1z) + ny * vec3(w.e2x, w.e2y, w.e2z));
+}
+
+// Edge (ka,kb) crossing the wire (or ending too close): moved back along its normal in the plane of the wire so that the
+//  wire is at the radius on its initial side. The displacement is shared between the extremities (position-based).
+static bool resolve_edge(clothesline_structure const& clothesline, constraint_structure const& constraint, simd_wire_parameters const& w, int ka, int kb, numarray<vec3>& position, numarray<vec3>& velocity)
+{
+    vec3 const P0 = wire_coordinates(w, start_position(clothesline, ka));
+    vec3 const Q0 = wire_coordinates(w, start_position(clothesline, kb));
+    vec3 const P1 = wire_coordinates(w, position[ka]);
+    vec3 const Q1 = wire_coordinates(w, position[kb]);
+
+    float const side = (P0.x * Q0.y - P0.y * Q0.x) > 0 ? 1.0f : -1.0f;
+    float const Dx = Q1.x - P1.x, Dy = Q1.y - P1.y;
+    float const L = std::sqrt(Dx * Dx + Dy * Dy);
+    if (L < w.radius)
+        return false;
+
+    // Signed distance of the wire to the line of the edge (already solved by the vertices if it is on the right side)
+    float const d = (P1.x * Q1.y - P1.y * Q1.x) / L;
+    if (side * d >= w.radius)
+        return false;
+
+    float const lambda = std::min(std::max(-(P1.x * Dx + P1.y * Dy) / (L * L), 0.0f), 1.0f);
+    float const wa = constraint.weight(ka);
+    float const wb = constraint.weight(kb);
+    float const denominator = wa * (1 - lambda) * (1 - lambda) + wb * lambda * lambda;
+    if (denominator == 0.0f)
+        return false;
+
+    float const delta = (d - side * w.radius) / denominator;
+    vec3 const m = (-Dy / L) * vec3(w.e1x, w.e1y, w.e1z) + (Dx / L) * vec3(w.e2x, w.e2y, w.e2z);
+    position[ka] += wa * (1 - lambda) * delta * m;
+    position[kb] += wb * lambda * delta * m;
+    vec3 const n = delta > 0 ? m : -m;
+    if (wa != 0.0f)
+        stop_velocity(velocity[ka], n);
+    if (wb != 0.0f)
+        stop_velocity(velocity[kb], n);
+    return true;
+}
+
+void simulation_clothesline_begin_step(cloth_structure& cloth)
+{
+    clothesline_structure& clothesline = cloth.clothesline;
+    clothesline.start.load(cloth.position.data);
+    clothesline.start_min = cloth.bounding_box_min;
+    clothesline.start_max = cloth.bounding_box_max;
+}
+
+void simulation_clothesline_collision(cloth_structure& cloth, constraint_structure const& constraint, std::vector<std::pair<vec3, vec3>> const& wires, clothesline_parameters const& parameters)
+{
+    clothesline_structure& clothesline = cloth.clothesline;
+    clothesline.contact_count = 0;
+    if (!parameters.enabled)
+        return;
+
+    numarray<vec3>& position = cloth.position.data;
+    numarray<vec3>& velocity = cloth.velocity.data;
+    int const N_x = cloth.N_samples_x();
+    int const N_y = cloth.N_samples_y();
+    int const N = N_x * N_y;
+    if (clothesline.start.size() != N) {
+        simulation_clothesline_begin_step(cloth);
+        return;
+    }
+
+    // Bounding box swept by the cloth
+    vec3 const& b0 = clothesline.start_min, & b1 = clothesline.start_max;
+    vec3 const& c0 = cloth.bounding_box_min, & c1 = cloth.bounding_box_max;
+    vec3 const p_min = vec3(std::min(b0.x, c0.x), std::min(b0.y, c0.y), std::min(b0.z, c0.z)) - vec3(wire_margin, wire_margin, wire_margin);
+    vec3 const p_max = vec3(std::max(b1.x, c1.x), std::max(b1.y, c1.y), std::max(b1.z, c1.z)) + vec3(wire_margin, wire_margin, wire_margin);
+
+    int const N_tile_x = (N_x + tile_columns - 1) / tile_columns;
+    int const N_tile = N_tile_x * ((N_y + tile_rows - 1) / tile_rows);
+    simd_sweep_lanes sweep;
+    bool end_loaded = false;
+    for (auto const& wire : wires)
+    {
+        vec3 const& a = wire.first;
+        vec3 const& b = wire.second;
+        float const r = parameters.radius;
+        if (std::min(a.x, b.x) - r > p_max.x || std::min(a.y, b.y) - r > p_max.y || std::min(a.z, b.z) - r > p_max.z ||
+            std::max(a.x, b.x) + r < p_min.x || std::max(a.y, b.y) + r < p_min.y || std::max(a.z, b.z) + r < p_min.z)
+            continue;
+
+        if (!end_loaded) {
+            clothesline.end.load(position);
+            clothesline.vertex_toi.resize(N);
+            clothesline.edge_toi_x.resize(N);
+            clothesline.edge_toi_y.resize(N);
+            sweep = sweep_lanes(clothesline, N_x, N_y);
+            tile_bounding_boxes(clothesline, sweep);
+            end_loaded = true;
+        }
+
+        // Tiles overlapping the wire
+        float const m = r + wire_margin;
+        clothesline.tile_active.clear();
+        for (int t = 0; t < N_tile; ++t) {
+            vec3 const& t0 = clothesline.tile_min[t];
+            vec3 const& t1 = clothesline.tile_max[t];
+            if (std::min(a.x, b.x) - m <= t1.x && std::min(a.y, b.y) - m <= t1.y && std::min(a.z, b.z) - m <= t1.z &&
+                std::max(a.x, b.x) + m >= t0.x && std::max(a.y, b.y) + m >= t0.y && std::max(a.z, b.z) + m >= t0.z)
+                clothesline.tile_active.push_back(t);
+        }
+        if (clothesline.tile_active.empty())
+            continue;
+
+        simd_wire_parameters const w = wire_frame(a, b, r);
+        simd_kernel_table const& kernels = simd_kernels();
+        int const N_active = int(clothesline.tile_active.size());
+        #pragma omp parallel for if(N_active * tile_rows * tile_columns >= parallel_vertex_threshold)
+        for (int i = 0; i < N_active; ++i) {
+            int const t = clothesline.tile_active[i];
+            int const ku_begin = (t % N_tile_x) * tile_columns, ku_end = std::min(ku_begin + tile_columns, N_x);
+            int const kv_begin = (t / N_tile_x) * tile_rows, kv_end = std::min(kv_begin + tile_rows, N_y);
+            kernels.wire_impact(sweep, w, ku_begin, ku_end, kv_begin, kv_end);
+        }
+
+        // Contacts: the vertices first, then the edges still crossing the wire
+        int contact_count = 0;
+        for (int pass = 0; pass < 3; ++pass)
+        {
+            float const* toi = pass == 0 ? sweep.vertex_toi : (pass == 1 ? sweep.edge_toi_x : sweep.edge_toi_y);
+            for (int t : clothesline.tile_active)
+            {
+                // Edges (k, k+1) of the last column and (k, k+N_x) of the last row do not exist
+                int const ku_begin = (t % N_tile_x) * tile_columns, ku_end = std::min(ku_begin + tile_columns, pass == 1 ? N_x - 1 : N_x);
+                int const kv_begin = (t / N_tile_x) * tile_rows, kv_end = std::min(kv_begin + tile_rows, pass == 2 ? N_y - 1 : N_y);
+                for (int kv = kv_begin; kv < kv_end; ++kv)
+                {
+                    for (int k = ku_begin + N_x * kv; k < ku_end + N_x * kv; ++k)
+                    {
+                        if (toi[k] > 1.0f)
+                            continue;
+                        if (pass == 0 && constraint.weight(k) != 0.0f) {
+                            resolve_vertex(clothesline, w, k, toi[k], position, velocity);
+                            set_end_position(clothesline, k, position[k]);
+                            contact_count++;
+                        }
+                        else if (pass > 0 && resolve_edge(clothesline, constraint, w, k, pass == 1 ? k + 1 : k + N_x, position, velocity)) {
+                            set_end_position(clothesline, k, position[k]);
+                            set_end_position(clothesline, pass == 1 ? k + 1 : k + N_x, position[pass == 1 ? k + 1 : k + N_x]);
+                            contact_count++;
+                        }
+                    }
+                }
+            }
+        }
+
+        clothesline.contact_count += contact_count;
+    }
+
+    // The current positions are the start of the next substep (the end positions are up to date if a wire was tested)
+    if (end_loaded)
+        std::swap(clothesline.start, clothesline.end);
+    else
+        clothesline.start.load(position);
+    clothesline.start_min = cloth.bounding_box_min;
+    clothesline.start_max = cloth.bounding_box_max;
+}
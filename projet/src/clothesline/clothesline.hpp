@@ -0,0 +1,46 @@
+#pragma once
+
+#include "../cgp_headless.hpp"
+#include "../simd/simd.hpp"
+
+#include <utility>
+#include <vector>
+
+struct cloth_structure;
+struct constraint_structure;
+
+
+// Settings of the collisions of the cloths with the wires of the clotheslines
+struct clothesline_parameters
+{
+    bool enabled = true;
+    float radius = 0.01f; // radius of the wires (as displayed)
+};
+
+// Positions swept by the cloth during a step and times of impact against the current wire (see simd_sweep_lanes)
+struct clothesline_structure
+{
+    simd_vec3_lanes start; // positions at the beginning of the step (or of the substep for XPBD)
+    simd_vec3_lanes end;   // positions after the solver
+    cgp::vec3 start_min;   // bounding box of the start positions
+    cgp::vec3 start_max;
+
+    simd_buffer vertex_toi;
+    simd_buffer edge_toi_x;
+    simd_buffer edge_toi_y;
+    std::vector<cgp::vec3> tile_min; // bounding boxes of the sweep of the tiles of the grid
+    std::vector<cgp::vec3> tile_max;
+    std::vector<int> tile_active;    // tiles overlapping the current wire
+
+    int contact_count = 0; // number of contacts of the last substep (for display)
+};
+
+
+// Save the positions of the cloth at the beginning of a step: start of the sweep of the next collision
+void simulation_clothesline_begin_step(cloth_structure& cloth);
+
+// Continuous collision of the vertices and edges of the cloth against the wires, swept from the start positions to the
+//  current ones. Only the wires overlapping the swept bounding box are tested, on the tiles of the grid overlapping them.
+//  The times of impact are computed by a vectorized kernel, the few contacts are then moved back on their side of the
+//  wire. The current positions become the start of the next sweep.
+void simulation_clothesline_collision(cloth_structure& cloth, constraint_structure const& constraint, std::vector<std::pair<cgp::vec3, cgp::vec3>> const& wires, clothesline_parameters const& parameters);
@@ -1,18 +1,39 @@
 #include "constraint.hpp"
 
+#include <algorithm>
+
 using namespace cgp;
 
-// Helper function to hash two integers into a single one for the map
-static size_t hash_pair(int ku, int kv)
+void constraint_structure::initialize(cloth_structure const& cloth)
 {
-	return size_t(ku) + 1000 * size_t(kv);
+	fixed_sample.clear();
+	inverse_mass.resize(cloth.position.size());
+	inverse_mass.fill({ 1, 1, 1 });
+	version++;
 }
 
 void constraint_structure::add_fixed_position(int ku, int kv, cloth_structure const& cloth)
 {
-	fixed_sample[hash_pair(ku, kv)] = { ku, kv, cloth.position(ku, kv) };
+	if (inverse_mass.size() != cloth.position.size())
+		initialize(cloth);
+
+	// Insertion in the order of the vertices (replace the position of a vertex already fixed)
+	int const k = ku + cloth.N_samples_x() * kv;
+	auto it = std::lower_bound(fixed_sample.begin(), fixed_sample.end(), k, [](position_contraint const& c, int k) { return c.k < k; });
+	if (it == fixed_sample.end() || it->k != k)
+		it = fixed_sample.insert(it, position_contraint());
+	*it = { ku, kv, k, cloth.position(ku, kv) };
+	inverse_mass[k] = { 0, 0, 0 };
+	version++;
 }
-void constraint_structure::remove_fixed_position(int ku, int kv)
+void constraint_structure::remove_fixed_position(int ku, int kv, cloth_structure const& cloth)
 {
-	fixed_sample.erase(hash_pair(ku, kv));
-}
\ No newline at end of file
+	// Same search as the insertion, in the order of the vertices
+	int const k = ku + cloth.N_samples_x() * kv;
+	auto it = std::lower_bound(fixed_sample.begin(), fixed_sample.end(), k, [](position_contraint const& c, int k) { return c.k < k; });
+	if (it == fixed_sample.end() || it->k != k)
+		return;
+	inverse_mass[k] = { 1, 1, 1 };
+	fixed_sample.erase(it);
+	version++;
+}
@@ -1,31 +1,42 @@
 #pragma once
 
-#include "cgp/cgp.hpp"
+#include "../cgp_headless.hpp"
 #include "../cloth/cloth.hpp"
 
+#include <vector>
+
 // Parameters of the colliding sphere (center, radius)
 struct sphere_parameter {
 	cgp::vec3 center;
 	float radius;
 };
 
-// Parameter attached to a fixed vertex (ku,kv) coordinates + 3D position
+// Parameter attached to a fixed vertex (ku,kv) coordinates, index k = ku + N_x kv in the cloth + 3D position
 struct position_contraint {
 	int ku;
 	int kv;
+	int k;
 	cgp::vec3 position;
 };
 
 
 struct constraint_structure
 {
-	float ground_z = 0.0f;                                   // Height of the flood
+	float ground_z = 0.0f;                                   // Height of the flood (registered as an obstacle, see simulation_initialize_obstacles)
 	
-	std::map<size_t, position_contraint> fixed_sample; // Storage of all fixed position of the cloth
+	std::vector<position_contraint> fixed_sample; // Storage of all fixed position of the cloth, sorted by vertex index
+	cgp::numarray<cgp::vec3> inverse_mass;         // Inverse mass of each vertex relative to a free one (0 for a fixed vertex, 1 otherwise), repeated
+	                                              //  on the 3 coordinates to weight the flat buffers of the integration
+	int version = 0;                               // Incremented at each change of the fixed positions (wakes the cloth up)
 
+	// Remove all the fixed positions of the cloth (to call before the first simulation step)
+	void initialize(cloth_structure const& cloth);
 	// Add a new fixed position
 	void add_fixed_position(int ku, int kv, cloth_structure const& cloth);
-	// Remove a fixed position
-	void remove_fixed_position(int ku, int kv);
+	// Remove a fixed position (if any)
+	void remove_fixed_position(int ku, int kv, cloth_structure const& cloth);
+
+	// Weight of the vertex k in the corrections of the collisions (0 if it is fixed)
+	float weight(int k) const { return inverse_mass[k].x; }
 
-};
\ No newline at end of file
+};
@@ -0,0 +1,172 @@
+#include "implicit.hpp"
+
+#include "../cloth/cloth.hpp"
+#include "../constraint/constraint.hpp"
+#include "../simd/parallel.hpp"
+
+#include <algorithm>
+
+using namespace cgp;
+
+
+// Product of the symmetric matrix J = (xx,yy,zz,xy,xz,yz) with the vector x
+static vec3 symmetric_product(float const* J, vec3 const& x)
+{
+    return { J[0] * x.x + J[3] * x.y + J[4] * x.z,
+             J[3] * x.x + J[1] * x.y + J[5] * x.z,
+             J[4] * x.x + J[5] * x.y + J[2] * x.z };
+}
+
+// Filter the components of the fixed vertices (they are not part of the unknowns): weighted by the inverse masses
+static void filter(std::vector<vec3>& x, numarray<vec3> const& inverse_mass)
+{
+    int const N = static_cast<int>(x.size());
+    for (int k = 0; k < N; ++k)
+        x[k] *= inverse_mass[k];
+}
+
+static float dot(std::vector<vec3> const& a, std::vector<vec3> const& b)
+{
+    int const N = static_cast<int>(a.size());
+    float s = 0.0f;
+    #pragma omp parallel for reduction(+:s) if(N > parallel_vertex_threshold)
+    for (int k = 0; k < N; ++k)
+        s += cgp::dot(a[k], b[k]);
+    return s;
+}
+
+// Add to y the product -alpha * (df/dx) x, where df/dx is assembled from the spring Jacobians
+//  The springs of the runs of a batch share no vertex: the scatter is done in parallel within a batch.
+static void add_stiffness_product(std::vector<vec3>& y, std::vector<vec3> const& x, float alpha, spring_structure const& springs, implicit_solver_structure const& solver)
+{
+    for (int b = 0; b < springs.N_batch(); ++b)
+    {
+        int const run_begin = springs.batch_offset[b];
+        int const run_end = springs.batch_offset[b + 1];
+        #pragma omp parallel for if(springs.N_springs > parallel_spring_threshold)
+        for (int r = run_begin; r < run_end; ++r)
+        {
+            spring_run const& run = springs.runs[r];
+            float const* J = &solver.jacobian[6 * springs.run_first_spring[r]];
+            for (int i = 0; i < run.count; ++i, J += 6)
+            {
+                int const ka = run.a + i;
+                int const kb = run.b + i;
+                vec3 const Jd = alpha * symmetric_product(J, x[kb] - x[ka]);
+                y[ka] -= Jd;
+                y[kb] += Jd;
+            }
+        }
+    }
+}
+
+
+void simulation_implicit_integration(cloth_structure& cloth, constraint_structure const& constraint, implicit_parameters const& parameters)
+{
+    implicit_solver_structure& solver = cloth.implicit_solver;
+    spring_structure const& springs = cloth.springs;
+
+    int const N = cloth.position.size();
+    float const h = parameters.dt;
+    float const m = cloth.mass_total / N;
+    float const K = cloth.K;
+    float const mass_diagonal = m * (1.0f + h * cloth.mu); // M - h df/dv, with the drag force f = -mu m v
+
+    numarray<vec3>& position = cloth.position.data;
+    numarray<vec3>& velocity = cloth.velocity.data;
+    numarray<vec3> const& force = cloth.force.data;
+
+    // Jacobian of each spring: df_a/dx_b = K ( c I + (1-c) u u^t ), c = max(0, 1-L0/L)
+    //  The transverse term is clamped for compressed springs to keep the system positive definite.
+    solver.jacobian.resize(6 * springs.N_springs);
+    #pragma omp parallel for if(springs.N_springs > parallel_spring_threshold)
+    for (int r = 0; r < static_cast<int>(springs.runs.size()); ++r)
+    {
+        spring_run const& run = springs.runs[r];
+        float* J = &solver.jacobian[6 * springs.run_first_spring[r]];
+        for (int i = 0; i < run.count; ++i, J += 6)
+        {
+            vec3 const d = position[run.b + i] - position[run.a + i];
+            float const L = norm(d);
+            vec3 const u = d / L;
+            float const c = std::max(0.0f, 1.0f - run.L0 / L);
+            J[0] = K * (c + (1 - c) * u.x * u.x);
+            J[1] = K * (c + (1 - c) * u.y * u.y);
+            J[2] = K * (c + (1 - c) * u.z * u.z);
+            J[3] = K * (1 - c) * u.x * u.y;
+            J[4] = K * (1 - c) * u.x * u.z;
+            J[5] = K * (1 - c) * u.y * u.z;
+        }
+    }
+
+    // Jacobi preconditioner: inverse of the diagonal of A = (M - h df/dv) - h^2 df/dx
+    solver.preconditioner.assign(N, { mass_diagonal, mass_diagonal, mass_diagonal });
+    for (size_t r = 0; r < springs.runs.size(); ++r)
+    {
+        spring_run const& run = springs.runs[r];
+        float const* J = &solver.jacobian[6 * springs.run_first_spring[r]];
+        for (int i = 0; i < run.count; ++i, J += 6)
+        {
+            vec3 const diagonal = h * h * vec3{ J[0], J[1], J[2] };
+            solver.preconditioner[run.a + i] += diagonal;
+            solver.preconditioner[run.b + i] += diagonal;
+        }
+    }
+    for (vec3& p : solver.preconditioner)
+        p = { 1.0f / p.x, 1.0f / p.y, 1.0f / p.z };
+
+    // Right hand side b = h f + h^2 (df/dx) v
+    std::vector<vec3>& r = solver.r;
+    r.resize(N);
+    for (int k = 0; k < N; ++k)
+        r[k] = h * force[k];
+    add_stiffness_product(r, velocity.data, -h * h, springs, solver);
+    filter(r, constraint.inverse_mass);
+
+    // Preconditioned conjugate gradient on A dv = b, starting from dv = 0
+    std::vector<vec3>& dv = solver.dv;
+    std::vector<vec3>& z = solver.z;
+    std::vector<vec3>& d = solver.d;
+    std::vector<vec3>& q = solver.q;
+    dv.assign(N, { 0, 0, 0 });
+    z.resize(N);
+    q.resize(N);
+    for (int k = 0; k < N; ++k)
+        z[k] = solver.preconditioner[k] * r[k];
+    d = z;
+
+    float delta = dot(r, z);
+    float const delta_stop = parameters.cg_tolerance * parameters.cg_tolerance * delta;
+
+    int iteration = 0;
+    for (; iteration < parameters.cg_iterations_max && delta > delta_stop; ++iteration)
+    {
+        // q = A d
+        for (int k = 0; k < N; ++k)
+            q[k] = mass_diagonal * d[k];
+        add_stiffness_product(q, d, h * h, springs, solver);
+        filter(q, constraint.inverse_mass);
+
+        float const alpha = delta / dot(d, q);
+        for (int k = 0; k < N; ++k) {
+            dv[k] += alpha * d[k];
+            r[k] -= alpha * q[k];
+            z[k] = solver.preconditioner[k] * r[k];
+        }
+
+        float const delta_new = dot(r, z);
+        float const beta = delta_new / delta;
+        for (int k = 0; k < N; ++k)
+            d[k] = z[k] + beta * d[k];
+        delta = delta_new;
+    }
+    solver.cg_iterations = iteration;
+
+    // Update velocity and position
+    for (int k = 0; k < N; ++k)
+    {
+        velocity[k] = constraint.inverse_mass[k] * (velocity[k] + dv[k]); // null velocity for the fixed vertices
+        position[k] += h * velocity[k];
+    }
+    cloth.update_bounding_box();
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "../cgp_headless.hpp"
+
+#include <vector>
+
+struct cloth_structure;
+struct constraint_structure;
+
+
+// Settings of the implicit integrator
+struct implicit_parameters
+{
+    float dt = 1.0f / 60.0f;       // time step (a single step per frame)
+    int cg_iterations_max = 100;   // maximal number of conjugate gradient iterations
+    float cg_tolerance = 1e-4f;    // relative residual at which the conjugate gradient stops
+};
+
+// Buffers used by the implicit integrator (kept between the steps to avoid reallocations)
+struct implicit_solver_structure
+{
+    std::vector<float> jacobian;            // df_a/dx_b of each spring as a symmetric 3x3 matrix (xx,yy,zz,xy,xz,yz)
+    std::vector<cgp::vec3> preconditioner;  // inverse of the diagonal of the system
+    std::vector<cgp::vec3> dv, r, z, d, q;  // conjugate gradient vectors
+
+    int cg_iterations = 0;                  // number of iterations of the last solve (for display)
+};
+
+
+// One step of backward Euler integration (Baraff & Witkin 98), to be called after simulation_compute_force.
+//  Solves (M - dt df/dv - dt^2 df/dx) dv = dt (f + dt df/dx v) with a matrix-free preconditioned conjugate gradient,
+//  using the analytic Jacobians of the springs. The fixed vertices of the constraint are filtered out of the solve.
+void simulation_implicit_integration(cloth_structure& cloth, constraint_structure const& constraint, implicit_parameters const& parameters);
@@ -0,0 +1,137 @@
+#include "lod.hpp"
+
+#include "../simulation/simulation.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace cgp;
+
+
+void lod_structure::initialize(std::vector<vec3> const& corners_arg, int N_sample)
+{
+    N_sample_finest = N_sample;
+    level = 0;
+    corners = corners_arg;
+    pin_uv.clear();
+    pin_position.clear();
+    constraint_version = -1;
+    switch_count = 0;
+}
+
+int lod_structure::N_sample(int level_arg) const
+{
+    int N = N_sample_finest;
+    for (int k = 0; k < level_arg && N > 4; ++k)
+        N = std::max(4, (N - 1) / 2 + 1);
+    return N;
+}
+
+// Bilinear interpolation of the values of a N_x x N_y grid at the grid coordinates (u,v) in [0,1]^2
+static vec3 resample(numarray<vec3> const& value, int N_x, int N_y, float u, float v)
+{
+    float const x = u * (N_x - 1);
+    float const y = v * (N_y - 1);
+    int const ku = std::min(int(x), N_x - 2);
+    int const kv = std::min(int(y), N_y - 2);
+    float const a = x - ku;
+    float const b = y - kv;
+    int const k = ku + N_x * kv;
+    return (1 - b) * ((1 - a) * value[k] + a * value[k + 1]) + b * ((1 - a) * value[k + N_x] + a * value[k + N_x + 1]);
+}
+
+int simulation_lod_level(cloth_structure const& cloth, lod_view const& view, simulation_parameters const& parameters)
+{
+    lod_parameters const& lod = parameters.lod;
+    int const levels = std::max(1, lod.levels);
+
+    // Number of samples per edge giving the wanted distance between the vertices on the screen
+    vec3 const center = 0.5f * (cloth.bounding_box_min + cloth.bounding_box_max);
+    float const radius = 0.5f * norm(cloth.bounding_box_max - cloth.bounding_box_min);
+    float const distance = std::max(norm(center - view.camera) - radius, 0.1f);
+    float const length = std::max(cloth.lenght_x, cloth.lenght_y);
+    float wanted = 1 + length / distance * view.pixels_per_radian / lod.pixels_per_sample;
+    if (lod.wind > 0)
+        wanted *= 1 + simulation_cloth_wind_speed(cloth, parameters) / lod.wind;
+
+    // Finer levels while the current one is too coarse, coarser ones while the next one is fine enough
+    int level = std::min(cloth.lod.level, levels - 1);
+    while (level > 0 && wanted > cloth.lod.N_sample(level) * (1 + lod.hysteresis))
+        level--;
+    while (level + 1 < levels && cloth.lod.N_sample(level + 1) < cloth.lod.N_sample(level) && wanted < cloth.lod.N_sample(level + 1) * (1 - lod.hysteresis))
+        level++;
+    return level;
+}
+
+void simulation_lod_switch(cloth_structure& cloth, constraint_structure& constraint, int level)
+{
+    lod_structure& lod = cloth.lod;
+    int const N_x = cloth.N_samples_x();
+    int const N_y = cloth.N_samples_y();
+
+    // Fixed positions in grid coordinates, read from the constraint only if it changed since the last switch: the
+    //  pins of the finest level are not lost through the coarse ones
+    if (constraint.version != lod.constraint_version) {
+        lod.pin_uv.clear();
+        lod.pin_position.clear();
+        for (position_contraint const& c : constraint.fixed_sample) {
+            lod.pin_uv.push_back({ c.ku / (N_x - 1.0f), c.kv / (N_y - 1.0f) });
+            lod.pin_position.push_back(c.position);
+        }
+    }
+
+    numarray<vec3> const position = cloth.position.data;
+    numarray<vec3> const velocity = cloth.velocity.data;
+    numarray<vec3> const previous_position = cloth.previous_position;
+
+    int const N = lod.N_sample(level);
+    cloth.initialize(N, lod.corners, cloth.lenght_x, cloth.lenght_y);
+    lod.level = level;
+    lod.switch_count++;
+
+    bool const has_previous = previous_position.size() == position.size();
+    if (has_previous)
+        cloth.previous_position.resize(N * N);
+    for (int kv = 0; kv < N; ++kv) {
+        for (int ku = 0; ku < N; ++ku) {
+            float const u = ku / (N - 1.0f);
+            float const v = kv / (N - 1.0f);
+            cloth.position(ku, kv) = resample(position, N_x, N_y, u, v);
+            cloth.velocity(ku, kv) = resample(velocity, N_x, N_y, u, v);
+            if (has_previous)
+                cloth.previous_position[ku + N * kv] = resample(previous_position, N_x, N_y, u, v);
+        }
+    }
+
+    // Pins on the nearest vertices: a vertex shared by several pins of a finer level keeps the closest one
+    constraint.initialize(cloth);
+    std::vector<float> pin_error(N * N, std::numeric_limits<float>::max());
+    for (size_t k = 0; k < lod.pin_uv.size(); ++k) {
+        vec2 const p = lod.pin_uv[k] * (N - 1.0f);
+        int const ku = int(std::lround(p.x));
+        int const kv = int(std::lround(p.y));
+        float const error = norm(p - vec2(ku, kv));
+        if (error >= pin_error[ku + N * kv])
+            continue;
+        pin_error[ku + N * kv] = error;
+        cloth.position(ku, kv) = lod.pin_position[k];
+        cloth.velocity(ku, kv) = { 0, 0, 0 };
+        constraint.add_fixed_position(ku, kv, cloth);
+    }
+    lod.constraint_version = constraint.version;
+
+    cloth.update_normal();
+    cloth.update_bounding_box();
+    if (has_previous)
+        cloth.previous_normal = cloth.normal.data;
+}
+
+bool simulation_lod_update(cloth_structure& cloth, constraint_structure& constraint, lod_view const& view, simulation_parameters const& parameters)
+{
+    int const level = parameters.lod.enabled ? simulation_lod_level(cloth, view, parameters) : 0;
+    if (level == cloth.lod.level)
+        return false;
+    simulation_lod_switch(cloth, constraint, level);
+    return true;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "../cgp_headless.hpp"
+
+#include <vector>
+
+struct cloth_structure;
+struct constraint_structure;
+struct simulation_parameters;
+
+
+// Settings of the levels of detail of the cloths
+struct lod_parameters
+{
+    bool enabled = false;
+    int levels = 3;                  // number of resolutions of each cloth, the finest one is the initial grid
+    float pixels_per_sample = 12.0f; // wanted distance on the screen between two neighboring vertices
+    float wind = 2.0f;               // air speed at the cloth doubling its wanted resolution
+    float hysteresis = 0.25f;        // relative margin around the resolution of a level before switching to it
+};
+
+// Point of view of the levels of detail
+struct lod_view
+{
+    cgp::vec3 camera;        // position of the camera
+    float pixels_per_radian; // height of the viewport divided by the vertical field of view
+};
+
+// Resolutions of a cloth and the state kept across the switches between them. The level k has N_sample(k) samples per
+//  edge: each level halves the number of intervals of the finer one (at least 4 samples).
+struct lod_structure
+{
+    int N_sample_finest = 0;
+    int level = 0;                  // current level of the cloth (0: finest)
+    std::vector<cgp::vec3> corners; // corners of the flat cloth (initialization of the grid of a level)
+
+    // Fixed positions in grid coordinates in [0,1]^2, independent of the level (read again when the pins change)
+    std::vector<cgp::vec2> pin_uv;
+    std::vector<cgp::vec3> pin_position;
+    int constraint_version = -1;
+
+    int switch_count = 0;
+
+    // Set the hierarchy of a cloth initialized with N_sample samples per edge (level 0)
+    void initialize(std::vector<cgp::vec3> const& corners, int N_sample);
+    int N_sample(int level) const;
+};
+
+
+// Level of detail wanted for the cloth: its grid should be displayed with parameters.lod.pixels_per_sample between two
+//  vertices, and twice as finely if the wind blows on it at parameters.lod.wind. The level only changes once the wanted
+//  resolution leaves the band of relative size parameters.lod.hysteresis around the resolution of the next level.
+int simulation_lod_level(cloth_structure const& cloth, lod_view const& view, simulation_parameters const& parameters);
+
+// Rebuild the cloth at another level: the positions, velocities and previous positions are resampled bilinearly on the
+//  new grid and the fixed positions are moved to the nearest vertices. The cloth is reinitialized (awake, no sweep).
+void simulation_lod_switch(cloth_structure& cloth, constraint_structure& constraint, int level);
+
+// Switch the cloth to its wanted level (to the finest one if the levels of detail are disabled). Returns true if the
+//  grid changed: its display has to be rebuilt.
+bool simulation_lod_update(cloth_structure& cloth, constraint_structure& constraint, lod_view const& view, simulation_parameters const& parameters);
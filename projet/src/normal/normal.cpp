@@ -0,0 +1,98 @@
+#include "normal.hpp"
+
+#include "../cloth/cloth.hpp"
+#include "../simd/parallel.hpp"
+
+#include <algorithm>
+
+using namespace cgp;
+
+
+void normal_incidence_structure::initialize(numarray<uint3> const& connectivity, int N_vertex)
+{
+    // Count the triangles of each vertex, then fill the rows in the order of the triangles
+    start.assign(N_vertex + 1, 0);
+    for (uint3 const& t : connectivity) {
+        for (unsigned int k : t)
+            start[k + 1]++;
+    }
+    for (int k = 0; k < N_vertex; ++k)
+        start[k + 1] += start[k];
+
+    triangle.resize(start[N_vertex]);
+    std::vector<int> fill(start.begin(), start.end() - 1);
+    for (int k_tri = 0; k_tri < int(connectivity.size()); ++k_tri) {
+        for (unsigned int k : connectivity[k_tri])
+            triangle[fill[k]++] = k_tri;
+    }
+}
+
+void simulation_normal_grid(cloth_structure& cloth)
+{
+    int const N_x = cloth.N_samples_x();
+    int const N_y = cloth.N_samples_y();
+    int const N_total = N_x * N_y;
+
+    cloth.position_lanes.resize(N_total);
+    cloth.normal_lanes.resize(N_total);
+    simd_normal_lanes lanes;
+    lanes.px = cloth.position_lanes.x.data(); lanes.py = cloth.position_lanes.y.data(); lanes.pz = cloth.position_lanes.z.data();
+    lanes.nx = cloth.normal_lanes.x.data(); lanes.ny = cloth.normal_lanes.y.data(); lanes.nz = cloth.normal_lanes.z.data();
+    lanes.N_x = N_x;
+    lanes.N_y = N_y;
+    simd_kernel_table const& kernels = simd_kernels();
+
+    if (N_total < parallel_vertex_threshold) {
+        cloth.position_lanes.load(cloth.position.data);
+        kernels.grid_normal(lanes, 0, N_y);
+        cloth.normal_lanes.store(cloth.normal.data);
+        return;
+    }
+
+    // Tiles of rows: the positions of the row before and after a tile are loaded by the neighboring tiles
+    int const N_tile = (N_y + tile_rows - 1) / tile_rows;
+    #pragma omp parallel for
+    for (int t = 0; t < N_tile; ++t) {
+        int const kv_begin = t * tile_rows;
+        int const kv_end = std::min(kv_begin + tile_rows, N_y);
+        cloth.position_lanes.load(cloth.position.data, N_x * kv_begin, N_x * kv_end);
+    }
+    #pragma omp parallel for
+    for (int t = 0; t < N_tile; ++t) {
+        int const kv_begin = t * tile_rows;
+        int const kv_end = std::min(kv_begin + tile_rows, N_y);
+        kernels.grid_normal(lanes, kv_begin, kv_end);
+        cloth.normal_lanes.store(cloth.normal.data, N_x * kv_begin, N_x * kv_end);
+    }
+}
+
+void simulation_normal_mesh(numarray<vec3> const& position, numarray<uint3> const& connectivity, normal_incidence_structure const& incidence, numarray<vec3>& normal)
+{
+    int const N = int(position.size());
+    assert_cgp(incidence.N_vertex() == N, "The incidence of the mesh does not match its vertices");
+    normal.resize(N);
+
+    #pragma omp parallel for if(N > parallel_vertex_threshold)
+    for (int k = 0; k < N; ++k)
+    {
+        // Unit normals of the non degenerated triangles of the vertex
+        vec3 n = { 0, 0, 0 };
+        for (int i = incidence.start[k]; i < incidence.start[k + 1]; ++i) {
+            uint3 const& face = connectivity[incidence.triangle[i]];
+            vec3 const& p0 = position[face[0]];
+            vec3 const p10 = position[face[1]] - p0;
+            vec3 const p20 = position[face[2]] - p0;
+            float const L10 = norm(p10);
+            float const L20 = norm(p20);
+            if (L10 <= 1e-6f || L20 <= 1e-6f)
+                continue;
+            vec3 const c = cross(p10 / L10, p20 / L20);
+            float const Lc = norm(c);
+            if (Lc > 1e-6f)
+                n += c / Lc;
+        }
+
+        float const L = norm(n);
+        normal[k] = L > 1e-6f ? n / L : n;
+    }
+}
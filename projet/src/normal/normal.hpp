@@ -0,0 +1,29 @@
+#pragma once
+
+#include "../cgp_headless.hpp"
+
+#include <vector>
+
+struct cloth_structure;
+
+
+// Triangles around each vertex of a mesh in compressed rows: the triangles of the vertex k are
+//  triangle[start[k], start[k+1]), in increasing order. Built once for a connectivity.
+struct normal_incidence_structure
+{
+    std::vector<int> start;
+    std::vector<int> triangle;
+
+    void initialize(cgp::numarray<cgp::uint3> const& connectivity, int N_vertex);
+    int N_vertex() const { return start.empty() ? 0 : int(start.size()) - 1; }
+};
+
+
+// Normals of a grid cloth gathered from the neighbors of each vertex (see simd_kernel_table::grid_normal): same normals
+//  as normal_per_vertex on the triangles of the grid, without the scatter of the triangles on their vertices. The rows
+//  of a large cloth are computed in parallel.
+void simulation_normal_grid(cloth_structure& cloth);
+
+// Normals of any triangle mesh: each vertex sums the unit normals of its triangles given by the incidence (vertices
+//  computed in parallel for a large mesh). Same normals as normal_per_vertex.
+void simulation_normal_mesh(cgp::numarray<cgp::vec3> const& position, cgp::numarray<cgp::uint3> const& connectivity, normal_incidence_structure const& incidence, cgp::numarray<cgp::vec3>& normal);
@@ -0,0 +1,183 @@
+#include "obstacle.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace cgp;
+
+
+// Distance kept above a plane after a collision
+static float const plane_margin = 0.001f;
+
+int obstacle_registry_structure::add_plane(vec3 const& normal, float offset)
+{
+    vec3 const n = normalize(normal);
+    planes.nx.push_back(n.x); planes.ny.push_back(n.y); planes.nz.push_back(n.z);
+    planes.offset.push_back(offset);
+    plane_version.push_back(++version);
+    return planes.size() - 1;
+}
+
+int obstacle_registry_structure::add_capsule(vec3 const& a, vec3 const& b, float radius)
+{
+    capsules.ax.push_back(0); capsules.ay.push_back(0); capsules.az.push_back(0);
+    capsules.bx.push_back(0); capsules.by.push_back(0); capsules.bz.push_back(0);
+    capsules.radius.push_back(0);
+    capsule_version.push_back(0);
+    set_capsule(capsules.size() - 1, a, b, radius);
+    return capsules.size() - 1;
+}
+
+int obstacle_registry_structure::add_sphere(vec3 const& center, float radius)
+{
+    spheres.cx.push_back(center.x); spheres.cy.push_back(center.y); spheres.cz.push_back(center.z);
+    spheres.radius.push_back(radius);
+    sphere_version.push_back(++version);
+    return spheres.size() - 1;
+}
+
+int obstacle_registry_structure::add_box(vec3 const& p_min, vec3 const& p_max)
+{
+    boxes.min_x.push_back(p_min.x); boxes.min_y.push_back(p_min.y); boxes.min_z.push_back(p_min.z);
+    boxes.max_x.push_back(p_max.x); boxes.max_y.push_back(p_max.y); boxes.max_z.push_back(p_max.z);
+    box_version.push_back(++version);
+    return boxes.size() - 1;
+}
+
+void obstacle_registry_structure::set_capsule(int k, vec3 const& a, vec3 const& b, float radius)
+{
+    assert_cgp(k >= 0 && k < capsules.size(), "Capsule index " + str(k) + " out of range");
+    bool const same = capsules.ax[k] == a.x && capsules.ay[k] == a.y && capsules.az[k] == a.z && capsules.bx[k] == b.x && capsules.by[k] == b.y && capsules.bz[k] == b.z && capsules.radius[k] == radius;
+    if (same && capsule_version[k] != 0)
+        return;
+    capsule_version[k] = ++version;
+    capsules.ax[k] = a.x; capsules.ay[k] = a.y; capsules.az[k] = a.z;
+    capsules.bx[k] = b.x; capsules.by[k] = b.y; capsules.bz[k] = b.z;
+    capsules.radius[k] = radius;
+}
+
+void obstacle_registry_structure::clear()
+{
+    int const last_version = version;
+    *this = obstacle_registry_structure();
+    version = last_version + 1;
+}
+
+int obstacle_registry_structure::last_change(obstacle_candidates_structure const& candidates) const
+{
+    int last = 0;
+    auto const update = [&last, this](std::vector<int> const& versions, std::vector<int> const& indices) {
+        for (int k : indices)
+            last = std::max(last, k < static_cast<int>(versions.size()) ? versions[k] : version + 1);
+    };
+    update(plane_version, candidates.planes);
+    update(capsule_version, candidates.capsules);
+    update(sphere_version, candidates.spheres);
+    update(box_version, candidates.boxes);
+    return last;
+}
+
+void obstacle_registry_structure::overlap(vec3 const& p_min_arg, vec3 const& p_max_arg, float margin, obstacle_candidates_structure& candidates) const
+{
+    vec3 const p_min = p_min_arg - vec3(margin, margin, margin);
+    vec3 const p_max = p_max_arg + vec3(margin, margin, margin);
+    auto const overlap_box = [&](float x0, float y0, float z0, float x1, float y1, float z1) {
+        return x0 <= p_max.x && x1 >= p_min.x && y0 <= p_max.y && y1 >= p_min.y && z0 <= p_max.z && z1 >= p_min.z;
+    };
+
+    candidates.planes.clear();
+    candidates.capsules.clear();
+    candidates.spheres.clear();
+    candidates.boxes.clear();
+
+    // Plane: the corner of the box the most inside the half-space is below the plane
+    for (int k = 0; k < planes.size(); ++k) {
+        float const nx = planes.nx[k], ny = planes.ny[k], nz = planes.nz[k];
+        float const d = nx * (nx < 0 ? p_max.x : p_min.x) + ny * (ny < 0 ? p_max.y : p_min.y) + nz * (nz < 0 ? p_max.z : p_min.z);
+        if (d < planes.offset[k])
+            candidates.planes.push_back(k);
+    }
+    for (int k = 0; k < capsules.size(); ++k) {
+        float const r = capsules.radius[k];
+        if (overlap_box(std::min(capsules.ax[k], capsules.bx[k]) - r, std::min(capsules.ay[k], capsules.by[k]) - r, std::min(capsules.az[k], capsules.bz[k]) - r,
+                        std::max(capsules.ax[k], capsules.bx[k]) + r, std::max(capsules.ay[k], capsules.by[k]) + r, std::max(capsules.az[k], capsules.bz[k]) + r))
+            candidates.capsules.push_back(k);
+    }
+    for (int k = 0; k < spheres.size(); ++k) {
+        float const r = spheres.radius[k];
+        if (overlap_box(spheres.cx[k] - r, spheres.cy[k] - r, spheres.cz[k] - r, spheres.cx[k] + r, spheres.cy[k] + r, spheres.cz[k] + r))
+            candidates.spheres.push_back(k);
+    }
+    for (int k = 0; k < boxes.size(); ++k) {
+        if (overlap_box(boxes.min_x[k], boxes.min_y[k], boxes.min_z[k], boxes.max_x[k], boxes.max_y[k], boxes.max_z[k]))
+            candidates.boxes.push_back(k);
+    }
+}
+
+void obstacle_registry_structure::collide(obstacle_candidates_structure const& candidates, vec3* position, int k_begin, int k_end) const
+{
+    // Planes: pushed just above the plane along its normal
+    for (int k : candidates.planes)
+    {
+        vec3 const n = { planes.nx[k], planes.ny[k], planes.nz[k] };
+        float const offset = planes.offset[k];
+        for (int i = k_begin; i < k_end; ++i) {
+            float const d = dot(n, position[i]);
+            if (d < offset)
+                position[i] += (offset + plane_margin - d) * n;
+        }
+    }
+
+    // Capsules: projected on the surface from the closest point of the segment
+    for (int k : candidates.capsules)
+    {
+        vec3 const a = { capsules.ax[k], capsules.ay[k], capsules.az[k] };
+        vec3 const ab = vec3{ capsules.bx[k], capsules.by[k], capsules.bz[k] } - a;
+        float const r = capsules.radius[k];
+        float const inv_ab2 = 1.0f / dot(ab, ab);
+        for (int i = k_begin; i < k_end; ++i) {
+            vec3& p = position[i];
+            float const t = std::min(std::max(dot(p - a, ab) * inv_ab2, 0.0f), 1.0f);
+            vec3 const c = a + t * ab;
+            vec3 const u = p - c;
+            float const d2 = dot(u, u);
+            if (d2 < r * r && d2 > 0)
+                p = c + (r / std::sqrt(d2)) * u;
+        }
+    }
+
+    for (int k : candidates.spheres)
+    {
+        vec3 const c = { spheres.cx[k], spheres.cy[k], spheres.cz[k] };
+        float const r = spheres.radius[k];
+        for (int i = k_begin; i < k_end; ++i) {
+            vec3& p = position[i];
+            vec3 const u = p - c;
+            float const d2 = dot(u, u);
+            if (d2 < r * r && d2 > 0)
+                p = c + (r / std::sqrt(d2)) * u;
+        }
+    }
+
+    // Boxes: pushed out through the closest face
+    for (int k : candidates.boxes)
+    {
+        vec3 const b_min = { boxes.min_x[k], boxes.min_y[k], boxes.min_z[k] };
+        vec3 const b_max = { boxes.max_x[k], boxes.max_y[k], boxes.max_z[k] };
+        for (int i = k_begin; i < k_end; ++i) {
+            vec3& p = position[i];
+            if (p.x <= b_min.x || p.x >= b_max.x || p.y <= b_min.y || p.y >= b_max.y || p.z <= b_min.z || p.z >= b_max.z)
+                continue;
+            int axis = 0;
+            float depth = b_max.x - b_min.x; // penetration to the closest face and its signed position
+            float face = 0;
+            for (int c = 0; c < 3; ++c) {
+                float const d_min = p[c] - b_min[c];
+                float const d_max = b_max[c] - p[c];
+                if (d_min < depth) { depth = d_min; axis = c; face = b_min[c]; }
+                if (d_max < depth) { depth = d_max; axis = c; face = b_max[c]; }
+            }
+            p[axis] = face;
+        }
+    }
+}
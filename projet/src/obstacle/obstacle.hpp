@@ -0,0 +1,83 @@
+#pragma once
+
+#include "../cgp_headless.hpp"
+
+#include <vector>
+
+
+// Obstacles of each type stored as structures of arrays: the obstacle k of a type is described by the element k of
+//  each array. The cloths only run the collision (narrowphase) against the obstacles overlapping their bounding box.
+
+// Half-spaces dot(n,p) >= offset, with n a unit normal
+struct obstacle_planes
+{
+    std::vector<float> nx, ny, nz, offset;
+    int size() const { return static_cast<int>(offset.size()); }
+};
+
+// Segments [a,b] with a radius
+struct obstacle_capsules
+{
+    std::vector<float> ax, ay, az, bx, by, bz, radius;
+    int size() const { return static_cast<int>(radius.size()); }
+};
+
+struct obstacle_spheres
+{
+    std::vector<float> cx, cy, cz, radius;
+    int size() const { return static_cast<int>(radius.size()); }
+};
+
+// Axis aligned boxes
+struct obstacle_boxes
+{
+    std::vector<float> min_x, min_y, min_z, max_x, max_y, max_z;
+    int size() const { return static_cast<int>(min_x.size()); }
+};
+
+// Indices of the obstacles of each type overlapping a bounding box (reused between the substeps to avoid allocations)
+struct obstacle_candidates_structure
+{
+    std::vector<int> planes;
+    std::vector<int> capsules;
+    std::vector<int> spheres;
+    std::vector<int> boxes;
+
+    bool empty() const { return planes.empty() && capsules.empty() && spheres.empty() && boxes.empty(); }
+};
+
+struct obstacle_registry_structure
+{
+    obstacle_planes planes;
+    obstacle_capsules capsules;
+    obstacle_spheres spheres;
+    obstacle_boxes boxes;
+
+    // Incremented at each change of the obstacles, and value at the last change of each obstacle (ex. the cloths at rest
+    //  are woken up by the changes of the obstacles around them)
+    int version = 0;
+    std::vector<int> plane_version;
+    std::vector<int> capsule_version;
+    std::vector<int> sphere_version;
+    std::vector<int> box_version;
+
+    // Add an obstacle, returns its index among the obstacles of the same type
+    int add_plane(cgp::vec3 const& normal, float offset);
+    int add_capsule(cgp::vec3 const& a, cgp::vec3 const& b, float radius);
+    int add_sphere(cgp::vec3 const& center, float radius);
+    int add_box(cgp::vec3 const& p_min, cgp::vec3 const& p_max);
+
+    // Move an existing capsule (ex. the fan)
+    void set_capsule(int k, cgp::vec3 const& a, cgp::vec3 const& b, float radius);
+
+    void clear(); // the version keeps increasing
+
+    // Latest change of the obstacles of the candidates (larger than version if one of them does not exist anymore)
+    int last_change(obstacle_candidates_structure const& candidates) const;
+
+    // Broadphase: obstacles overlapping the box [p_min, p_max] enlarged by margin
+    void overlap(cgp::vec3 const& p_min, cgp::vec3 const& p_max, float margin, obstacle_candidates_structure& candidates) const;
+
+    // Narrowphase: project the positions [k_begin, k_end) inside an obstacle of the candidates on its surface
+    void collide(obstacle_candidates_structure const& candidates, cgp::vec3* position, int k_begin, int k_end) const;
+};
@@ -0,0 +1,142 @@
+#include "projective.hpp"
+
+#include "../simulation/simulation.hpp"
+#include "../simd/parallel.hpp"
+
+using namespace cgp;
+
+
+// Weight of the positional constraints of the fixed vertices, relative to the other terms of the system
+static float const pin_weight_factor = 1e4f;
+
+// (Re)build the factorization if the topology, mass, time step, stiffness or fixed vertices changed
+static void update_factorization(projective_solver_structure& solver, cloth_structure const& cloth, std::vector<int> const& pinned, float h)
+{
+    spring_structure const& springs = cloth.springs;
+    int const N = cloth.position.size();
+    bool const up_to_date = !solver.cholesky.empty() && solver.N_vertex == N && solver.N_springs == springs.N_springs
+        && solver.mass == cloth.mass_total && solver.dt == h && solver.K == cloth.K && solver.pinned == pinned;
+    if (up_to_date)
+        return;
+
+    float const m = cloth.mass_total / N;
+    double const inertia_weight = m / (h * h);
+    double const pin_weight = pin_weight_factor * (inertia_weight + cloth.K);
+
+    std::vector<sparse_entry> entries;
+    entries.reserve(N + 3 * springs.N_springs);
+    for (int k = 0; k < N; ++k)
+        entries.push_back({ k, k, inertia_weight });
+    for (int k : pinned)
+        entries.push_back({ k, k, pin_weight });
+    for (spring_run const& run : springs.runs) {
+        for (int i = 0; i < run.count; ++i) {
+            int const a = run.a + i;
+            int const b = run.b + i;
+            entries.push_back({ a, a, cloth.K });
+            entries.push_back({ b, b, cloth.K });
+            entries.push_back({ a, b, -cloth.K });
+        }
+    }
+
+    bool const success = solver.cholesky.factorize(N, entries);
+    assert_cgp(success, "Projective dynamics: the system matrix is not positive definite");
+
+    solver.N_vertex = N;
+    solver.N_springs = springs.N_springs;
+    solver.mass = cloth.mass_total;
+    solver.dt = h;
+    solver.K = cloth.K;
+    solver.pinned = pinned;
+    solver.factorization_count++;
+}
+
+void simulation_projective_step(cloth_structure& cloth, constraint_structure const& constraint, simulation_parameters const& parameters)
+{
+    projective_solver_structure& solver = cloth.projective_solver;
+    spring_structure const& springs = cloth.springs;
+
+    int const N = cloth.position.size();
+    float const h = parameters.projective.dt;
+    float const m = cloth.mass_total / N;
+    float const K = cloth.K;
+    double const inertia_weight = m / (h * h);
+    double const pin_weight = pin_weight_factor * (inertia_weight + K);
+
+    numarray<vec3>& position = cloth.position.data;
+    numarray<vec3>& velocity = cloth.velocity.data;
+
+    // Fixed vertices (sorted by index)
+    std::vector<int> pinned;
+    std::vector<vec3> pinned_position;
+    for (position_contraint const& c : constraint.fixed_sample) {
+        pinned.push_back(c.k);
+        pinned_position.push_back(c.position);
+    }
+    update_factorization(solver, cloth, pinned, h);
+
+    // Inertia: predicted positions with the external forces (gravity, drag, wind)
+    simulation_compute_external_force(cloth, parameters);
+    solver.previous_position.assign(position.data.begin(), position.data.end());
+    solver.inertia.resize(N);
+    for (int k = 0; k < N; ++k) {
+        solver.inertia[k] = position.data[k] + h * velocity.data[k] + (h * h / m) * cloth.force.data.data[k];
+        position.data[k] = solver.inertia[k];
+    }
+
+    solver.projection.resize(springs.N_springs);
+    for (int c = 0; c < 3; ++c) {
+        solver.rhs[c].resize(N);
+        solver.work[c].resize(N);
+    }
+
+    for (int k_iteration = 0; k_iteration < parameters.projective.iterations; ++k_iteration)
+    {
+        // Local step: closest configuration of each spring at its rest length
+        #pragma omp parallel for if(springs.N_springs > parallel_spring_threshold)
+        for (int r = 0; r < static_cast<int>(springs.runs.size()); ++r)
+        {
+            spring_run const& run = springs.runs[r];
+            vec3* p = &solver.projection[springs.run_first_spring[r]];
+            for (int i = 0; i < run.count; ++i) {
+                vec3 const d = position.data[run.a + i] - position.data[run.b + i];
+                float const L = norm(d);
+                p[i] = L > 1e-8f ? (run.L0 / L) * d : d;
+            }
+        }
+
+        // Global step: right hand side M/h^2 s + sum_springs K A^t p + sum_pins w x_pin
+        for (int k = 0; k < N; ++k)
+            for (int c = 0; c < 3; ++c)
+                solver.rhs[c][k] = inertia_weight * solver.inertia[k][c];
+        for (size_t k = 0; k < pinned.size(); ++k)
+            for (int c = 0; c < 3; ++c)
+                solver.rhs[c][pinned[k]] += pin_weight * pinned_position[k][c];
+        for (size_t r = 0; r < springs.runs.size(); ++r)
+        {
+            spring_run const& run = springs.runs[r];
+            vec3 const* p = &solver.projection[springs.run_first_spring[r]];
+            for (int i = 0; i < run.count; ++i) {
+                for (int c = 0; c < 3; ++c) {
+                    solver.rhs[c][run.a + i] += K * p[i][c];
+                    solver.rhs[c][run.b + i] -= K * p[i][c];
+                }
+            }
+        }
+
+        // Two triangular solves for each coordinate
+        #pragma omp parallel for if(N > parallel_solve_threshold)
+        for (int c = 0; c < 3; ++c)
+            solver.cholesky.solve(solver.rhs[c].data(), solver.work[c].data());
+
+        for (int k = 0; k < N; ++k)
+            position.data[k] = { float(solver.rhs[0][k]), float(solver.rhs[1][k]), float(solver.rhs[2][k]) };
+    }
+
+    // Collisions and exact fixed positions, then velocity deduced from the displacement
+    cloth.update_bounding_box();
+    simulation_adaptive_measure(cloth, solver.previous_position.data());
+    simulation_apply_constraints(cloth, constraint, parameters);
+    for (int k = 0; k < N; ++k)
+        velocity.data[k] = (position.data[k] - solver.previous_position[k]) / h;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "../cgp_headless.hpp"
+#include "sparse_cholesky.hpp"
+
+#include <vector>
+
+struct cloth_structure;
+struct constraint_structure;
+struct simulation_parameters;
+
+
+// Settings of the projective dynamics solver
+struct projective_parameters
+{
+    float dt = 1.0f / 60.0f; // time step (a single step per frame)
+    int iterations = 10;     // number of local/global iterations per step
+};
+
+// Prefactored system and buffers of the projective dynamics solver
+struct projective_solver_structure
+{
+    // Cholesky factorization of M/dt^2 + sum_springs K A^t A + sum_pins w I (same matrix for x, y and z).
+    //  Nested dissection ordering: O(N log N) entries, so each solve costs O(N log N) and each factorization O(N^1.5)
+    sparse_cholesky cholesky;
+
+    // Values used to build the factorization: it is recomputed only if one of them changes
+    int N_vertex = 0;
+    int N_springs = 0;
+    float mass = 0.0f;
+    float dt = 0.0f;
+    float K = 0.0f;
+    std::vector<int> pinned;
+
+    std::vector<cgp::vec3> previous_position;
+    std::vector<cgp::vec3> inertia;     // predicted positions x + dt v + dt^2 f_ext/m
+    std::vector<cgp::vec3> projection;  // local projection of each spring
+    std::vector<double> rhs[3];         // right hand side (and solution) for x, y, z
+    std::vector<double> work[3];
+
+    int factorization_count = 0;        // number of factorizations done since the start (for display)
+};
+
+
+// One time step of projective dynamics (Bouaziz et al. 2014).
+//  The local step projects each spring to its rest length in parallel, the global step solves the prefactored
+//  system for the three coordinates. The constraints (fixed positions excluded) are applied at the end of the step.
+void simulation_projective_step(cloth_structure& cloth, constraint_structure const& constraint, simulation_parameters const& parameters);
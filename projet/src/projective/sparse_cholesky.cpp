@@ -0,0 +1,314 @@
+#include "sparse_cholesky.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+
+// Parts of the graph smaller than this are numbered as they are instead of being split again
+static size_t const dissection_leaf_size = 8;
+
+// Breadth first search from root within the vertices labelled id: level of each reached vertex (the others are left
+//  unchanged, at -1), reached lists the vertices by increasing level
+static void level_structure(int root, int id, std::vector<std::vector<int> > const& adjacency, std::vector<int> const& label, std::vector<int>& level, std::vector<int>& reached)
+{
+    reached.clear();
+    reached.push_back(root);
+    level[root] = 0;
+    for (size_t q = 0; q < reached.size(); ++q)
+    {
+        int const k = reached[q];
+        for (int n : adjacency[k]) {
+            if (label[n] == id && level[n] < 0) {
+                level[n] = level[k] + 1;
+                reached.push_back(n);
+            }
+        }
+    }
+}
+
+// Nested dissection ordering of the graph of the matrix (George 1973).
+//  Each part is split by the vertices of the middle level of a level structure rooted at a pseudo-peripheral vertex
+//  that are adjacent to the next level. The parts are numbered from the end: a separator comes after the two halves
+//  it separates, so that their elimination does not fill the entries between them.
+static std::vector<int> nested_dissection(int N, std::vector<std::vector<int> > const& adjacency)
+{
+    std::vector<int> order(N);
+    int position = N;
+    std::vector<int> label(N, 0);  // part of each vertex not numbered yet, -1 once numbered
+    std::vector<int> level(N, -1);
+    int label_count = 1;
+
+    std::vector<std::vector<int> > parts(1, std::vector<int>(N));
+    for (int k = 0; k < N; ++k)
+        parts[0][k] = k;
+
+    std::vector<int> reached;
+    std::vector<int> separator;
+    while (!parts.empty())
+    {
+        std::vector<int> part = std::move(parts.back());
+        parts.pop_back();
+        if (part.empty())
+            continue;
+        int const id = label[part[0]];
+
+        int depth = 0;
+        if (part.size() > dissection_leaf_size)
+        {
+            level_structure(part[0], id, adjacency, label, level, reached);
+
+            // Part not connected: its connected component containing part[0] and the rest are split apart
+            if (reached.size() < part.size()) {
+                int const component_id = label_count++;
+                int const rest_id = label_count++;
+                std::vector<int> rest;
+                for (int k : reached) {
+                    label[k] = component_id;
+                    level[k] = -1;
+                }
+                for (int k : part) {
+                    if (label[k] == id) {
+                        label[k] = rest_id;
+                        rest.push_back(k);
+                    }
+                }
+                parts.push_back(reached);
+                parts.push_back(std::move(rest));
+                continue;
+            }
+
+            // Pseudo-peripheral root: restart from a vertex of minimal degree of the last level while the depth grows
+            depth = level[reached.back()];
+            for (int iteration = 0; iteration < 4; ++iteration)
+            {
+                int candidate = reached.back();
+                for (size_t q = reached.size(); q > 0 && level[reached[q - 1]] == depth; --q)
+                    if (adjacency[reached[q - 1]].size() < adjacency[candidate].size())
+                        candidate = reached[q - 1];
+                for (int k : reached)
+                    level[k] = -1;
+                level_structure(candidate, id, adjacency, label, level, reached);
+
+                int const candidate_depth = level[reached.back()];
+                bool const deeper = candidate_depth > depth;
+                depth = candidate_depth;
+                if (!deeper)
+                    break;
+            }
+        }
+
+        // Too small or too compact to be split: numbered as it is
+        if (depth < 2) {
+            for (int k : part) {
+                order[--position] = k;
+                label[k] = -1;
+                level[k] = -1;
+            }
+            continue;
+        }
+
+        int const middle = depth / 2;
+        std::vector<int> low;
+        std::vector<int> high;
+        separator.clear();
+        for (int k : reached)
+        {
+            if (level[k] < middle)
+                low.push_back(k);
+            else if (level[k] > middle)
+                high.push_back(k);
+            else {
+                bool const adjacent_to_high = std::any_of(adjacency[k].begin(), adjacency[k].end(), [&](int n) { return label[n] == id && level[n] == middle + 1; });
+                if (adjacent_to_high)
+                    separator.push_back(k);
+                else
+                    low.push_back(k);
+            }
+        }
+
+        for (int k : reached)
+            level[k] = -1;
+        for (int k : separator) {
+            order[--position] = k;
+            label[k] = -1;
+        }
+        int const low_id = label_count++;
+        int const high_id = label_count++;
+        for (int k : low)
+            label[k] = low_id;
+        for (int k : high)
+            label[k] = high_id;
+        parts.push_back(std::move(low));
+        parts.push_back(std::move(high));
+    }
+
+    return order;
+}
+
+// Non-zero columns of the row k of L (diagonal excluded), given by the paths from the entries of the column k of the
+//  upper part of A to k in the elimination tree. They are written in stack[top, N) in topological order, top is returned.
+static int row_pattern(int k, int N, std::vector<size_t> const& upper_offset, std::vector<int> const& upper_row, std::vector<int> const& parent, std::vector<int>& mark, std::vector<int>& stack)
+{
+    int top = N;
+    mark[k] = k;
+    for (size_t p = upper_offset[k]; p < upper_offset[k + 1]; ++p)
+    {
+        int length = 0;
+        for (int i = upper_row[p]; mark[i] != k; i = parent[i]) {
+            stack[length++] = i;
+            mark[i] = k;
+        }
+        while (length > 0)
+            stack[--top] = stack[--length];
+    }
+    return top;
+}
+
+bool sparse_cholesky::factorize(int N_arg, std::vector<sparse_entry> const& entries)
+{
+    N = N_arg;
+
+    // Graph of the matrix and ordering
+    std::vector<std::vector<int> > adjacency(N);
+    for (sparse_entry const& e : entries) {
+        if (e.i != e.j) {
+            adjacency[e.i].push_back(e.j);
+            adjacency[e.j].push_back(e.i);
+        }
+    }
+    for (std::vector<int>& a : adjacency) {
+        std::sort(a.begin(), a.end());
+        a.erase(std::unique(a.begin(), a.end()), a.end());
+    }
+    permutation = nested_dissection(N, adjacency);
+    std::vector<int> inverse(N);
+    for (int k = 0; k < N; ++k)
+        inverse[permutation[k]] = k;
+
+    // Upper triangular part of A in the new ordering, stored by columns (duplicates are kept and summed when scattered)
+    std::vector<size_t> upper_offset(N + 1, 0);
+    for (sparse_entry const& e : entries)
+        upper_offset[std::max(inverse[e.i], inverse[e.j]) + 1]++;
+    for (int j = 0; j < N; ++j)
+        upper_offset[j + 1] += upper_offset[j];
+    std::vector<int> upper_row(entries.size());
+    std::vector<double> upper_value(entries.size());
+    std::vector<size_t> next(upper_offset.begin(), upper_offset.end() - 1);
+    for (sparse_entry const& e : entries) {
+        int const j = std::max(inverse[e.i], inverse[e.j]);
+        size_t const p = next[j]++;
+        upper_row[p] = std::min(inverse[e.i], inverse[e.j]);
+        upper_value[p] = e.value;
+    }
+
+    // Elimination tree (Liu 1986): parent of each column of L, with path compression through ancestor
+    std::vector<int> parent(N, -1);
+    std::vector<int> ancestor(N, -1);
+    for (int k = 0; k < N; ++k)
+    {
+        for (size_t p = upper_offset[k]; p < upper_offset[k + 1]; ++p)
+        {
+            int i = upper_row[p];
+            while (i != -1 && i < k) {
+                int const next_i = ancestor[i];
+                ancestor[i] = k;
+                if (next_i == -1)
+                    parent[i] = k;
+                i = next_i;
+            }
+        }
+    }
+
+    // Number of entries in each column of L, from the pattern of each row
+    std::vector<int> mark(N, -1);
+    std::vector<int> stack(N);
+    column_offset.assign(N + 1, 0);
+    for (int k = 0; k < N; ++k) {
+        column_offset[k + 1]++;
+        for (int q = row_pattern(k, N, upper_offset, upper_row, parent, mark, stack); q < N; ++q)
+            column_offset[stack[q] + 1]++;
+    }
+    for (int j = 0; j < N; ++j)
+        column_offset[j + 1] += column_offset[j];
+    row.resize(column_offset[N]);
+    values.resize(column_offset[N]);
+
+    // Up-looking factorization: the row k of L is solved from the columns already computed, then appended to them.
+    //  The diagonal is the first entry of each column since the column j only receives the rows k > j afterwards.
+    next.assign(column_offset.begin(), column_offset.end() - 1);
+    std::vector<double> x(N, 0.0);
+    std::fill(mark.begin(), mark.end(), -1);
+    for (int k = 0; k < N; ++k)
+    {
+        int top = row_pattern(k, N, upper_offset, upper_row, parent, mark, stack);
+        for (size_t p = upper_offset[k]; p < upper_offset[k + 1]; ++p)
+            x[upper_row[p]] += upper_value[p];
+
+        double d = x[k];
+        x[k] = 0.0;
+        for (; top < N; ++top)
+        {
+            int const i = stack[top];
+            double const lki = x[i] / values[column_offset[i]];
+            x[i] = 0.0;
+            for (size_t p = column_offset[i] + 1; p < next[i]; ++p)
+                x[row[p]] -= values[p] * lki;
+            d -= lki * lki;
+
+            size_t const p = next[i]++;
+            row[p] = k;
+            values[p] = lki;
+        }
+
+        if (d <= 0.0) {
+            clear();
+            return false;
+        }
+        size_t const p = next[k]++;
+        row[p] = k;
+        values[p] = std::sqrt(d);
+    }
+
+    return true;
+}
+
+void sparse_cholesky::solve(double* b, double* y) const
+{
+    for (int i = 0; i < N; ++i)
+        y[i] = b[permutation[i]];
+
+    // L y' = y (by columns)
+    for (int j = 0; j < N; ++j)
+    {
+        y[j] /= values[column_offset[j]];
+        double const yj = y[j];
+        for (size_t p = column_offset[j] + 1; p < column_offset[j + 1]; ++p)
+            y[row[p]] -= values[p] * yj;
+    }
+
+    // L^t x = y'
+    for (int j = N - 1; j >= 0; --j)
+    {
+        double s = y[j];
+        for (size_t p = column_offset[j] + 1; p < column_offset[j + 1]; ++p)
+            s -= values[p] * y[row[p]];
+        y[j] = s / values[column_offset[j]];
+    }
+
+    for (int i = 0; i < N; ++i)
+        b[permutation[i]] = y[i];
+}
+
+void sparse_cholesky::clear()
+{
+    N = 0;
+    permutation.clear();
+    column_offset.clear();
+    row.clear();
+    values.clear();
+}
+
+bool sparse_cholesky::empty() const
+{
+    return N == 0;
+}
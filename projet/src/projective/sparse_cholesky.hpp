@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+
+// Non-zero entry (i,j) of a symmetric matrix. Only one of (i,j) or (j,i) needs to be given, duplicates are summed.
+struct sparse_entry {
+    int i;
+    int j;
+    double value;
+};
+
+// Cholesky factorization A = L L^t of a sparse symmetric positive definite matrix.
+//  The unknowns are first reordered by nested dissection to reduce the fill-in: the graph of the matrix is split
+//  recursively by separators, numbered after the two halves they separate. The structure of L is then computed from
+//  the elimination tree, and L is filled row by row (up-looking factorization) and stored by columns.
+//  On the grid of a cloth of N vertices, L has O(N log N) entries: a solve costs O(N log N) and a factorization O(N^1.5).
+//  The factorization is done once, each solve is then two triangular solves.
+struct sparse_cholesky
+{
+    int N = 0;
+    std::vector<int> permutation;      // permutation[new index] = original index
+    std::vector<size_t> column_offset; // entries of the column j of L in [column_offset[j], column_offset[j+1]), diagonal first
+    std::vector<int> row;              // row of each entry of L (in the new ordering)
+    std::vector<double> values;        // entries of L
+
+    // Returns false if the matrix is not positive definite
+    bool factorize(int N, std::vector<sparse_entry> const& entries);
+
+    // Solve A x = b in place (b and x in the original ordering), work must have N elements
+    void solve(double* b, double* work) const;
+
+    void clear();
+    bool empty() const;
+};
@@ -9,26 +9,29 @@ void scene_structure::initialize()
 	camera_control.set_rotation_axis_z();
 	camera_control.look_at({ 15, 0, 10 }, {0,0,0}, {0,0,1});
 	global_frame.initialize_data_on_gpu(mesh_primitive_frame());
+	simulation_tasks.initialize(); // one worker per hardware thread
+	float const ground_z = constraint_structure().ground_z;
+	simulation_initialize_obstacles(parameters, ground_z); // floor, fan and clothesline poles
 
 	obstacle_floor.initialize_data_on_gpu(mesh_primitive_quadrangle({ -10,-10,0 }, { -10,10,0 }, { 10,10,0 }, { 10,-10,0 }));
 	obstacle_floor.texture.load_and_initialize_texture_2d_on_gpu(project::path+"assets/ground.jpg", GL_REPEAT, GL_REPEAT);
-	obstacle_floor.model.translation = { 0,0,constraintF1.ground_z };
+	obstacle_floor.model.translation = { 0,0,ground_z };
 	obstacle_floor.material.texture_settings.two_sided = true;
 
 	mesh laundry_pin_mesh = mesh_load_file_obj("assets/laundry_pin.obj");
 	pin_fixed_position.initialize_data_on_gpu(laundry_pin_mesh);
 	pin_fixed_position.model.scaling = 0.1f;
 	pin_fixed_position.texture.load_and_initialize_texture_2d_on_gpu(project::path+"assets/laundry_pin_wood.jpg");
-	pin_fixed_position.model.translation = { 0,0,constraintF1.ground_z};
+	pin_fixed_position.model.translation = { 0,0,ground_z};
 	pin_fixed_position.model.rotation = rotation_transform::from_axis_angle({ 0,0,1 }, Pi / 2) * rotation_transform::from_axis_angle({ 1,0,0 }, Pi / 2);
 
 	// Clothesline
 
 	line.initialize_data_on_gpu(mesh_primitive_cylinder(0.01f, { -7,-8,6 }, { -7,8,6 }, 10, 20, true));
 	line.material.color = { 0.5f, 0.5f, 0.5f };
-	left_pole.initialize_data_on_gpu(mesh_primitive_cylinder(0.1f, { -7,-8,6.5f }, { -7,-8, constraintF1.ground_z }, 10, 20, true));
+	left_pole.initialize_data_on_gpu(mesh_primitive_cylinder(0.1f, { -7,-8,6.5f }, { -7,-8, ground_z }, 10, 20, true));
 	left_pole.texture.load_and_initialize_texture_2d_on_gpu(project::path+"assets/wood.jpg");
-	right_pole.initialize_data_on_gpu(mesh_primitive_cylinder(0.1f, { -7,8,6.5f }, { -7,8, constraintF1.ground_z }, 10, 20, true));
+	right_pole.initialize_data_on_gpu(mesh_primitive_cylinder(0.1f, { -7,8,6.5f }, { -7,8, ground_z }, 10, 20, true));
 	right_pole.texture.load_and_initialize_texture_2d_on_gpu(project::path+"assets/wood.jpg");
 
 	hierarchy_clothesline.add(line, "line");
@@ -39,9 +42,9 @@ void scene_structure::initialize()
 
 	little_line.initialize_data_on_gpu(mesh_primitive_cylinder(0.01f, { 4,2,6 }, { 4,6,6 }, 10, 20, true));
 	little_line.material.color = { 0.5f, 0.5f, 0.5f };
-	little_left_pole.initialize_data_on_gpu(mesh_primitive_cylinder(0.1f, { 4,2,6.5f }, { 4,2, constraintF1.ground_z }, 10, 20, true));
+	little_left_pole.initialize_data_on_gpu(mesh_primitive_cylinder(0.1f, { 4,2,6.5f }, { 4,2, ground_z }, 10, 20, true));
 	little_left_pole.texture.load_and_initialize_texture_2d_on_gpu(project::path+"assets/wood.jpg");
-	little_right_pole.initialize_data_on_gpu(mesh_primitive_cylinder(0.1f, { 4,6,6.5f }, { 4,6, constraintF1.ground_z }, 10, 20, true));
+	little_right_pole.initialize_data_on_gpu(mesh_primitive_cylinder(0.1f, { 4,6,6.5f }, { 4,6, ground_z }, 10, 20, true));
 	little_right_pole.texture.load_and_initialize_texture_2d_on_gpu(project::path+"assets/wood.jpg");
 
 	hierarchy_little_clothesline.add(little_line, "little_line");
@@ -53,7 +56,7 @@ void scene_structure::initialize()
 	mesh fan_base_mesh = mesh_load_file_obj("assets/fan_base.obj");
 	fan_base.initialize_data_on_gpu(fan_base_mesh);
 	fan_base.texture.load_and_initialize_texture_2d_on_gpu(project::path+"assets/fan_col.png");
-	fan_base.model.translation = { 0,0,constraintF1.ground_z};
+	fan_base.model.translation = { 0,0,ground_z};
 	fan_base.model.scaling = 0.3f;
 	fan_base.model.rotation = rotation_transform::from_axis_angle({ 1,0,0 }, Pi / 2);
 
@@ -84,82 +87,32 @@ void scene_structure::initialize()
 	initialize_cloths();
 }
 
-// Compute a new cloth in its initial position (can be called multiple times)
-void scene_structure::initialize_cloth(int N_sample, cloth_structure &cloth, cloth_structure_drawable &cloth_drawable, constraint_structure &constraint, std::vector<vec3> pos, float x_lenght, float y_lenght)
+// Display of a cloth of the world (can be called multiple times)
+void scene_structure::initialize_cloth_drawable(int k)
 {
-	cloth.initialize(N_sample, pos, x_lenght, y_lenght);
-	cloth_drawable.initialize(N_sample, x_lenght, y_lenght);
-	cloth_drawable.drawable.texture = cloth.texture;
-	cloth_drawable.drawable.material.texture_settings.two_sided = true;
+	cloth_description const& description = world.descriptions[k];
+	cloth_structure_drawable& cloth_drawable = cloth_drawables[k];
 
-	constraint.fixed_sample.clear();
-	
-	constraint.add_fixed_position(0, 2, cloth);
-	constraint.add_fixed_position(0, N_sample - 3, cloth);
-	constraint.add_fixed_position(1, 2, cloth);
-	constraint.add_fixed_position(1, N_sample - 3, cloth);
-	constraint.add_fixed_position(2, 2, cloth);
-	constraint.add_fixed_position(2, N_sample - 3, cloth);
+	cloth_drawable.initialize(world.cloths[k].N_samples_x(), description.length_x, description.length_y);
+	if (description.texture_repeat)
+		cloth_drawable.drawable.texture.load_and_initialize_texture_2d_on_gpu(project::path + description.texture, GL_REPEAT, GL_REPEAT);
+	else
+		cloth_drawable.drawable.texture.load_and_initialize_texture_2d_on_gpu(project::path + description.texture);
+	cloth_drawable.drawable.material.texture_settings.two_sided = true;
 }
 
+// Compute the cloths in their initial position (can be called multiple times)
 void scene_structure::initialize_cloths()
 {
-	// On clothesline in front of the fan
-
-	clothF1.texture.load_and_initialize_texture_2d_on_gpu(project::path + "assets/picnic.jpg", GL_REPEAT, GL_REPEAT);
-	clothF1.mass_total = 0.8f;
-	initialize_cloth(gui.N_sample_edge, clothF1, cloth_drawableF1, constraintF1, { {-8,-2,6}, {-8,-7,6}, {-8,-7,1.2f}, {-8,-2,1.2f} }, 5, 5);
-
-	clothF2.texture.load_and_initialize_texture_2d_on_gpu(project::path+"assets/towel.jpg", GL_REPEAT, GL_REPEAT);
-	clothF2.mass_total = 0.5f;
-	initialize_cloth(gui.N_sample_edge, clothF2, cloth_drawableF2, constraintF2, { {-8,7,6}, {-8,2,6}, {-8,2,4.2}, {-8,7,4.2} }, 2, 5);
-
-	clothF3.texture.load_and_initialize_texture_2d_on_gpu(project::path+"assets/blue.png", GL_REPEAT, GL_REPEAT);
-	clothF3.mass_total = 0.3f;
-	initialize_cloth(gui.N_sample_edge, clothF3, cloth_drawableF3, constraintF3, { {-8,1,6}, {-8,-1,6}, {-8,-1,3.2}, {-8,1,3.2} }, 3, 2);
-
-	// On clothesline right of the fan
-
-	clothR1.texture.load_and_initialize_texture_2d_on_gpu(project::path+"assets/tartan2.jpg", GL_REPEAT, GL_REPEAT);
-	clothR1.mass_total = 0.8f;
-	initialize_cloth(gui.N_sample_edge, clothR1, cloth_drawableR1, constraintR1, { {-7,8,6}, {-2,8,6}, {-2,8,1.2}, {-7,8,1.2} }, 5, 5);
-
-	clothR2.texture.load_and_initialize_texture_2d_on_gpu(project::path+"assets/green.jpg", GL_REPEAT, GL_REPEAT);
-	clothR2.mass_total = 0.65f;
-	initialize_cloth(gui.N_sample_edge, clothR2, cloth_drawableR2, constraintR2, { {-1,8,6}, {3,8,6}, {3,8,2.2}, {-1,8,2.2} }, 4, 4);
-
-	clothR3.texture.load_and_initialize_texture_2d_on_gpu(project::path+"assets/towel.jpg", GL_REPEAT, GL_REPEAT);
-	clothR3.mass_total = 0.45f;
-	initialize_cloth(gui.N_sample_edge, clothR3, cloth_drawableR3, constraintR3, { {4,8,6}, {7,8,6}, {7,8,4.2}, {4,8,4.2} }, 2, 3);
-
-
-	// On clothesline left of the fan
-
-	clothL1.texture.load_and_initialize_texture_2d_on_gpu(project::path+"assets/towel.jpg");
-	clothL1.mass_total = 0.45f;
-	initialize_cloth(gui.N_sample_edge, clothL1, cloth_drawableL1, constraintL1, { {-3,-8,6}, {-7,-8,6}, {-7,-8,4.2}, {-3,-8,4.2} }, 2, 4);
-
-	clothL2.texture.load_and_initialize_texture_2d_on_gpu(project::path+"assets/tartan.jpg");
-	clothL2.mass_total = 0.3f;
-	initialize_cloth(gui.N_sample_edge, clothL2, cloth_drawableL2, constraintL2, { {-2,-8,6}, {-0.5,-8,6}, {-0.5,-8,4.7}, {-2,-8,4.7} }, 1.5, 1.5);
-
-	clothL3.texture.load_and_initialize_texture_2d_on_gpu(project::path+"assets/tartan.jpg");
-	clothL3.mass_total = 0.3f;
-	initialize_cloth(gui.N_sample_edge, clothL3, cloth_drawableL3, constraintL3, { {0,-8,6}, {1.5,-8,6}, {1.5,-8,4.7}, {0,-8,4.7} }, 1.5, 1.5);
-
-	clothL4.texture.load_and_initialize_texture_2d_on_gpu(project::path+"assets/blue.jpg");
-	clothL4.mass_total = 0.5f;
-	initialize_cloth(gui.N_sample_edge, clothL4, cloth_drawableL4, constraintL4, { {2.5,-8,6}, {4,-8,6}, {4,-8,1.2}, {2.5,-8,1.2} }, 5, 1.5);
-
-	clothL5.texture.load_and_initialize_texture_2d_on_gpu(project::path+"assets/motif.jpg");
-	clothL5.mass_total = 0.6f;
-	initialize_cloth(gui.N_sample_edge, clothL5, cloth_drawableL5, constraintL5, { {5,-8,6}, {7,-8,6}, {7,-8,2.2}, {5,-8,2.2} }, 4, 2);
-
-	// On little clothesline (behind the fan)
-
-	clothLC1.texture.load_and_initialize_texture_2d_on_gpu(project::path+"assets/blue.jpg");
-	clothLC1.mass_total = 0.5f;
-	initialize_cloth(gui.N_sample_edge, clothLC1, cloth_drawableLC1, constraintLC1, { {4,5,6}, {4,3,6}, {4,3,1.2}, {4,5,1.2} }, 5, 2);
+	// The cloths are described in assets/clothes.txt (the built-in scene of scene_description.cpp if it cannot be read)
+	std::vector<cloth_description> clothes;
+	if (!scene_description_load(project::path + "assets/clothes.txt", clothes))
+		clothes = scene_description_clothes();
+
+	world.initialize(clothes, gui.N_sample_edge);
+	cloth_drawables.resize(world.size());
+	for (int k = 0; k < world.size(); ++k)
+		initialize_cloth_drawable(k);
 }
 
 
@@ -181,12 +134,12 @@ void scene_structure::display_frame()
 	// ***************************************** //
 	
 	// If your cloth is along the x axis, you can rotate the pins by 90° with rotate = true
-	auto draw_pin = [&](constraint_structure constraint, bool rotate = false) {
-		for (auto const& c : constraint.fixed_sample)
+	auto draw_pin = [&](constraint_structure const& constraint, bool rotate = false) {
+		for (position_contraint const& c : constraint.fixed_sample)
 		{
-			if ( c.second.ku == 0)
+			if ( c.ku == 0)
 			{
-				vec3 pin_position =  vec3(c.second.position.x, c.second.position.y, 5.8f);
+				vec3 pin_position =  vec3(c.position.x, c.position.y, 5.8f);
 				pin_fixed_position.model.translation = pin_position;
 				if (rotate)
 					pin_fixed_position.model.rotation = pin_fixed_position.model.rotation * rotation_transform::from_axis_angle({ 0,1,0 }, Pi/2);
@@ -200,21 +153,10 @@ void scene_structure::display_frame()
 		}
 	};
 
-	draw_pin(constraintF1);
-	draw_pin(constraintF2);
-	draw_pin(constraintF3);
-
-	draw_pin(constraintR1, true);
-	draw_pin(constraintR2, true);
-	draw_pin(constraintR3, true);
-
-	draw_pin(constraintL1, true);
-	draw_pin(constraintL2, true);
-	draw_pin(constraintL3, true);
-	draw_pin(constraintL4, true);
-	draw_pin(constraintL5, true);
-
-	draw_pin(constraintLC1);
+	for (int k = 0; k < world.size(); ++k) {
+		std::vector<vec3> const& corners = world.descriptions[k].corners;
+		draw_pin(world.constraints[k], std::abs(corners[1].x - corners[0].x) > std::abs(corners[1].y - corners[0].y));
+	}
 
 
 
@@ -244,29 +186,29 @@ void scene_structure::display_frame()
 	// Simulation and display of the fan
 	// ***************************************** //
 
-	timer.update();
+	float const elapsed_time = timer.update();
 
 	// Update fan and wind speed in function of the GUI
 	int speed = 0;
 	if (gui.speed1)
 	{
 		speed = 5;
-		parameters.wind.magnitude = 1;
+		parameters.wind.magnitude = scene_description_wind_magnitude(1);
 	}
 	else if (gui.speed2)
 	{
 		speed = 7;
-		parameters.wind.magnitude = 3;
+		parameters.wind.magnitude = scene_description_wind_magnitude(2);
 	}
 	else if (gui.speed3)
 	{
 		speed = 9;
-		parameters.wind.magnitude = 5;
+		parameters.wind.magnitude = scene_description_wind_magnitude(3);
 	}
 	else
 	{
 		speed = 0;
-		parameters.wind.magnitude = 0;
+		parameters.wind.magnitude = scene_description_wind_magnitude(0);
 	}
 
 	// Update rotation fan speed in function of the GUI
@@ -304,8 +246,9 @@ void scene_structure::display_frame()
 	
 
 	// Fan position
-	hierarchy_fan["fan_base"].transform_local.translation = { hierarchy_fan_position.first, hierarchy_fan_position.second, constraintF1.ground_z };
+	hierarchy_fan["fan_base"].transform_local.translation = { hierarchy_fan_position.first, hierarchy_fan_position.second, constraint_structure().ground_z };
 	parameters.fan_position = hierarchy_fan["fan_base"].transform_local.translation + vec3{0, 0, 1};
+	simulation_update_obstacles(parameters);
 
 	// Update the wind source position
 	parameters.wind.source = hierarchy_fan["fan_base"].transform_local.translation;
@@ -318,6 +261,7 @@ void scene_structure::display_frame()
 	// Update the direction of the wind with de rotation of the fan
 	mat3 objectTransform = hierarchy_fan["fan_base_head"].transform_local.rotation.matrix();
 	parameters.wind.direction = normalize(objectTransform * parameters.wind.initial_direction);
+	simulation_update_wind_field(wind_field, parameters); // wind sampled by all the cloths during this frame
 
 	// Display the fan
 	hierarchy_fan.update_local_to_global_coordinates();
@@ -328,40 +272,47 @@ void scene_structure::display_frame()
 	// Simulation of the cloth
 	// ***************************************** //
 
-	auto simulation = [](cloth_structure &cloth, simulation_parameters &parameters, constraint_structure &constraint) 
-	{
-		simulation_compute_force(cloth, parameters);
-		simulation_numerical_integration(cloth, parameters.dt);
-		simulation_apply_constraints(cloth, constraint, parameters);
-
-		bool const simulation_diverged = simulation_detect_divergence(cloth);
-		if (simulation_diverged) 
-		{
-			std::cout << "\n *** Simulation has diverged for ***" << std::endl;
-			std::cout << " > The simulation is stoped" << std::endl;
-			return false;
-		}
-		return true;
-	};
+	// The cloths which can touch each other during the frame form an island: each island is an independent task running
+	//  all the steps of the frame (the cloths advanced one after the other, then pushed apart at each step). The tasks are
+	//  distributed on the thread pool and the only synchronization is the end of the frame. The islands whose cloths are
+	//  all asleep are skipped.
+	int const N_cloth = world.size();
 
-	int const N_step = 5; // Adapt here the number of intermediate simulation steps (ex. 5 intermediate steps per frame)
-	for (int k_step = 0; simulation_running == true && k_step < N_step; ++k_step)
+	// The simulation advances by fixed steps of frame_dt, as many as the elapsed time requires (within the budget of the clock)
+	float const frame_dt = simulation_steps_per_frame(parameters) * simulation_time_step(parameters);  // Simulated time per step
+	int const N_frame_step = (simulation_running && !cache_player.is_open()) ? simulation_clock.advance(elapsed_time, frame_dt) : 0;
+	if (N_frame_step > 0)
 	{
-		simulation(clothF1, parameters, constraintF1) ? simulation_running = true :  simulation_running = false;
-		simulation(clothF2, parameters, constraintF2) ? simulation_running = true :  simulation_running = false;
-		simulation(clothF3, parameters, constraintF3) ? simulation_running = true :  simulation_running = false;
-
-		simulation(clothR1, parameters, constraintR1) ? simulation_running = true :  simulation_running = false;
-		simulation(clothR2, parameters, constraintR2) ? simulation_running = true :  simulation_running = false;
-		simulation(clothR3, parameters, constraintR3) ? simulation_running = true :  simulation_running = false;
-
-		simulation(clothL1, parameters, constraintL1) ? simulation_running = true :  simulation_running = false;
-		simulation(clothL2, parameters, constraintL2) ? simulation_running = true :  simulation_running = false;
-		simulation(clothL3, parameters, constraintL3) ? simulation_running = true :  simulation_running = false;
-		simulation(clothL4, parameters, constraintL4) ? simulation_running = true :  simulation_running = false;
-		simulation(clothL5, parameters, constraintL5) ? simulation_running = true :  simulation_running = false;
+		// Resolution of each cloth from its size on the screen (the display of a cloth which switched is rebuilt)
+		lod_view const view = { camera_control.camera_model.position(), window.height / camera_projection.field_of_view };
+		std::vector<int> switched;
+		simulation_world_lod(world, view, parameters, switched);
+		for (int k : switched)
+			cloth_drawables[k].resize(world.cloths[k].N_samples_x(), world.cloths[k].lenght_x, world.cloths[k].lenght_y);
+
+		simulation_running = simulation_world_advance(world, simulation_tasks, parameters, N_frame_step);
+		if (cache_recorder.is_open())
+			cache_recorder.append(world.cloth_pointers.data(), N_cloth);
+	}
 
-		simulation(clothLC1, parameters, constraintLC1) ? simulation_running = true :  simulation_running = false;
+	// Playback of a recording instead of the simulation: one recorded frame per displayed frame (a paused playback
+	//  shows the frame chosen in the GUI)
+	if (cache_player.is_open() && cache_player.N_frame() > 0)
+	{
+		if (simulation_running)
+			cache_frame = (cache_frame + 1) % cache_player.N_frame();
+		if (cache_frame != cache_frame_read) {
+			std::vector<int> N_sample(N_cloth);
+			for (int k = 0; k < N_cloth; ++k)
+				N_sample[k] = world.cloths[k].N_samples_x();
+			if (cache_player.read(cache_frame, world.cloth_pointers.data(), N_cloth)) {
+				cache_frame_read = cache_frame;
+				for (int k = 0; k < N_cloth; ++k) {
+					if (world.cloths[k].N_samples_x() != N_sample[k])
+						cloth_drawables[k].resize(world.cloths[k].N_samples_x(), world.cloths[k].lenght_x, world.cloths[k].lenght_y);
+				}
+			}
+		}
 	}
 
 
@@ -369,11 +320,11 @@ void scene_structure::display_frame()
 	// Cloth display
 	// ***************************************** //
 
-	auto cloth_display = [](cloth_structure_drawable &cloth_drawable, cloth_structure &cloth, gui_parameters gui, environment_structure &e)
+	float const alpha = simulation_running ? simulation_clock.alpha : 1.0f;
+	auto cloth_display = [alpha](cloth_structure_drawable &cloth_drawable, cloth_structure &cloth, gui_parameters gui, environment_structure &e)
 	{
-		// Prepare to display the updated cloth
-		cloth.update_normal();        // compute the new normals
-		cloth_drawable.update(cloth); // update the positions on the GPU
+		// Prepare to display the updated cloth (the normals are computed with the simulation)
+		cloth_drawable.update(cloth, alpha); // update the positions on the GPU, interpolated between the two last steps
 
 		// Display the cloth
 		draw(cloth_drawable, e);
@@ -381,26 +332,15 @@ void scene_structure::display_frame()
 			draw_wireframe(cloth_drawable, e);
 	};
 
-	cloth_display(cloth_drawableF1, clothF1, gui, environment);
-	cloth_display(cloth_drawableF2, clothF2, gui, environment);
-	cloth_display(cloth_drawableF3, clothF3, gui, environment);
-
-	cloth_display(cloth_drawableR1, clothR1, gui, environment);
-	cloth_display(cloth_drawableR2, clothR2, gui, environment);
-	cloth_display(cloth_drawableR3, clothR3, gui, environment);
-
-	cloth_display(cloth_drawableL1, clothL1, gui, environment);
-	cloth_display(cloth_drawableL2, clothL2, gui, environment);
-	cloth_display(cloth_drawableL3, clothL3, gui, environment);
-	cloth_display(cloth_drawableL4, clothL4, gui, environment);
-	cloth_display(cloth_drawableL5, clothL5, gui, environment);
-
-	cloth_display(cloth_drawableLC1, clothLC1, gui, environment);
+	for (int k = 0; k < N_cloth; ++k)
+		cloth_display(cloth_drawables[k], world.cloths[k], gui, environment);
 }
 
 void scene_structure::display_gui()
 {
 	bool reset = false;
+	int const N_cloth = world.size();
+	cloth_structure const& cloth_first = world.cloths.front(); // statistics of the solvers shown for the first cloth
 
 	ImGui::Text("Display");
 	ImGui::Checkbox("Frame", &gui.display_frame);
@@ -409,7 +349,74 @@ void scene_structure::display_gui()
 	ImGui::Spacing(); ImGui::Spacing();
 
 	ImGui::Text("Simulation parameters");
-	ImGui::SliderFloat("Time step", &parameters.dt, 0.0001f, 0.02f, "%.4f", 2.0f);
+	ImGui::Text("Vectorized kernels: %s", simd_kernels().name);
+	int solver = static_cast<int>(parameters.solver);
+	ImGui::RadioButton("Explicit", &solver, static_cast<int>(simulation_solver::explicit_euler));
+	ImGui::SameLine();
+	ImGui::RadioButton("Implicit", &solver, static_cast<int>(simulation_solver::implicit_euler));
+	ImGui::SameLine();
+	ImGui::RadioButton("XPBD", &solver, static_cast<int>(simulation_solver::xpbd));
+	ImGui::SameLine();
+	ImGui::RadioButton("PD", &solver, static_cast<int>(simulation_solver::projective));
+	parameters.solver = static_cast<simulation_solver>(solver);
+
+	if (parameters.solver == simulation_solver::implicit_euler) {
+		ImGui::SliderFloat("Time step", &parameters.implicit.dt, 0.001f, 0.05f, "%.4f", 2.0f);
+		ImGui::Text("Conjugate gradient iterations: %d", cloth_first.implicit_solver.cg_iterations);
+	}
+	else if (parameters.solver == simulation_solver::xpbd) {
+		ImGui::SliderFloat("Time step", &parameters.xpbd.dt, 0.001f, 0.05f, "%.4f", 2.0f);
+		ImGui::SliderInt("Substeps", &parameters.xpbd.substeps, 1, 30);
+		ImGui::SliderInt("Iterations", &parameters.xpbd.iterations, 1, 10);
+	}
+	else if (parameters.solver == simulation_solver::projective) {
+		ImGui::SliderFloat("Time step", &parameters.projective.dt, 0.001f, 0.05f, "%.4f", 2.0f);
+		ImGui::SliderInt("Iterations", &parameters.projective.iterations, 1, 30);
+		ImGui::Text("Factorizations: %d", cloth_first.projective_solver.factorization_count);
+	}
+	else
+		ImGui::SliderFloat("Time step", &parameters.dt, 0.0001f, 0.02f, "%.4f", 2.0f);
+
+	ImGui::SliderInt("Max steps per frame", &simulation_clock.max_steps_per_frame, 1, 10);
+	ImGui::Text("Steps this frame: %d, frames over budget: %d", simulation_clock.steps, simulation_clock.budget_exceeded);
+
+	ImGui::Checkbox("Adaptive time step", &parameters.adaptive.enabled);
+	if (parameters.adaptive.enabled) {
+		int steps = 0, rollbacks = 0, halted = 0;
+		float dt_min = simulation_time_step(parameters);
+		for (cloth_structure const& cloth : world.cloths) {
+			steps += cloth.stepper.step_count;
+			rollbacks += cloth.stepper.rollback_count;
+			halted += cloth.stepper.halted ? 1 : 0;
+			if (cloth.stepper.dt > 0)
+				dt_min = std::min(dt_min, cloth.stepper.dt);
+		}
+		ImGui::Text("Substeps: %d, rollbacks: %d, halted cloths: %d", steps, rollbacks, halted);
+		ImGui::Text("Smallest substep: %.5f", dt_min);
+	}
+
+	ImGui::Checkbox("Self-collision", &parameters.self_collision.enabled);
+	if (parameters.self_collision.enabled) {
+		ImGui::SliderFloat("Thickness", &parameters.self_collision.thickness, 0.05f, 0.5f);
+		ImGui::Text("Active patches: %d, contacts: %d", cloth_first.self_collision.active_patch_count, cloth_first.self_collision.contact_count);
+	}
+	ImGui::Checkbox("Clothesline collision", &parameters.clothesline_collision.enabled);
+	ImGui::Checkbox("Cloth collision", &parameters.cloth_collision.enabled);
+	ImGui::Checkbox("Sleeping", &parameters.sleeping.enabled);
+	ImGui::Checkbox("Level of detail", &parameters.lod.enabled);
+	if (parameters.lod.enabled) {
+		ImGui::SliderFloat("Pixels per sample", &parameters.lod.pixels_per_sample, 2.0f, 40.0f);
+		ImGui::SliderInt("Levels", &parameters.lod.levels, 1, 4);
+		int vertices = 0;
+		for (cloth_structure const& cloth : world.cloths)
+			vertices += cloth.position.size();
+		ImGui::Text("Simulated vertices: %d", vertices);
+	}
+	if (parameters.sleeping.enabled) {
+		ImGui::Text("Sleeping cloths: %d", simulation_world_asleep(world));
+	}
+	if (parameters.cloth_collision.enabled)
+		ImGui::Text("Islands: %d, contacts: %d", world.islands.N_island(), cloth_first.cloth_collision.contact_count);
 
 	ImGui::Spacing(); ImGui::Spacing();
 
@@ -533,6 +540,45 @@ void scene_structure::display_gui()
 		initialize_cloths();
 		simulation_running = true;
 	}
+
+	// Recording of the simulation, and its playback instead of the simulation
+	std::string const cache_filename = project::path + "cache.bin";
+	bool recording = cache_recorder.is_open();
+	if (ImGui::Checkbox("Record", &recording)) {
+		if (recording)
+			cache_recorder.open(cache_filename, N_cloth);
+		else
+			cache_recorder.close();
+	}
+	ImGui::SameLine();
+	if (!cache_player.is_open()) {
+		if (ImGui::Button("Play recording")) {
+			cache_recorder.close();
+			if (cache_player.open(cache_filename, N_cloth)) {
+				cache_frame = 0;
+				cache_frame_read = -1;
+			}
+		}
+	}
+	else {
+		if (ImGui::Button("Stop playback"))
+			cache_player.close(); // the simulation continues from the displayed frame
+		else if (cache_player.N_frame() > 0)
+			ImGui::SliderInt("Frame", &cache_frame, 0, cache_player.N_frame() - 1);
+	}
+	if (cache_recorder.is_open())
+		ImGui::Text("Recorded frames: %d (%d KiB)", cache_recorder.N_frame(), int(cache_recorder.written_size / 1024));
+
+	// Checkpoint of the cloths and of the settings of the simulation (the wind and the fan stay driven by the GUI)
+	std::string const checkpoint_filename = project::path + "checkpoint.bin";
+	if (ImGui::Button("Save state"))
+		simulation_checkpoint_save(checkpoint_filename, world.cloth_pointers.data(), world.constraint_pointers.data(), N_cloth, parameters);
+	ImGui::SameLine();
+	if (ImGui::Button("Load state") && simulation_checkpoint_load(checkpoint_filename, world.cloth_pointers.data(), world.constraint_pointers.data(), N_cloth, parameters)) {
+		for (int k = 0; k < N_cloth; ++k)
+			cloth_drawables[k].resize(world.cloths[k].N_samples_x(), world.cloths[k].lenght_x, world.cloths[k].lenght_y);
+		simulation_running = true;
+	}
 }
 
 void scene_structure::mouse_move_event()
@@ -5,7 +5,14 @@
 #include "environment.hpp"
 
 #include "cloth/cloth.hpp"
+#include "cloth/cloth_drawable.hpp"
 #include "simulation/simulation.hpp"
+#include "task_pool/task_pool.hpp"
+#include "clock/clock.hpp"
+#include "scene_description/scene_description.hpp"
+#include "cloth_world/cloth_world.hpp"
+#include "checkpoint/checkpoint.hpp"
+#include "cache/cache.hpp"
 
 using cgp::mesh_drawable;
 
@@ -74,57 +81,17 @@ struct scene_structure : scene_inputs_generic {
 
 	// Cloth related structures
 	simulation_parameters parameters;          // Stores the parameters of the simulation (time step, wind settings)
+	task_pool simulation_tasks;                // Worker threads simulating the cloths in parallel
+	simulation_clock_structure simulation_clock; // Fixed time step accumulator (simulated time independent of the frame rate)
+	wind_field_structure wind_field;             // Wind of the fan sampled on a grid, shared by the cloths
+	cache_recorder_structure cache_recorder;     // Recording of the simulated frames (one per displayed frame)
+	cache_player_structure cache_player;         // Playback of a recording instead of the simulation
+	int cache_frame = 0;                         // Frame of the recording displayed during the playback
+	int cache_frame_read = -1;                   // Frame of the recording held by the cloths
 
+	cloth_world_structure world;                     // The cloths of the scene description and their constraints (fixed vertices, floor, pin, fan collision)
+	std::vector<cloth_structure_drawable> cloth_drawables; // Helper structures to display the cloths as meshes (same order as the world)
 
-	// On clothesline in front of the fan
-
-	cloth_structure clothF1;                     // The values of the position, velocity, forces, etc, stored as a 2D grid
-	cloth_structure_drawable cloth_drawableF1;   // Helper structure to display the cloth as a mesh
-	constraint_structure constraintF1;           // Handle the parameters of the constraints (fixed vertices, floor, pin, fan collision)
-	cloth_structure clothF2;                     
-	cloth_structure_drawable cloth_drawableF2;   
-	constraint_structure constraintF2;           
-	cloth_structure clothF3;                     
-	cloth_structure_drawable cloth_drawableF3;   
-	constraint_structure constraintF3;   
-
-	// On clothesline right of the fan
-
-	cloth_structure clothR1; 
-	cloth_structure_drawable cloth_drawableR1;
-	constraint_structure constraintR1;     
-	cloth_structure clothR2;
-	cloth_structure_drawable cloth_drawableR2;
-	constraint_structure constraintR2;
-	cloth_structure clothR3;
-	cloth_structure_drawable cloth_drawableR3;
-	constraint_structure constraintR3;
-
-	// On clothesline left of the fan
-
-	cloth_structure clothL1;
-	cloth_structure_drawable cloth_drawableL1;
-	constraint_structure constraintL1;
-	cloth_structure clothL2;
-	cloth_structure_drawable cloth_drawableL2;
-	constraint_structure constraintL2;
-	cloth_structure clothL3;
-	cloth_structure_drawable cloth_drawableL3;
-	constraint_structure constraintL3;
-	cloth_structure clothL4;
-	cloth_structure_drawable cloth_drawableL4;
-	constraint_structure constraintL4;
-	cloth_structure clothL5;
-	cloth_structure_drawable cloth_drawableL5;
-	constraint_structure constraintL5;
-
-	// On little clothesline (behind the fan)
-
-	cloth_structure clothLC1;                    
-	cloth_structure_drawable cloth_drawableLC1;   
-	constraint_structure constraintLC1;           
-
-                   
 
 	// Helper variables
 	bool simulation_running = true;   // Boolean indicating if the simulation should be computed
@@ -139,8 +106,8 @@ struct scene_structure : scene_inputs_generic {
 	void display_gui();   // The display of the GUI, also called within the animation loop
 
 
-	void initialize_cloths();
-	void initialize_cloth(int N_sample, cloth_structure &cloth, cloth_structure_drawable &cloth_drawable, constraint_structure &constraint, std::vector<vec3> pos, float x_lenght, float y_lenght); // Recompute the cloth from scratch
+	void initialize_cloths(); // Recompute the cloths from scratch
+	void initialize_cloth_drawable(int k); // Display of the cloth k of the world at its current resolution
 
 	void mouse_move_event();
 	void mouse_click_event();
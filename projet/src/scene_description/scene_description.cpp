@@ -0,0 +1,140 @@
+#include "scene_description.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace cgp;
+
+
+std::vector<cloth_description> scene_description_clothes()
+{
+    return {
+        // On clothesline in front of the fan
+        { "F1", { {-8,-2,6}, {-8,-7,6}, {-8,-7,1.2f}, {-8,-2,1.2f} }, 5, 5, 0.8f, "assets/picnic.jpg", true },
+        { "F2", { {-8,7,6}, {-8,2,6}, {-8,2,4.2f}, {-8,7,4.2f} }, 2, 5, 0.5f, "assets/towel.jpg", true },
+        { "F3", { {-8,1,6}, {-8,-1,6}, {-8,-1,3.2f}, {-8,1,3.2f} }, 3, 2, 0.3f, "assets/blue.png", true },
+
+        // On clothesline right of the fan
+        { "R1", { {-7,8,6}, {-2,8,6}, {-2,8,1.2f}, {-7,8,1.2f} }, 5, 5, 0.8f, "assets/tartan2.jpg", true },
+        { "R2", { {-1,8,6}, {3,8,6}, {3,8,2.2f}, {-1,8,2.2f} }, 4, 4, 0.65f, "assets/green.jpg", true },
+        { "R3", { {4,8,6}, {7,8,6}, {7,8,4.2f}, {4,8,4.2f} }, 2, 3, 0.45f, "assets/towel.jpg", true },
+
+        // On clothesline left of the fan
+        { "L1", { {-3,-8,6}, {-7,-8,6}, {-7,-8,4.2f}, {-3,-8,4.2f} }, 2, 4, 0.45f, "assets/towel.jpg", false },
+        { "L2", { {-2,-8,6}, {-0.5f,-8,6}, {-0.5f,-8,4.7f}, {-2,-8,4.7f} }, 1.5f, 1.5f, 0.3f, "assets/tartan.jpg", false },
+        { "L3", { {0,-8,6}, {1.5f,-8,6}, {1.5f,-8,4.7f}, {0,-8,4.7f} }, 1.5f, 1.5f, 0.3f, "assets/tartan.jpg", false },
+        { "L4", { {2.5f,-8,6}, {4,-8,6}, {4,-8,1.2f}, {2.5f,-8,1.2f} }, 5, 1.5f, 0.5f, "assets/blue.jpg", false },
+        { "L5", { {5,-8,6}, {7,-8,6}, {7,-8,2.2f}, {5,-8,2.2f} }, 4, 2, 0.6f, "assets/motif.jpg", false },
+
+        // On little clothesline (behind the fan)
+        { "LC1", { {4,5,6}, {4,3,6}, {4,3,1.2f}, {4,5,1.2f} }, 5, 2, 0.5f, "assets/blue.jpg", false }
+    };
+}
+
+bool scene_description_load(std::string const& filename, std::vector<cloth_description>& clothes)
+{
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        std::cout << "Cannot read the scene description " << filename << std::endl;
+        return false;
+    }
+
+    std::vector<cloth_description> result;
+    std::string error;
+    std::string line;
+    int k_line = 0;
+    while (error.empty() && std::getline(file, line))
+    {
+        k_line++;
+        std::istringstream stream(line.substr(0, line.find('#')));
+        std::string keyword;
+        if (!(stream >> keyword))
+            continue;
+
+        if (keyword == "cloth") {
+            cloth_description description = { "", {}, 0, 0, 0, "", false };
+            if (!(stream >> description.name))
+                error = "missing name";
+            result.push_back(description);
+            continue;
+        }
+        if (result.empty()) {
+            error = "\"" + keyword + "\" before the first cloth";
+            break;
+        }
+
+        cloth_description& description = result.back();
+        if (keyword == "corners") {
+            description.corners.resize(4);
+            for (vec3& p : description.corners)
+                stream >> p.x >> p.y >> p.z;
+        }
+        else if (keyword == "size")
+            stream >> description.length_x >> description.length_y;
+        else if (keyword == "mass")
+            stream >> description.mass_total;
+        else if (keyword == "texture") {
+            std::string repeat;
+            stream >> description.texture;
+            description.texture_repeat = (stream >> repeat) && repeat == "repeat";
+            stream.clear();
+        }
+        else if (keyword == "pins") {
+            description.pin_rows.clear();
+            int row;
+            while (stream >> row)
+                description.pin_rows.push_back(row);
+            if (stream.eof())
+                stream.clear();
+        }
+        else if (keyword == "pin_depth")
+            stream >> description.pin_depth;
+        else
+            error = "unknown keyword \"" + keyword + "\"";
+
+        if (error.empty() && stream.fail())
+            error = "invalid value of \"" + keyword + "\"";
+    }
+
+    // Every cloth needs its geometry (error of the whole file)
+    if (error.empty())
+        k_line = 0;
+    for (size_t k = 0; error.empty() && k < result.size(); ++k) {
+        cloth_description const& description = result[k];
+        if (description.corners.size() != 4 || description.length_x <= 0 || description.length_y <= 0 || description.mass_total <= 0 || description.pin_depth < 0)
+            error = "the cloth " + description.name + " needs its corners, a positive size and a positive mass";
+    }
+    if (error.empty() && result.empty())
+        error = "no cloth";
+
+    if (!error.empty()) {
+        std::cout << "Error in the scene description " << filename << (k_line > 0 ? " (line " + str(k_line) + ")" : "") << ": " << error << std::endl;
+        return false;
+    }
+    clothes = result;
+    return true;
+}
+
+void scene_description_initialize_cloth(cloth_description const& description, int N_sample, cloth_structure& cloth, constraint_structure& constraint)
+{
+    cloth.mass_total = description.mass_total;
+    cloth.initialize(N_sample, description.corners, description.length_x, description.length_y);
+
+    // Vertices held by the pins, from the hung edge
+    constraint.initialize(cloth);
+    for (int row : description.pin_rows) {
+        int const kv = row >= 0 ? row : N_sample + row;
+        for (int ku = 0; ku < description.pin_depth; ++ku) {
+            if (kv >= 0 && kv < N_sample && ku < N_sample)
+                constraint.add_fixed_position(ku, kv, cloth);
+        }
+    }
+    cloth.lod.initialize(description.corners, N_sample);
+}
+
+float scene_description_wind_magnitude(int level)
+{
+    float const magnitude[4] = { 0.0f, 8.0f, 16.0f, 24.0f }; // air speed at 1m from the fan
+    return (level >= 0 && level <= 3) ? magnitude[level] : 0.0f;
+}
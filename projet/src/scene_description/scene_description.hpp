@@ -0,0 +1,36 @@
+#pragma once
+
+#include "../cgp_headless.hpp"
+#include "../cloth/cloth.hpp"
+#include "../constraint/constraint.hpp"
+
+#include <string>
+#include <vector>
+
+
+// Description of a cloth of the scene, independent of its display
+struct cloth_description
+{
+    std::string name;
+    std::vector<cgp::vec3> corners; // 4 corners of the cloth, the first edge is hung on the clothesline
+    float length_x;
+    float length_y;
+    float mass_total;
+    std::string texture;            // image displayed on the cloth (relative to the project path)
+    bool texture_repeat;            // the texture is repeated (GL_REPEAT) instead of clamped
+    std::vector<int> pin_rows = { 2, -3 }; // vertices of the hung edge held by a pin (negative: from the end of the edge)
+    int pin_depth = 3;                     // number of vertices held by each pin from the hung edge
+};
+
+// The cloths hung on the clotheslines around the fan (built-in scene)
+std::vector<cloth_description> scene_description_clothes();
+
+// Read the cloths of a scene description file (see assets/clothes.txt for the format). Returns false, with a message
+//  giving the line of the first error, if the file cannot be read or describes no cloth.
+bool scene_description_load(std::string const& filename, std::vector<cloth_description>& clothes);
+
+// Initialize the cloth, its fixed vertices (pinned on the clothesline) and its levels of detail from its description
+void scene_description_initialize_cloth(cloth_description const& description, int N_sample, cloth_structure& cloth, constraint_structure& constraint);
+
+// Wind magnitude of the fan (air speed at 1m) for a speed level of the GUI (0: off, 1 to 3)
+float scene_description_wind_magnitude(int level);
@@ -0,0 +1,344 @@
+#include "self_collision.hpp"
+#include "self_collision_geometry.hpp"
+
+#include "../cloth/cloth.hpp"
+#include "../constraint/constraint.hpp"
+#include "../simd/parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace cgp;
+
+
+// Patches of patch_size x patch_size quads. A patch whose normals stay in a cone of half angle below flat_patch_angle
+//  cannot fold on itself (Volino and Magnenat-Thalmann 1994), neither can two adjacent patches if their union is flat.
+static int const patch_size = 8;
+static float const flat_patch_angle = 1.0f; // radians (about 57 degrees)
+
+// Patch of the vertex k, of the quad k and of the edges starting at k (the last row and column belong to the patches
+//  of the quads before them)
+static int patch_index(int k, int N_x, int N_y, int N_patch_x)
+{
+    int const pu = std::min(k % N_x, N_x - 2) / patch_size;
+    int const pv = std::min(k / N_x, N_y - 2) / patch_size;
+    return pu + N_patch_x * pv;
+}
+
+// Box and normal cone of the patch (pu,pv)
+static void update_patch(vec3 const* position, int N_x, int N_y, int pu, int pv, float thickness, self_collision_patch& patch)
+{
+    int const ku_begin = pu * patch_size, ku_end = std::min(ku_begin + patch_size, N_x - 1);
+    int const kv_begin = pv * patch_size, kv_end = std::min(kv_begin + patch_size, N_y - 1);
+
+    vec3 p_min = position[ku_begin + N_x * kv_begin];
+    vec3 p_max = p_min;
+    for (int kv = kv_begin; kv <= kv_end; ++kv) {
+        for (int ku = ku_begin; ku <= ku_end; ++ku) {
+            vec3 const& p = position[ku + N_x * kv];
+            p_min = { std::min(p_min.x, p.x), std::min(p_min.y, p.y), std::min(p_min.z, p.z) };
+            p_max = { std::max(p_max.x, p.x), std::max(p_max.y, p.y), std::max(p_max.z, p.z) };
+        }
+    }
+    patch.p_min = p_min - vec3(thickness, thickness, thickness);
+    patch.p_max = p_max + vec3(thickness, thickness, thickness);
+
+    // Normals of the quads (along their diagonals), their sum weights them by the area of the quads
+    vec3 normal[patch_size * patch_size];
+    vec3 normal_sum = { 0,0,0 };
+    int N_quad = 0;
+    for (int kv = kv_begin; kv < kv_end; ++kv) {
+        for (int ku = ku_begin; ku < ku_end; ++ku) {
+            int const q = ku + N_x * kv;
+            normal[N_quad] = cross(position[q + N_x + 1] - position[q], position[q + N_x] - position[q + 1]);
+            normal_sum += normal[N_quad++];
+        }
+    }
+
+    // Cone of the normals around the mean normal
+    float const length = norm(normal_sum);
+    if (length < 1e-12f) {
+        patch.normal = { 0,0,1 };
+        patch.angle = 3.14159f;
+        return;
+    }
+    patch.normal = normal_sum / length;
+    float cosine = 1.0f;
+    for (int i = 0; i < N_quad; ++i) {
+        float const n_length = norm(normal[i]);
+        if (n_length > 0)
+            cosine = std::min(cosine, dot(normal[i], patch.normal) / n_length);
+    }
+    patch.angle = std::acos(std::max(cosine, -1.0f));
+}
+
+// Mark the patches which can be in contact: the curved patches, the adjacent patches whose union is curved, and the
+//  non adjacent patches whose boxes overlap (sweep along x). Returns the number of active patches.
+static int mark_active_patches(self_collision_structure& collision, int N_patch_x, int N_patch_y)
+{
+    std::vector<self_collision_patch> const& patches = collision.patches;
+    std::vector<char>& active = collision.active;
+    int const N_patch = N_patch_x * N_patch_y;
+    active.assign(N_patch, 0);
+
+    for (int pv = 0; pv < N_patch_y; ++pv) {
+        for (int pu = 0; pu < N_patch_x; ++pu) {
+            int const i = pu + N_patch_x * pv;
+            if (patches[i].angle > flat_patch_angle)
+                active[i] = 1;
+
+            // Adjacent patches on the right and on the next row: the smallest cone containing both cones bounds the
+            //  normals of their union
+            int const offset[4][2] = { {1,0}, {-1,1}, {0,1}, {1,1} };
+            for (auto const& o : offset) {
+                int const qu = pu + o[0], qv = pv + o[1];
+                if (qu < 0 || qu >= N_patch_x || qv >= N_patch_y)
+                    continue;
+                int const j = qu + N_patch_x * qv;
+                float const between = std::acos(std::min(std::max(dot(patches[i].normal, patches[j].normal), -1.0f), 1.0f));
+                float const angle_i = patches[i].angle, angle_j = patches[j].angle;
+                if (std::max(std::max(angle_i, angle_j), 0.5f * (between + angle_i + angle_j)) > flat_patch_angle)
+                    active[i] = active[j] = 1;
+            }
+        }
+    }
+
+    std::vector<int>& order = collision.sweep_order;
+    order.resize(N_patch);
+    for (int i = 0; i < N_patch; ++i)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), [&patches](int i, int j) { return patches[i].p_min.x < patches[j].p_min.x; });
+    for (int a = 0; a < N_patch; ++a) {
+        self_collision_patch const& P = patches[order[a]];
+        for (int b = a + 1; b < N_patch && patches[order[b]].p_min.x <= P.p_max.x; ++b) {
+            self_collision_patch const& Q = patches[order[b]];
+            int const i = order[a], j = order[b];
+            bool const adjacent = std::abs(i % N_patch_x - j % N_patch_x) <= 1 && std::abs(i / N_patch_x - j / N_patch_x) <= 1;
+            if (!adjacent && Q.p_min.y <= P.p_max.y && P.p_min.y <= Q.p_max.y && Q.p_min.z <= P.p_max.z && P.p_min.z <= Q.p_max.z)
+                active[i] = active[j] = 1;
+        }
+    }
+
+    int N_active = 0;
+    for (char a : active)
+        N_active += a;
+    return N_active;
+}
+
+// Contacts of the triangles and of the edges starting on the rows [kv_begin, kv_end)
+static void detect_contacts(cloth_structure const& cloth, self_collision_structure const& collision, self_collision_grid const& grid, float thickness, int kv_begin, int kv_end, std::vector<self_collision_contact>& contacts)
+{
+    numarray<vec3> const& position = cloth.position.data;
+    int const N_x = cloth.N_samples_x();
+    int const N_y = cloth.N_samples_y();
+    int const N_patch_x = (N_x - 2) / patch_size + 1;
+    int const* vertex_start = collision.vertices.cell_start.data();
+    int const* vertex_entries = collision.vertices.entries.data();
+    int const* edge_start = collision.edges.cell_start.data();
+    int const* edge_entries = collision.edges.entries.data();
+    vec3 const* edge_boxes = collision.edges.boxes.data();
+    contacts.clear();
+
+    for (int k = N_x * kv_begin; k < N_x * kv_end; ++k)
+    {
+        if (!collision.active[patch_index(k, N_x, N_y, N_patch_x)])
+            continue;
+
+        // The primitives within 2 rows and columns of k are its neighbors on the cloth: they are rejected before any
+        //  geometric test, as they make most of the content of the cells of a flat cloth
+        int const ku = k % N_x;
+        int const kv = k / N_x;
+        auto const neighbor = [N_x, ku, kv](int k2) {
+            int const kv2 = k2 / N_x;
+            return std::abs(kv2 - kv) <= 2 && std::abs(k2 - kv2 * N_x - ku) <= 2;
+        };
+
+        // Vertex-triangle: each quad queries the vertices of the cells of its box inflated by the thickness, and tests
+        //  them against its two triangles. A vertex is only considered in its own cell (the cells of the box can share
+        //  their hash).
+        vec3 q_min, q_max;
+        int3 c0, c1;
+        if (quad_exists(k, N_x, N_y))
+            quad_box(k, position, N_x, thickness, q_min, q_max);
+        if (quad_exists(k, N_x, N_y) && grid.cells(q_min, q_max, c0, c1))
+        {
+            for (int iz = c0.z; iz <= c1.z; ++iz) for (int iy = c0.y; iy <= c1.y; ++iy) for (int ix = c0.x; ix <= c1.x; ++ix)
+            {
+                int const h = grid.hash(ix, iy, iz);
+                for (int e = vertex_start[h]; e < vertex_start[h + 1]; ++e)
+                {
+                    int const v = vertex_entries[e];
+                    if (neighbor(v))
+                        continue;
+                    vec3 const& p = position[v];
+                    if (p.x < q_min.x || p.y < q_min.y || p.z < q_min.z || p.x > q_max.x || p.y > q_max.y || p.z > q_max.z)
+                        continue;
+                    if (grid.coordinate(p.x) != ix || grid.coordinate(p.y) != iy || grid.coordinate(p.z) != iz)
+                        continue;
+                    for (int triangle = 2 * k; triangle < 2 * k + 2; ++triangle)
+                    {
+                        int a, b, c;
+                        triangle_vertices(triangle, N_x, a, b, c);
+                        vec3 n, w;
+                        float d;
+                        if (vertex_triangle(p, position[a], position[b], position[c], thickness, n, d, w))
+                            contacts.push_back({ v, triangle, false });
+                    }
+                }
+            }
+        }
+
+        // Edge-edge: the edges are inflated by half the thickness, so that two close edges share a cell.
+        //  Each pair is tested once: from its edge of lowest index (the cells are sorted by index), in the cell of the
+        //  lowest corner of the overlap of their boxes.
+        //  The diagonals are not tested: an edge passing through a quad crosses its border or ends above it (vertex-triangle).
+        for (int edge = 2 * k; edge < 2 * k + 2; ++edge)
+        {
+            vec3 const& p_min = edge_boxes[2 * edge];
+            vec3 const& p_max = edge_boxes[2 * edge + 1];
+            int3 c0, c1;
+            if (!grid.cells(p_min, p_max, c0, c1))
+                continue;
+            int p1, q1;
+            edge_vertices(edge, N_x, p1, q1);
+
+            for (int iz = c0.z; iz <= c1.z; ++iz) for (int iy = c0.y; iy <= c1.y; ++iy) for (int ix = c0.x; ix <= c1.x; ++ix)
+            {
+                int const h = grid.hash(ix, iy, iz);
+                for (int e = edge_start[h + 1] - 1; e >= edge_start[h] && edge_entries[e] > edge; --e)
+                {
+                    int const other = edge_entries[e];
+                    if (neighbor(other / 2))
+                        continue;
+                    vec3 const& o_min = edge_boxes[2 * other];
+                    vec3 const& o_max = edge_boxes[2 * other + 1];
+                    if (o_min.x > p_max.x || o_min.y > p_max.y || o_min.z > p_max.z || p_min.x > o_max.x || p_min.y > o_max.y || p_min.z > o_max.z)
+                        continue;
+                    if (grid.coordinate(std::max(p_min.x, o_min.x)) != ix || grid.coordinate(std::max(p_min.y, o_min.y)) != iy || grid.coordinate(std::max(p_min.z, o_min.z)) != iz)
+                        continue;
+                    int p2, q2;
+                    edge_vertices(other, N_x, p2, q2);
+                    float s, t, distance;
+                    vec3 n;
+                    if (edge_edge(position[p1], position[q1], position[p2], position[q2], thickness, s, t, n, distance))
+                        contacts.push_back({ edge, other, true });
+                }
+            }
+        }
+    }
+}
+
+// Position-based projection of a contact on the current positions (equal masses, the pinned vertices are not moved)
+static void resolve_contact(self_collision_contact const& contact, numarray<vec3>& position, constraint_structure const& constraint, int N_x, float thickness)
+{
+    auto const weight = [&constraint](int k) { return constraint.weight(k); };
+
+    if (!contact.edge_edge)
+    {
+        int a, b, c;
+        triangle_vertices(contact.b, N_x, a, b, c);
+        int const k = contact.a;
+        vec3 n, w;
+        float d;
+        if (!vertex_triangle(position[k], position[a], position[b], position[c], thickness, n, d, w))
+            return;
+
+        // The vertex is pushed to the thickness on its side of the triangle
+        float const wk = weight(k), wa = weight(a), wb = weight(b), wc = weight(c);
+        float const denominator = wk + wa * w.x * w.x + wb * w.y * w.y + wc * w.z * w.z;
+        if (denominator <= 0)
+            return;
+        vec3 const dp = ((thickness - std::abs(d)) / denominator) * (d >= 0 ? n : -n);
+        position[k] += wk * dp;
+        position[a] -= wa * w.x * dp;
+        position[b] -= wb * w.y * dp;
+        position[c] -= wc * w.z * dp;
+        return;
+    }
+
+    int p1, q1, p2, q2;
+    edge_vertices(contact.a, N_x, p1, q1);
+    edge_vertices(contact.b, N_x, p2, q2);
+    float s, t, distance;
+    vec3 n;
+    if (!edge_edge(position[p1], position[q1], position[p2], position[q2], thickness, s, t, n, distance))
+        return;
+
+    float const w1 = weight(p1), w2 = weight(q1), w3 = weight(p2), w4 = weight(q2);
+    float const denominator = w1 * (1 - s) * (1 - s) + w2 * s * s + w3 * (1 - t) * (1 - t) + w4 * t * t;
+    if (denominator <= 0)
+        return;
+    vec3 const dp = ((thickness - distance) / denominator) * n;
+    position[p1] += w1 * (1 - s) * dp;
+    position[q1] += w2 * s * dp;
+    position[p2] -= w3 * (1 - t) * dp;
+    position[q2] -= w4 * t * dp;
+}
+
+void simulation_self_collision(cloth_structure& cloth, constraint_structure const& constraint, self_collision_parameters const& parameters)
+{
+    self_collision_structure& collision = cloth.self_collision;
+    collision.contact_count = 0;
+    collision.active_patch_count = 0;
+    if (!parameters.enabled)
+        return;
+
+    // A diverging cloth is not processed (the cells would not be bounded)
+    for (int c = 0; c < 3; ++c)
+        if (!std::isfinite(cloth.bounding_box_min[c]) || !std::isfinite(cloth.bounding_box_max[c]))
+            return;
+
+    numarray<vec3>& position = cloth.position.data;
+    int const N_x = cloth.N_samples_x();
+    int const N_y = cloth.N_samples_y();
+    int const N = N_x * N_y;
+    bool const parallel = N >= parallel_vertex_threshold;
+
+    float const L0 = std::min(cloth.lenght_x / (N_x - 1.0f), cloth.lenght_y / (N_y - 1.0f));
+    float const thickness = parameters.thickness * L0;
+
+    // Cells of the size of the springs, hashed in tables larger than the number of primitives
+    self_collision_grid grid;
+    grid.inv_cell_size = 1.0f / std::max(cloth.lenght_x / (N_x - 1.0f), cloth.lenght_y / (N_y - 1.0f));
+    grid.mask = 1;
+    while (grid.mask < 2 * N)
+        grid.mask = 2 * grid.mask + 1;
+
+    // Patches which can be in contact
+    int const N_patch_x = (N_x - 2) / patch_size + 1;
+    int const N_patch_y = (N_y - 2) / patch_size + 1;
+    collision.patches.resize(N_patch_x * N_patch_y);
+    #pragma omp parallel for if(parallel)
+    for (int i = 0; i < N_patch_x * N_patch_y; ++i)
+        update_patch(position.data.data(), N_x, N_y, i % N_patch_x, i / N_patch_x, thickness, collision.patches[i]);
+    collision.active_patch_count = mark_active_patches(collision, N_patch_x, N_patch_y);
+    if (collision.active_patch_count == 0)
+        return;
+
+    build_hash(collision.vertices, N, grid, parallel, [&](int k, vec3& p_min, vec3& p_max) {
+        if (!collision.active[patch_index(k, N_x, N_y, N_patch_x)])
+            return false;
+        p_min = position[k];
+        p_max = position[k];
+        return true;
+    });
+    build_hash(collision.edges, 2 * N, grid, parallel, [&](int edge, vec3& p_min, vec3& p_max) {
+        if (!edge_exists(edge, N_x, N_y) || !collision.active[patch_index(edge / 2, N_x, N_y, N_patch_x)])
+            return false;
+        edge_box(edge, position, N_x, 0.5f * thickness, p_min, p_max);
+        return true;
+    });
+
+    // Detection by tiles of rows (in parallel), then resolution in the order of the tiles
+    int const N_tile = (N_y + tile_rows - 1) / tile_rows;
+    collision.tile_contacts.resize(N_tile);
+    #pragma omp parallel for if(parallel)
+    for (int t = 0; t < N_tile; ++t)
+        detect_contacts(cloth, collision, grid, thickness, t * tile_rows, std::min((t + 1) * tile_rows, N_y), collision.tile_contacts[t]);
+
+    for (std::vector<self_collision_contact> const& contacts : collision.tile_contacts) {
+        for (self_collision_contact const& contact : contacts)
+            resolve_contact(contact, position, constraint, N_x, thickness);
+        collision.contact_count += contacts.size();
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "../cgp_headless.hpp"
+
+#include <vector>
+
+struct cloth_structure;
+struct constraint_structure;
+
+
+// Settings of the collisions of a cloth with itself
+struct self_collision_parameters
+{
+    bool enabled = true;
+    float thickness = 0.25f; // minimal distance between two parts of the cloth, relative to the rest length of the springs
+};
+
+// Pair of primitives closer than the thickness: vertex-triangle (vertex index, triangle index) or edge-edge
+//  The triangle 2q+t is the triangle t of the quad q (see simd_aerodynamic_lanes), the edge 2k+d starts at the vertex
+//  k and goes to the next vertex along x (d=0) or along y (d=1).
+struct self_collision_contact
+{
+    int a;
+    int b;
+    bool edge_edge;
+};
+
+// Square of quads of the cloth: bounding box (inflated by the thickness) and cone of the normals of its quads
+struct self_collision_patch
+{
+    cgp::vec3 p_min;
+    cgp::vec3 p_max;
+    cgp::vec3 normal; // mean normal
+    float angle;      // half angle of the cone of the normals around the mean normal (radians)
+};
+
+// Primitives overlapping each cell of a spatial hash, sorted by cell (counting sort):
+//  the primitives of the cell h are entries[cell_start[h], cell_start[h+1])
+struct self_collision_hash
+{
+    std::vector<int> cell_start;
+    std::vector<int> cell_cursor; // next free entry of each cell during the construction
+    std::vector<int> entries;
+    std::vector<cgp::vec3> boxes; // corners min and max of the box of each primitive (empty if it is not inserted)
+};
+
+// Patches, spatial hashes and contacts, rebuilt at each substep (the buffers are kept to avoid reallocations)
+struct self_collision_structure
+{
+    // Only the active patches (curved, or close to a non adjacent patch) can be in contact
+    std::vector<self_collision_patch> patches;
+    std::vector<char> active;
+    std::vector<int> sweep_order; // patches sorted by the lower x of their box
+
+    self_collision_hash vertices;
+    self_collision_hash edges;
+
+    std::vector<std::vector<self_collision_contact>> tile_contacts; // contacts found by each tile of rows
+
+    int active_patch_count = 0; // number of active patches of the last substep (for display)
+    int contact_count = 0;      // number of contacts of the last substep (for display)
+};
+
+
+// Push apart the parts of the cloth closer than the thickness (vertex-triangle and edge-edge contacts).
+//  The cloth is first split in patches of quads: a patch whose normals stay in a narrow cone cannot fold on itself, so
+//  only the curved patches and the patches close to a non adjacent one are processed.
+//  Their vertices and edges are sorted in spatial hashes, each quad/edge only tests the vertices/edges of its cells.
+//  The primitives within 2 rows and columns of the grid are never tested: they are kept apart by the springs.
+//  The detection runs in parallel on tiles of rows, the contacts are then resolved in order (position-based).
+void simulation_self_collision(cloth_structure& cloth, constraint_structure const& constraint, self_collision_parameters const& parameters);
@@ -0,0 +1,210 @@
+#pragma once
+
+#include "self_collision.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// Primitives of the grid of a cloth and spatial hash, shared by the collisions of a cloth with itself and with the other cloths
+
+
+// A primitive covering more cells than this (ex. a diverging cloth) is not inserted in the hash
+static int const max_cells_per_primitive = 64;
+
+// Largest cell coordinate: the boxes beyond it (a cloth blown up but still finite) are rejected before their conversion to int
+static float const max_cell_coordinate = float(1 << 30);
+
+// Geometry of the spatial hash: cubic cells of size 1/inv_cell_size, cell coordinates hashed in a table of size mask+1
+struct self_collision_grid
+{
+    float inv_cell_size;
+    int mask;
+
+    int coordinate(float x) const { // floor without the call to std::floor
+        float const u = x * inv_cell_size;
+        int const i = static_cast<int>(u);
+        return i - (u < i);
+    }
+    int hash(int ix, int iy, int iz) const {
+        return static_cast<int>((unsigned(ix) * 73856093u ^ unsigned(iy) * 19349663u ^ unsigned(iz) * 83492791u) & unsigned(mask));
+    }
+
+    // Range of cells [c0, c1] overlapped by the box [p_min, p_max], returns false if it is empty or too large
+    //  Each axis is checked before the product of the extents, which cannot overflow
+    bool cells(cgp::vec3 const& p_min, cgp::vec3 const& p_max, cgp::int3& c0, cgp::int3& c1) const {
+        if (!(p_min.x <= p_max.x))
+            return false;
+        for (int c = 0; c < 3; ++c) {
+            if (!(std::abs(p_min[c]) * inv_cell_size < max_cell_coordinate && std::abs(p_max[c]) * inv_cell_size < max_cell_coordinate))
+                return false;
+            if ((p_max[c] - p_min[c]) * inv_cell_size > max_cells_per_primitive)
+                return false;
+        }
+        c0 = { coordinate(p_min.x), coordinate(p_min.y), coordinate(p_min.z) };
+        c1 = { coordinate(p_max.x), coordinate(p_max.y), coordinate(p_max.z) };
+        return (c1.x - c0.x + 1) * (c1.y - c0.y + 1) * (c1.z - c0.z + 1) <= max_cells_per_primitive;
+    }
+};
+
+// Vertices of the triangle 2q+t and of the edge 2k+d of a grid of N_x columns (see self_collision_contact)
+inline void triangle_vertices(int triangle, int N_x, int& a, int& b, int& c)
+{
+    int const k = triangle / 2;
+    a = k;
+    if (triangle % 2 == 0) { b = k + 1; c = k + N_x + 1; }
+    else { b = k + N_x + 1; c = k + N_x; }
+}
+
+inline void edge_vertices(int edge, int N_x, int& a, int& b)
+{
+    a = edge / 2;
+    b = a + (edge % 2 == 0 ? 1 : N_x);
+}
+
+// Existence of the quad q and of the edge 2k+d on the grid
+inline bool quad_exists(int q, int N_x, int N_y)
+{
+    return q % N_x < N_x - 1 && q / N_x < N_y - 1;
+}
+
+inline bool edge_exists(int edge, int N_x, int N_y)
+{
+    int const k = edge / 2;
+    return edge % 2 == 0 ? k % N_x < N_x - 1 : k / N_x < N_y - 1;
+}
+
+// Bounding box of the points a and b inflated by margin
+inline void box(cgp::vec3 const& a, cgp::vec3 const& b, float margin, cgp::vec3& p_min, cgp::vec3& p_max)
+{
+    p_min = { std::min(a.x, b.x) - margin, std::min(a.y, b.y) - margin, std::min(a.z, b.z) - margin };
+    p_max = { std::max(a.x, b.x) + margin, std::max(a.y, b.y) + margin, std::max(a.z, b.z) + margin };
+}
+
+inline void quad_box(int q, cgp::numarray<cgp::vec3> const& position, int N_x, float margin, cgp::vec3& p_min, cgp::vec3& p_max)
+{
+    cgp::vec3 d_min, d_max;
+    box(position[q], position[q + N_x + 1], margin, p_min, p_max);
+    box(position[q + 1], position[q + N_x], margin, d_min, d_max);
+    p_min = { std::min(p_min.x, d_min.x), std::min(p_min.y, d_min.y), std::min(p_min.z, d_min.z) };
+    p_max = { std::max(p_max.x, d_max.x), std::max(p_max.y, d_max.y), std::max(p_max.z, d_max.z) };
+}
+
+inline void edge_box(int edge, cgp::numarray<cgp::vec3> const& position, int N_x, float margin, cgp::vec3& p_min, cgp::vec3& p_max)
+{
+    int a, b;
+    edge_vertices(edge, N_x, a, b);
+    box(position[a], position[b], margin, p_min, p_max);
+}
+
+// Post-increment of a counter, atomic if it is shared by the threads of a parallel loop
+inline int fetch_and_increment(int& counter, bool parallel)
+{
+    if (!parallel)
+        return counter++;
+    int value;
+    #pragma omp atomic capture
+    value = counter++;
+    return value;
+}
+
+// Counting sort of the primitives [0, N_primitive) by the cells overlapped by their box: count, prefix sum, then fill.
+//  primitive_box(primitive, p_min, p_max) returns false for the indices which are not primitives.
+template <typename BOX>
+inline void build_hash(self_collision_hash& hash, int N_primitive, self_collision_grid const& grid, bool parallel, BOX const& primitive_box)
+{
+    int const table_size = grid.mask + 1;
+    hash.boxes.resize(2 * N_primitive);
+    hash.cell_start.assign(table_size + 1, 0);
+    cgp::vec3* boxes = hash.boxes.data();
+    int* cell_start = hash.cell_start.data();
+
+    #pragma omp parallel for if(parallel)
+    for (int primitive = 0; primitive < N_primitive; ++primitive)
+    {
+        cgp::vec3& p_min = boxes[2 * primitive];
+        cgp::vec3& p_max = boxes[2 * primitive + 1];
+        if (!primitive_box(primitive, p_min, p_max)) {
+            p_min = { 1,1,1 };
+            p_max = { 0,0,0 };
+        }
+        cgp::int3 c0, c1;
+        if (!grid.cells(p_min, p_max, c0, c1))
+            continue;
+        for (int iz = c0.z; iz <= c1.z; ++iz) for (int iy = c0.y; iy <= c1.y; ++iy) for (int ix = c0.x; ix <= c1.x; ++ix)
+            fetch_and_increment(cell_start[grid.hash(ix, iy, iz) + 1], parallel);
+    }
+    for (int h = 0; h < table_size; ++h)
+        cell_start[h + 1] += cell_start[h];
+
+    hash.entries.resize(cell_start[table_size]);
+    hash.cell_cursor.assign(hash.cell_start.begin(), hash.cell_start.end() - 1);
+    int* entries = hash.entries.data();
+    int* cell_cursor = hash.cell_cursor.data();
+
+    // The fill is serial to keep the primitives of each cell sorted by index
+    for (int primitive = 0; primitive < N_primitive; ++primitive)
+    {
+        cgp::int3 c0, c1;
+        if (!grid.cells(boxes[2 * primitive], boxes[2 * primitive + 1], c0, c1))
+            continue;
+        for (int iz = c0.z; iz <= c1.z; ++iz) for (int iy = c0.y; iy <= c1.y; ++iy) for (int ix = c0.x; ix <= c1.x; ++ix)
+            entries[cell_cursor[grid.hash(ix, iy, iz)]++] = primitive;
+    }
+}
+
+// Distance of p to the triangle (a,b,c) along its unit normal n, if p projects inside the triangle (barycentric coordinates w)
+inline bool vertex_triangle(cgp::vec3 const& p, cgp::vec3 const& a, cgp::vec3 const& b, cgp::vec3 const& c, float thickness, cgp::vec3& n, float& d, cgp::vec3& w)
+{
+    cgp::vec3 const ab = b - a;
+    cgp::vec3 const ac = c - a;
+    cgp::vec3 const ap = p - a;
+    n = cross(ab, ac);
+    float const area2 = norm(n);
+    if (area2 < 1e-12f)
+        return false;
+    n /= area2;
+    d = dot(ap, n);
+    if (std::abs(d) >= thickness)
+        return false;
+
+    float const d00 = dot(ab, ab), d01 = dot(ab, ac), d11 = dot(ac, ac);
+    float const d20 = dot(ap, ab), d21 = dot(ap, ac);
+    float const denominator = d00 * d11 - d01 * d01;
+    float const v = (d11 * d20 - d01 * d21) / denominator;
+    float const u = (d00 * d21 - d01 * d20) / denominator;
+    w = { 1 - u - v, v, u };
+    return w.x >= 0 && w.y >= 0 && w.z >= 0;
+}
+
+// Closest points p1+s(q1-p1) and p2+t(q2-p2) of two segments, closer than the thickness and strictly inside both
+//  segments (the extremities are handled by the vertex-triangle contacts). n is the unit direction from the second to the first.
+inline bool edge_edge(cgp::vec3 const& p1, cgp::vec3 const& q1, cgp::vec3 const& p2, cgp::vec3 const& q2, float thickness, float& s, float& t, cgp::vec3& n, float& distance)
+{
+    cgp::vec3 const d1 = q1 - p1;
+    cgp::vec3 const d2 = q2 - p2;
+    cgp::vec3 const r = p1 - p2;
+    float const a = dot(d1, d1);
+    float const e = dot(d2, d2);
+    float const b = dot(d1, d2);
+    float const c = dot(d1, r);
+    float const f = dot(d2, r);
+    float const denominator = a * e - b * b;
+    if (denominator < 1e-12f * a * e) // parallel segments
+        return false;
+
+    s = std::min(std::max((b * f - c * e) / denominator, 0.0f), 1.0f);
+    t = (b * s + f) / e;
+    if (t < 0 || t > 1) {
+        t = std::min(std::max(t, 0.0f), 1.0f);
+        s = std::min(std::max((b * t - c) / a, 0.0f), 1.0f);
+    }
+    if (s <= 0 || s >= 1 || t <= 0 || t >= 1)
+        return false;
+
+    cgp::vec3 const u = (p1 + s * d1) - (p2 + t * d2);
+    distance = norm(u);
+    if (distance >= thickness || distance < 1e-9f)
+        return false;
+    n = u / distance;
+    return true;
+}
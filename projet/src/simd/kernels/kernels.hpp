@@ -0,0 +1,135 @@
+#pragma once
+
+// Plain data types shared between the dispatcher (simd.cpp) and the kernels compiled for each instruction set.
+//  This header is included by translation units compiled with specific instruction set flags (-mavx2, etc):
+//  it must not include any header defining inline functions (cgp, STL) to avoid mixing their instantiations.
+
+#include "../../spring/spring_run.hpp"
+
+#if (defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)) && !defined(__EMSCRIPTEN__)
+#define SIMD_KERNELS_X86
+#endif
+
+
+// Structure-of-arrays view on the cloth state: the x, y, z coordinates are stored in separate lanes
+//  The vertex (ku,kv) is stored at index ku + N_x*kv, similarly to grid_2D.
+struct simd_cloth_lanes
+{
+    float const* px; float const* py; float const* pz; // positions
+    float const* vx; float const* vy; float const* vz; // velocities
+    float* fx; float* fy; float* fz;                   // forces (output)
+    int N_x;
+    int N_y;
+};
+
+// Constant parameters of the force computation
+struct simd_force_parameters
+{
+    float m;          // mass of a particle
+    float mu;         // damping coefficient
+    float K[3];       // spring stiffness for each spring_type
+    float gx, gy, gz; // gravity
+};
+
+// Aerodynamic forces of the triangles of a grid cloth.
+//  The quad (ku,kv) of the grid, with k = ku + N_x*kv, is split in the triangles T0 = (k, k+1, k+N_x+1) and
+//  T1 = (k, k+N_x+1, k+N_x). The third of the force of each triangle is stored in f0/f1 at the index k + N_x + 1:
+//  the buffers start with N_x+1 zeros, and the quads of the last column and last row are kept to zero, so that every
+//  vertex can gather the forces of its neighboring quads without any test.
+struct simd_aerodynamic_lanes
+{
+    float const* ax; float const* ay; float const* az; // air velocity at the vertices
+    float* f0x; float* f0y; float* f0z;                // force of T0 / 3 for each quad (N_x+1 + N_x*N_y elements)
+    float* f1x; float* f1y; float* f1z;                // force of T1 / 3 for each quad
+};
+
+// Coefficients of the aerodynamic model, including the distribution of the force on the 3 vertices of a triangle
+struct simd_aerodynamic_parameters
+{
+    float drag; // air density * drag coefficient / 12
+    float lift; // air density * lift coefficient / 12
+};
+
+// Wire of a clothesline: segment of extremity a, unit direction u and given length, surrounded by a radius.
+//  (e1, e2) is an orthonormal basis of the plane orthogonal to u, in which the wire is reduced to a disc.
+struct simd_wire_parameters
+{
+    float ax, ay, az;
+    float ux, uy, uz;
+    float e1x, e1y, e1z;
+    float e2x, e2y, e2z;
+    float length;
+    float radius;
+};
+
+// Positions of the cloth at the beginning (0) and at the end (1) of a step, and first time of impact in [0,1] of its
+//  vertices and edges against a wire (2 if there is none). The edge (k, k+1) is stored at the index k of edge_toi_x,
+//  the edge (k, k+N_x) at the index k of edge_toi_y.
+struct simd_sweep_lanes
+{
+    float const* x0; float const* y0; float const* z0;
+    float const* x1; float const* y1; float const* z1;
+    float* vertex_toi;
+    float* edge_toi_x;
+    float* edge_toi_y;
+    int N_x;
+    int N_y;
+};
+
+// Positions (input) and normals (output) of a grid cloth, the vertex (ku,kv) at the index ku + N_x*kv
+struct simd_normal_lanes
+{
+    float const* px; float const* py; float const* pz;
+    float* nx; float* ny; float* nz;
+    int N_x;
+    int N_y;
+};
+
+// Set of kernels implemented for one instruction set
+struct simd_kernel_table
+{
+    char const* name;
+
+    // Gravity + drag on the vertices [k_begin, k_end), written in lanes.fx/fy/fz (erase the previous forces)
+    void (*external_force)(simd_cloth_lanes const& lanes, simd_force_parameters const& parameters, int k_begin, int k_end);
+
+    // Add the forces of the springs of the runs [0,N_run) to both of their extremities (action/reaction)
+    //  The runs are evaluated sequentially: concurrent calls must be given runs that share no vertex.
+    void (*spring_force)(simd_cloth_lanes const& lanes, spring_run const* runs, int N_run, simd_force_parameters const& parameters);
+
+    // Add the forces of the springs of the runs [0,N_run) to their first extremity a only (gather)
+    //  Only the forces of the vertices a are written: runs with distinct vertices a can be evaluated concurrently.
+    void (*spring_force_gather)(simd_cloth_lanes const& lanes, spring_run const* runs, int N_run, simd_force_parameters const& parameters);
+
+    // Drag and lift of the triangles of the quads of the rows [kv_begin, kv_end) (kv_end <= N_y-1), written in f0/f1.
+    //  Uses the area weighted normal of each triangle and the air velocity relative to the triangle.
+    void (*aerodynamic_force)(simd_cloth_lanes const& lanes, simd_aerodynamic_lanes const& air, simd_aerodynamic_parameters const& parameters, int kv_begin, int kv_end);
+
+    // Add to the vertices [k_begin, k_end) the aerodynamic forces of their neighboring triangles
+    void (*aerodynamic_gather)(simd_cloth_lanes const& lanes, simd_aerodynamic_lanes const& air, int k_begin, int k_end);
+
+    // Semi-implicit Euler update on flat buffers of N floats: v = w * (v + dt_inv_m * f), then p += dt * v. The weights w
+    //  are the relative inverse masses (0 for the fixed coordinates, whose velocity is cancelled).
+    void (*integrate)(float* p, float* v, float const* f, float const* w, int N, float dt, float dt_inv_m);
+
+    // Continuous collision of the vertices of the tile [ku_begin, ku_end) x [kv_begin, kv_end) and of the edges starting
+    //  from them against a wire. The elements starting inside half the radius (ex. the cloth hung on the wire) are ignored.
+    void (*wire_impact)(simd_sweep_lanes const& sweep, simd_wire_parameters const& wire, int ku_begin, int ku_end, int kv_begin, int kv_end);
+
+    // Bounding box {x_min, y_min, z_min, x_max, y_max, z_max} of the start and end positions of the tile [ku_begin, ku_end) x [kv_begin, kv_end)
+    void (*sweep_bounds)(simd_sweep_lanes const& sweep, float* box, int ku_begin, int ku_end, int kv_begin, int kv_end);
+
+    // Normals of the vertices of the rows [kv_begin, kv_end): normalized sum of the unit normals of the (up to 6) grid
+    //  triangles around each vertex, gathered from the positions of its neighbors. Each vertex only writes its own normal.
+    void (*grid_normal)(simd_normal_lanes const& lanes, int kv_begin, int kv_end);
+
+    // Copy of the vertices [k_begin, k_end) of an array of 3 floats per vertex to the lanes x, y, z (AoS -> SoA), and back
+    void (*deinterleave)(float const* aos, float* x, float* y, float* z, int k_begin, int k_end);
+    void (*interleave)(float const* x, float const* y, float const* z, float* aos, int k_begin, int k_end);
+};
+
+// Kernel tables of each instruction set - returns nullptr if the instruction set is not compiled in
+simd_kernel_table const* simd_kernel_table_scalar();
+simd_kernel_table const* simd_kernel_table_sse();
+simd_kernel_table const* simd_kernel_table_avx2();
+simd_kernel_table const* simd_kernel_table_avx512();
@@ -0,0 +1,57 @@
+#include "kernels_impl.hpp"
+#include "kernels_x86.hpp"
+
+// AVX2 kernels: 8 floats per register (compiled with -mavx2 or /arch:AVX2)
+
+#ifdef SIMD_KERNELS_X86
+
+namespace {
+
+struct float_avx
+{
+    static const int width = 8;
+    __m256 v;
+
+    static float_avx load(float const* p) { return { _mm256_loadu_ps(p) }; }
+    static float_avx set1(float a) { return { _mm256_set1_ps(a) }; }
+    void store(float* p) const { _mm256_storeu_ps(p, v); }
+};
+inline float_avx operator+(float_avx a, float_avx b) { return { _mm256_add_ps(a.v, b.v) }; }
+inline float_avx operator-(float_avx a, float_avx b) { return { _mm256_sub_ps(a.v, b.v) }; }
+inline float_avx operator*(float_avx a, float_avx b) { return { _mm256_mul_ps(a.v, b.v) }; }
+inline float_avx operator/(float_avx a, float_avx b) { return { _mm256_div_ps(a.v, b.v) }; }
+inline float_avx sqrt(float_avx a) { return { _mm256_sqrt_ps(a.v) }; }
+inline float_avx min(float_avx a, float_avx b) { return { _mm256_min_ps(a.v, b.v) }; }
+inline float_avx max(float_avx a, float_avx b) { return { _mm256_max_ps(a.v, b.v) }; }
+inline float_avx if_less(float_avx a, float_avx b, float_avx x, float_avx y) { return { _mm256_blendv_ps(y.v, x.v, _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ)) }; }
+
+simd_kernel_table const table = {
+    "avx2",
+    kernel_external_force<float_avx, float_ss>,
+    kernel_spring_force<float_avx, float_ss>,
+    kernel_spring_force_gather<float_avx, float_ss>,
+    kernel_aerodynamic_force<float_avx, float_ss>,
+    kernel_aerodynamic_gather<float_avx, float_ss>,
+    kernel_integrate<float_avx, float_ss>,
+    kernel_wire_impact<float_avx, float_ss>,
+    kernel_sweep_bounds<float_avx, float_ss>,
+    kernel_grid_normal<float_avx, float_ss>,
+    kernel_deinterleave_x86,
+    kernel_interleave_x86
+};
+
+} // namespace
+
+simd_kernel_table const* simd_kernel_table_avx2()
+{
+    return &table;
+}
+
+#else
+
+simd_kernel_table const* simd_kernel_table_avx2()
+{
+    return nullptr;
+}
+
+#endif
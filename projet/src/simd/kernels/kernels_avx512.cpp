@@ -0,0 +1,59 @@
+#include "kernels_impl.hpp"
+#include "kernels_x86.hpp"
+
+// AVX-512 kernels: 16 floats per register (compiled with -mavx512f or /arch:AVX512)
+
+#ifdef SIMD_KERNELS_X86
+
+namespace {
+
+struct float_avx512
+{
+    static const int width = 16;
+    __m512 v;
+
+    static float_avx512 load(float const* p) { return { _mm512_loadu_ps(p) }; }
+    static float_avx512 set1(float a) { return { _mm512_set1_ps(a) }; }
+    void store(float* p) const { _mm512_storeu_ps(p, v); }
+};
+inline float_avx512 operator+(float_avx512 a, float_avx512 b) { return { _mm512_add_ps(a.v, b.v) }; }
+inline float_avx512 operator-(float_avx512 a, float_avx512 b) { return { _mm512_sub_ps(a.v, b.v) }; }
+inline float_avx512 operator*(float_avx512 a, float_avx512 b) { return { _mm512_mul_ps(a.v, b.v) }; }
+inline float_avx512 operator/(float_avx512 a, float_avx512 b) { return { _mm512_div_ps(a.v, b.v) }; }
+// Zero-masked forms with a full mask: same result as _mm512_sqrt_ps/min_ps/max_ps, whose undefined pass-through
+//  register triggers a false -Wmaybe-uninitialized warning with GCC 12
+inline float_avx512 sqrt(float_avx512 a) { return { _mm512_maskz_sqrt_ps(__mmask16(0xFFFF), a.v) }; }
+inline float_avx512 min(float_avx512 a, float_avx512 b) { return { _mm512_maskz_min_ps(__mmask16(0xFFFF), a.v, b.v) }; }
+inline float_avx512 max(float_avx512 a, float_avx512 b) { return { _mm512_maskz_max_ps(__mmask16(0xFFFF), a.v, b.v) }; }
+inline float_avx512 if_less(float_avx512 a, float_avx512 b, float_avx512 x, float_avx512 y) { return { _mm512_mask_blend_ps(_mm512_cmp_ps_mask(a.v, b.v, _CMP_LT_OQ), y.v, x.v) }; }
+
+simd_kernel_table const table = {
+    "avx512",
+    kernel_external_force<float_avx512, float_ss>,
+    kernel_spring_force<float_avx512, float_ss>,
+    kernel_spring_force_gather<float_avx512, float_ss>,
+    kernel_aerodynamic_force<float_avx512, float_ss>,
+    kernel_aerodynamic_gather<float_avx512, float_ss>,
+    kernel_integrate<float_avx512, float_ss>,
+    kernel_wire_impact<float_avx512, float_ss>,
+    kernel_sweep_bounds<float_avx512, float_ss>,
+    kernel_grid_normal<float_avx512, float_ss>,
+    kernel_deinterleave_x86,
+    kernel_interleave_x86
+};
+
+} // namespace
+
+simd_kernel_table const* simd_kernel_table_avx512()
+{
+    return &table;
+}
+
+#else
+
+simd_kernel_table const* simd_kernel_table_avx512()
+{
+    return nullptr;
+}
+
+#endif
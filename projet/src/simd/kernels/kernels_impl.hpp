@@ -0,0 +1,499 @@
+#pragma once
+
+#include "kernels.hpp"
+
+// Generic implementation of the cloth kernels.
+//  Included by each kernels_<isa>.cpp after the definition of two vector types:
+//   - a wide vector type (V) used on the bulk of the buffers,
+//   - a single-float type (S) used on the remaining elements.
+//  Each type provides: width, load(float const*), store(float*), set1(float), operators + - * /, sqrt(), min(), max()
+//  and if_less(a, b, x, y) = a < b ? x : y.
+//  Everything is kept in an anonymous namespace so that each instruction set gets its own instantiation.
+
+namespace {
+
+// Gravity and drag on the elements [k_begin, k_end), returns the first element that has not been processed
+template <typename T>
+int external_force_range(simd_cloth_lanes const& c, simd_force_parameters const& p, int k_begin, int k_end)
+{
+    T const mu_m = T::set1(p.mu * p.m);
+    T const weight_x = T::set1(p.m * p.gx);
+    T const weight_y = T::set1(p.m * p.gy);
+    T const weight_z = T::set1(p.m * p.gz);
+
+    int k = k_begin;
+    for (; k + T::width <= k_end; k += T::width)
+    {
+        (weight_x - mu_m * T::load(c.vx + k)).store(c.fx + k);
+        (weight_y - mu_m * T::load(c.vy + k)).store(c.fy + k);
+        (weight_z - mu_m * T::load(c.vz + k)).store(c.fz + k);
+    }
+    return k;
+}
+
+template <typename V, typename S>
+void kernel_external_force(simd_cloth_lanes const& c, simd_force_parameters const& p, int k_begin, int k_end)
+{
+    int const k = external_force_range<V>(c, p, k_begin, k_end);
+    external_force_range<S>(c, p, k, k_end);
+}
+
+// Springs [i_begin, i_end) of a run, returns the first spring that has not been processed.
+//  The force of the spring is added to the vertex a+i and, if with_reaction is true, subtracted from the vertex b+i.
+//  Within a run, the vertex b+i can also be the vertex a+j of another spring of the same vector (ex. horizontal springs):
+//  the two updates are therefore done one after the other through memory and not in registers.
+template <typename T, bool with_reaction>
+int spring_run_range(simd_cloth_lanes const& c, spring_run const& run, T const& K, int i_begin, int i_end)
+{
+    T const L0 = T::set1(run.L0);
+
+    int i = i_begin;
+    for (; i + T::width <= i_end; i += T::width)
+    {
+        int const ka = run.a + i;
+        int const kb = run.b + i;
+
+        T const dx = T::load(c.px + kb) - T::load(c.px + ka);
+        T const dy = T::load(c.py + kb) - T::load(c.py + ka);
+        T const dz = T::load(c.pz + kb) - T::load(c.pz + ka);
+        T const L = sqrt(dx * dx + dy * dy + dz * dz);
+        T const s = K * (L - L0) / L;
+        T const Fx = s * dx;
+        T const Fy = s * dy;
+        T const Fz = s * dz;
+
+        (T::load(c.fx + ka) + Fx).store(c.fx + ka);
+        (T::load(c.fy + ka) + Fy).store(c.fy + ka);
+        (T::load(c.fz + ka) + Fz).store(c.fz + ka);
+
+        if (!with_reaction)
+            continue;
+        (T::load(c.fx + kb) - Fx).store(c.fx + kb);
+        (T::load(c.fy + kb) - Fy).store(c.fy + kb);
+        (T::load(c.fz + kb) - Fz).store(c.fz + kb);
+    }
+    return i;
+}
+
+template <typename V, typename S, bool with_reaction>
+void spring_runs(simd_cloth_lanes const& c, spring_run const* runs, int N_run, simd_force_parameters const& p)
+{
+    for (int r = 0; r < N_run; ++r)
+    {
+        spring_run const& run = runs[r];
+        float const K = p.K[run.type];
+        int const i = spring_run_range<V, with_reaction>(c, run, V::set1(K), 0, run.count);
+        spring_run_range<S, with_reaction>(c, run, S::set1(K), i, run.count);
+    }
+}
+
+template <typename V, typename S>
+void kernel_spring_force(simd_cloth_lanes const& c, spring_run const* runs, int N_run, simd_force_parameters const& p)
+{
+    spring_runs<V, S, true>(c, runs, N_run, p);
+}
+
+template <typename V, typename S>
+void kernel_spring_force_gather(simd_cloth_lanes const& c, spring_run const* runs, int N_run, simd_force_parameters const& p)
+{
+    spring_runs<V, S, false>(c, runs, N_run, p);
+}
+
+// Drag and lift of a triangle of area weighted normal n (|n| = 2*area) in the relative air velocity u, stored divided by 3.
+//  drag: |dot(n,u)| u, lift: cos(theta) (|u|^2 n - dot(n,u) u), both independent of the orientation of the triangle.
+template <typename T>
+void aerodynamic_triangle(T const& nx, T const& ny, T const& nz, T const& ux, T const& uy, T const& uz, T const& drag, T const& lift, float* fx, float* fy, float* fz)
+{
+    T const dn = nx * ux + ny * uy + nz * uz;
+    T const n2 = nx * nx + ny * ny + nz * nz;
+    T const u2 = ux * ux + uy * uy + uz * uz;
+    T const cos_lift = lift * dn / (sqrt(n2 * u2) + T::set1(1e-12f));
+    T const su = drag * sqrt(dn * dn) - cos_lift * dn;
+    T const sn = cos_lift * u2;
+    (su * ux + sn * nx).store(fx);
+    (su * uy + sn * ny).store(fy);
+    (su * uz + sn * nz).store(fz);
+}
+
+// Aerodynamic forces of the quads [i_begin, i_end) of the row starting at the vertex k_row, returns the first quad that has not been processed
+template <typename T>
+int aerodynamic_quad_range(simd_cloth_lanes const& c, simd_aerodynamic_lanes const& air, T const& drag, T const& lift, int k_row, int i_begin, int i_end)
+{
+    int const N_x = c.N_x;
+    T const third = T::set1(1.0f / 3.0f);
+
+    int i = i_begin;
+    for (; i + T::width <= i_end; i += T::width)
+    {
+        int const k00 = k_row + i;
+        int const k10 = k00 + 1;
+        int const k01 = k00 + N_x;
+        int const k11 = k01 + 1;
+        int const q = k00 + N_x + 1;
+
+        // Edges from the corner k00 and relative air velocity at the corners
+        T const p00x = T::load(c.px + k00), p00y = T::load(c.py + k00), p00z = T::load(c.pz + k00);
+        T const e10x = T::load(c.px + k10) - p00x, e10y = T::load(c.py + k10) - p00y, e10z = T::load(c.pz + k10) - p00z;
+        T const e11x = T::load(c.px + k11) - p00x, e11y = T::load(c.py + k11) - p00y, e11z = T::load(c.pz + k11) - p00z;
+        T const e01x = T::load(c.px + k01) - p00x, e01y = T::load(c.py + k01) - p00y, e01z = T::load(c.pz + k01) - p00z;
+
+        T const u00x = T::load(air.ax + k00) - T::load(c.vx + k00), u00y = T::load(air.ay + k00) - T::load(c.vy + k00), u00z = T::load(air.az + k00) - T::load(c.vz + k00);
+        T const u10x = T::load(air.ax + k10) - T::load(c.vx + k10), u10y = T::load(air.ay + k10) - T::load(c.vy + k10), u10z = T::load(air.az + k10) - T::load(c.vz + k10);
+        T const u11x = T::load(air.ax + k11) - T::load(c.vx + k11), u11y = T::load(air.ay + k11) - T::load(c.vy + k11), u11z = T::load(air.az + k11) - T::load(c.vz + k11);
+        T const u01x = T::load(air.ax + k01) - T::load(c.vx + k01), u01y = T::load(air.ay + k01) - T::load(c.vy + k01), u01z = T::load(air.az + k01) - T::load(c.vz + k01);
+
+        // T0 = (k00, k10, k11)
+        aerodynamic_triangle(e10y * e11z - e10z * e11y, e10z * e11x - e10x * e11z, e10x * e11y - e10y * e11x,
+            third * (u00x + u10x + u11x), third * (u00y + u10y + u11y), third * (u00z + u10z + u11z),
+            drag, lift, air.f0x + q, air.f0y + q, air.f0z + q);
+
+        // T1 = (k00, k11, k01)
+        aerodynamic_triangle(e11y * e01z - e11z * e01y, e11z * e01x - e11x * e01z, e11x * e01y - e11y * e01x,
+            third * (u00x + u11x + u01x), third * (u00y + u11y + u01y), third * (u00z + u11z + u01z),
+            drag, lift, air.f1x + q, air.f1y + q, air.f1z + q);
+    }
+    return i;
+}
+
+template <typename V, typename S>
+void kernel_aerodynamic_force(simd_cloth_lanes const& c, simd_aerodynamic_lanes const& air, simd_aerodynamic_parameters const& p, int kv_begin, int kv_end)
+{
+    V const drag_v = V::set1(p.drag), lift_v = V::set1(p.lift);
+    S const drag_s = S::set1(p.drag), lift_s = S::set1(p.lift);
+    for (int kv = kv_begin; kv < kv_end; ++kv)
+    {
+        // The quads of the last column are never written (they stay to zero)
+        int const i = aerodynamic_quad_range<V>(c, air, drag_v, lift_v, c.N_x * kv, 0, c.N_x - 1);
+        aerodynamic_quad_range<S>(c, air, drag_s, lift_s, c.N_x * kv, i, c.N_x - 1);
+    }
+}
+
+// Forces of the neighboring quads added to the vertices [k_begin, k_end), returns the first vertex that has not been processed.
+//  The vertex k is the corner k00 of the quad k (T0 and T1), k10 of the quad k-1 (T0), k11 of the quad k-N_x-1 (T0 and T1)
+//  and k01 of the quad k-N_x (T1).
+template <typename T>
+int aerodynamic_gather_range(simd_cloth_lanes const& c, simd_aerodynamic_lanes const& air, int k_begin, int k_end)
+{
+    int const N_x = c.N_x;
+    int k = k_begin;
+    for (; k + T::width <= k_end; k += T::width)
+    {
+        int const q = k + N_x + 1;
+        (T::load(c.fx + k) + T::load(air.f0x + q) + T::load(air.f1x + q) + T::load(air.f0x + q - 1) + T::load(air.f0x + k) + T::load(air.f1x + k) + T::load(air.f1x + k + 1)).store(c.fx + k);
+        (T::load(c.fy + k) + T::load(air.f0y + q) + T::load(air.f1y + q) + T::load(air.f0y + q - 1) + T::load(air.f0y + k) + T::load(air.f1y + k) + T::load(air.f1y + k + 1)).store(c.fy + k);
+        (T::load(c.fz + k) + T::load(air.f0z + q) + T::load(air.f1z + q) + T::load(air.f0z + q - 1) + T::load(air.f0z + k) + T::load(air.f1z + k) + T::load(air.f1z + k + 1)).store(c.fz + k);
+    }
+    return k;
+}
+
+template <typename V, typename S>
+void kernel_aerodynamic_gather(simd_cloth_lanes const& c, simd_aerodynamic_lanes const& air, int k_begin, int k_end)
+{
+    int const k = aerodynamic_gather_range<V>(c, air, k_begin, k_end);
+    aerodynamic_gather_range<S>(c, air, k, k_end);
+}
+
+template <typename V, typename S>
+void kernel_integrate(float* p, float* v, float const* f, float const* w, int N, float dt, float dt_inv_m)
+{
+    V const dt_v = V::set1(dt);
+    V const dt_inv_m_v = V::set1(dt_inv_m);
+    int k = 0;
+    for (; k + V::width <= N; k += V::width)
+    {
+        V const vk = V::load(w + k) * (V::load(v + k) + dt_inv_m_v * V::load(f + k));
+        vk.store(v + k);
+        (V::load(p + k) + dt_v * vk).store(p + k);
+    }
+
+    S const dt_s = S::set1(dt);
+    S const dt_inv_m_s = S::set1(dt_inv_m);
+    for (; k < N; ++k)
+    {
+        S const vk = S::load(w + k) * (S::load(v + k) + dt_inv_m_s * S::load(f + k));
+        vk.store(v + k);
+        (S::load(p + k) + dt_s * vk).store(p + k);
+    }
+}
+
+// Coordinates of the vertices in the frame of a wire: (X,Y) in the plane orthogonal to the wire, S along the wire
+template <typename T>
+struct wire_frame
+{
+    T ax, ay, az, ux, uy, uz, e1x, e1y, e1z, e2x, e2y, e2z;
+
+    explicit wire_frame(simd_wire_parameters const& w)
+        : ax(T::set1(w.ax)), ay(T::set1(w.ay)), az(T::set1(w.az)), ux(T::set1(w.ux)), uy(T::set1(w.uy)), uz(T::set1(w.uz)),
+          e1x(T::set1(w.e1x)), e1y(T::set1(w.e1y)), e1z(T::set1(w.e1z)), e2x(T::set1(w.e2x)), e2y(T::set1(w.e2y)), e2z(T::set1(w.e2z)) {}
+
+    void project(float const* x, float const* y, float const* z, int k, T& X, T& Y, T& S) const {
+        T const dx = T::load(x + k) - ax, dy = T::load(y + k) - ay, dz = T::load(z + k) - az;
+        X = dx * e1x + dy * e1y + dz * e1z;
+        Y = dx * e2x + dy * e2y + dz * e2z;
+        S = dx * ux + dy * uy + dz * uz;
+    }
+};
+
+// Vertices [k_begin, k_end): first time at which the point (X,Y) enters the disc of the wire, with a position S along the wire
+template <typename T>
+int wire_vertex_range(simd_sweep_lanes const& c, wire_frame<T> const& f, simd_wire_parameters const& w, int k_begin, int k_end)
+{
+    T const zero = T::set1(0.0f), one = T::set1(1.0f), miss = T::set1(2.0f);
+    T const r2 = T::set1(w.radius * w.radius), hung2 = T::set1(0.25f * w.radius * w.radius);
+    T const s_min = T::set1(-w.radius), s_max = T::set1(w.length + w.radius);
+
+    int k = k_begin;
+    for (; k + T::width <= k_end; k += T::width)
+    {
+        T X0, Y0, S0, X1, Y1, S1;
+        f.project(c.x0, c.y0, c.z0, k, X0, Y0, S0);
+        f.project(c.x1, c.y1, c.z1, k, X1, Y1, S1);
+
+        // |w0 + t dw|^2 = r^2 with w = (X,Y): a t^2 + 2 b t + c = 0
+        T const dX = X1 - X0, dY = Y1 - Y0;
+        T const w2 = X0 * X0 + Y0 * Y0;
+        T const a = dX * dX + dY * dY;
+        T const b = X0 * dX + Y0 * dY;
+        T const cc = w2 - r2;
+        T const disc = b * b - a * cc;
+        T const t = (zero - b - sqrt(max(disc, zero))) / max(a, T::set1(1e-20f));
+
+        // Outside at the beginning: first root if it is in the future, inside: immediate contact if it moves inwards (a
+        //  vertex put back on the surface starts slightly inside, it is released when it leaves the wire)
+        T toi = if_less(cc, zero, if_less(b, zero, zero, miss), if_less(zero, disc, if_less(t, zero, miss, t), miss));
+        toi = if_less(w2, hung2, miss, toi);
+        toi = if_less(one, toi, miss, toi);
+        T const s = S0 + min(toi, one) * (S1 - S0);
+        toi = if_less(s, s_min, miss, if_less(s_max, s, miss, toi));
+        toi.store(c.vertex_toi + k);
+    }
+    return k;
+}
+
+// Edges (k, k+offset) for k in [k_begin, k_end): the wire is a point of the plane (X,Y), crossed by the line of the edge
+//  when the cross product f = P x Q changes of sign. The edge is also in contact if it ends closer than the radius on
+//  its side of the wire. The contact point must be within the edge and along the wire. The edges almost parallel to the
+//  wire (shorter than the radius in the plane) are left to the vertices.
+template <typename T>
+int wire_edge_range(simd_sweep_lanes const& c, wire_frame<T> const& f, simd_wire_parameters const& w, int offset, float* edge_toi, int k_begin, int k_end)
+{
+    T const zero = T::set1(0.0f), one = T::set1(1.0f), miss = T::set1(2.0f);
+    T const radius = T::set1(w.radius), r2 = T::set1(w.radius * w.radius), hung2 = T::set1(0.25f * w.radius * w.radius);
+    T const s_min = T::set1(-w.radius), s_max = T::set1(w.length + w.radius);
+
+    int k = k_begin;
+    for (; k + T::width <= k_end; k += T::width)
+    {
+        T PX0, PY0, PS0, PX1, PY1, PS1, QX0, QY0, QS0, QX1, QY1, QS1;
+        f.project(c.x0, c.y0, c.z0, k, PX0, PY0, PS0);
+        f.project(c.x1, c.y1, c.z1, k, PX1, PY1, PS1);
+        f.project(c.x0, c.y0, c.z0, k + offset, QX0, QY0, QS0);
+        f.project(c.x1, c.y1, c.z1, k + offset, QX1, QY1, QS1);
+
+        T const f0 = PX0 * QY0 - PY0 * QX0;
+        T const f1 = PX1 * QY1 - PY1 * QX1;
+        T const DX0 = QX0 - PX0, DY0 = QY0 - PY0;
+        T const DX1 = QX1 - PX1, DY1 = QY1 - PY1;
+        T const length0_2 = DX0 * DX0 + DY0 * DY0;
+        T const length1 = sqrt(DX1 * DX1 + DY1 * DY1);
+
+        // Time at which the line reaches the wire (linear interpolation of f), or the end of the step for a close edge
+        T const f01 = f0 * f1;
+        T const t = if_less(f01, zero, f0 / (f0 - f1), one);
+
+        // Contact point along the edge (projection of the wire at the time t) and along the wire
+        T const PX = PX0 + t * (PX1 - PX0), PY = PY0 + t * (PY1 - PY0);
+        T const DX = DX0 + t * (DX1 - DX0), DY = DY0 + t * (DY1 - DY0);
+        T const lambda = (zero - PX * DX - PY * DY) / max(DX * DX + DY * DY, T::set1(1e-20f));
+        T const s = PS0 + t * (PS1 - PS0) + lambda * (QS0 + t * (QS1 - QS0) - PS0 - t * (PS1 - PS0));
+
+        // Signed distance at the end on the side of the beginning: f0 f1 / (|f0| |Q1-P1|) < r
+        T toi = if_less(f01, radius * sqrt(f0 * f0) * length1, t, miss);
+        toi = if_less(f0 * f0, hung2 * length0_2, miss, toi);
+        toi = if_less(length0_2, r2, miss, if_less(length1, radius, miss, toi));
+        toi = if_less(lambda, zero, miss, if_less(one, lambda, miss, toi));
+        toi = if_less(s, s_min, miss, if_less(s_max, s, miss, toi));
+        toi.store(edge_toi + k);
+    }
+    return k;
+}
+
+template <typename V, typename S>
+void kernel_wire_impact(simd_sweep_lanes const& c, simd_wire_parameters const& w, int ku_begin, int ku_end, int kv_begin, int kv_end)
+{
+    wire_frame<V> const frame_v(w);
+    wire_frame<S> const frame_s(w);
+
+    // The edges (k, k+1) of the last column and (k, k+N_x) of the last row do not exist
+    int const kx_end = ku_end < c.N_x - 1 ? ku_end : c.N_x - 1;
+    for (int kv = kv_begin; kv < kv_end; ++kv)
+    {
+        int const k_begin = ku_begin + c.N_x * kv;
+        int k = wire_vertex_range<V>(c, frame_v, w, k_begin, ku_end + c.N_x * kv);
+        wire_vertex_range<S>(c, frame_s, w, k, ku_end + c.N_x * kv);
+
+        k = wire_edge_range<V>(c, frame_v, w, 1, c.edge_toi_x, k_begin, kx_end + c.N_x * kv);
+        wire_edge_range<S>(c, frame_s, w, 1, c.edge_toi_x, k, kx_end + c.N_x * kv);
+
+        if (kv < c.N_y - 1) {
+            k = wire_edge_range<V>(c, frame_v, w, c.N_x, c.edge_toi_y, k_begin, ku_end + c.N_x * kv);
+            wire_edge_range<S>(c, frame_s, w, c.N_x, c.edge_toi_y, k, ku_end + c.N_x * kv);
+        }
+    }
+}
+
+// Bounding box {x_min, y_min, z_min, x_max, y_max, z_max} of the start and end positions of a tile
+template <typename V, typename S>
+void kernel_sweep_bounds(simd_sweep_lanes const& c, float* box, int ku_begin, int ku_end, int kv_begin, int kv_end)
+{
+    int const k0 = ku_begin + c.N_x * kv_begin;
+    V x_min = V::set1(c.x0[k0]), y_min = V::set1(c.y0[k0]), z_min = V::set1(c.z0[k0]);
+    V x_max = x_min, y_max = y_min, z_max = z_min;
+    S xs_min = S::set1(c.x0[k0]), ys_min = S::set1(c.y0[k0]), zs_min = S::set1(c.z0[k0]);
+    S xs_max = xs_min, ys_max = ys_min, zs_max = zs_min;
+
+    for (int kv = kv_begin; kv < kv_end; ++kv)
+    {
+        int const k_end = ku_end + c.N_x * kv;
+        int k = ku_begin + c.N_x * kv;
+        for (; k + V::width <= k_end; k += V::width)
+        {
+            V const x0 = V::load(c.x0 + k), y0 = V::load(c.y0 + k), z0 = V::load(c.z0 + k);
+            V const x1 = V::load(c.x1 + k), y1 = V::load(c.y1 + k), z1 = V::load(c.z1 + k);
+            x_min = min(x_min, min(x0, x1)); y_min = min(y_min, min(y0, y1)); z_min = min(z_min, min(z0, z1));
+            x_max = max(x_max, max(x0, x1)); y_max = max(y_max, max(y0, y1)); z_max = max(z_max, max(z0, z1));
+        }
+        for (; k < k_end; ++k)
+        {
+            S const x0 = S::load(c.x0 + k), y0 = S::load(c.y0 + k), z0 = S::load(c.z0 + k);
+            S const x1 = S::load(c.x1 + k), y1 = S::load(c.y1 + k), z1 = S::load(c.z1 + k);
+            xs_min = min(xs_min, min(x0, x1)); ys_min = min(ys_min, min(y0, y1)); zs_min = min(zs_min, min(z0, z1));
+            xs_max = max(xs_max, max(x0, x1)); ys_max = max(ys_max, max(y0, y1)); zs_max = max(zs_max, max(z0, z1));
+        }
+    }
+
+    // Reduction of the lanes
+    float lanes[6][V::width];
+    x_min.store(lanes[0]); y_min.store(lanes[1]); z_min.store(lanes[2]);
+    x_max.store(lanes[3]); y_max.store(lanes[4]); z_max.store(lanes[5]);
+    xs_min.store(box + 0); ys_min.store(box + 1); zs_min.store(box + 2);
+    xs_max.store(box + 3); ys_max.store(box + 4); zs_max.store(box + 5);
+    for (int i = 0; i < V::width; ++i)
+    {
+        for (int d = 0; d < 3; ++d) {
+            box[d] = lanes[d][i] < box[d] ? lanes[d][i] : box[d];
+            box[d + 3] = lanes[d + 3][i] > box[d + 3] ? lanes[d + 3][i] : box[d + 3];
+        }
+    }
+}
+
+// Unit normal of the triangle (p, p+a, p+b) added to n, unless the triangle is degenerated (a missing neighbor of a
+//  vertex of the border is given as the vertex itself: a = 0 or b = 0)
+template <typename T>
+void normal_triangle_add(T const& ax, T const& ay, T const& az, T const& bx, T const& by, T const& bz, T& nx, T& ny, T& nz)
+{
+    T const epsilon = T::set1(1e-24f);
+    T const cx = ay * bz - az * by;
+    T const cy = az * bx - ax * bz;
+    T const cz = ax * by - ay * bx;
+    T const c2 = cx * cx + cy * cy + cz * cz;
+    T const s = if_less(c2, epsilon, T::set1(0.0f), T::set1(1.0f) / sqrt(max(c2, epsilon)));
+    nx = nx + s * cx;
+    ny = ny + s * cy;
+    nz = nz + s * cz;
+}
+
+// Normals of the vertices [k_begin, k_end) whose 6 neighbors are at the given offsets, returns the first vertex that has
+//  not been processed. The neighbors turn around the vertex: two consecutive ones form a triangle of the grid.
+template <typename T>
+int grid_normal_range(simd_normal_lanes const& c, int const* offset, int k_begin, int k_end)
+{
+    T const zero = T::set1(0.0f), one = T::set1(1.0f), epsilon = T::set1(1e-12f);
+
+    int k = k_begin;
+    for (; k + T::width <= k_end; k += T::width)
+    {
+        T const px = T::load(c.px + k), py = T::load(c.py + k), pz = T::load(c.pz + k);
+        T ex[6], ey[6], ez[6];
+        for (int i = 0; i < 6; ++i) {
+            ex[i] = T::load(c.px + k + offset[i]) - px;
+            ey[i] = T::load(c.py + k + offset[i]) - py;
+            ez[i] = T::load(c.pz + k + offset[i]) - pz;
+        }
+
+        T nx = zero, ny = zero, nz = zero;
+        for (int i = 0; i < 6; ++i) {
+            int const j = i < 5 ? i + 1 : 0;
+            normal_triangle_add(ex[i], ey[i], ez[i], ex[j], ey[j], ez[j], nx, ny, nz);
+        }
+
+        // A vertex without any valid triangle keeps a null normal
+        T const n2 = nx * nx + ny * ny + nz * nz;
+        T const s = if_less(n2, epsilon, one, one / sqrt(max(n2, epsilon)));
+        (s * nx).store(c.nx + k);
+        (s * ny).store(c.ny + k);
+        (s * nz).store(c.nz + k);
+    }
+    return k;
+}
+
+// The quad k is split in the triangles (k, k+N_x+1, k+1) and (k, k+N_x, k+N_x+1) (connectivity of mesh_primitive_grid):
+//  around the vertex (ku,kv), the neighbors (ku,kv-1), (ku-1,kv-1), (ku-1,kv), (ku,kv+1), (ku+1,kv+1), (ku+1,kv) taken
+//  two by two give its 6 triangles with the orientation of the grid. The inner vertices are vectorized, the vertices of the border replace their missing
+//  neighbors by themselves.
+template <typename V, typename S>
+void kernel_grid_normal(simd_normal_lanes const& c, int kv_begin, int kv_end)
+{
+    int const N_x = c.N_x;
+    int const N_y = c.N_y;
+    int const du[6] = { 0, -1, -1, 0, 1, 1 };
+    int const dv[6] = { -1, -1, 0, 1, 1, 0 };
+    int inner[6];
+    for (int i = 0; i < 6; ++i)
+        inner[i] = du[i] + N_x * dv[i];
+
+    for (int kv = kv_begin; kv < kv_end; ++kv)
+    {
+        int const k_row = N_x * kv;
+        bool const inner_row = kv > 0 && kv < N_y - 1;
+        for (int ku = 0; ku < N_x; ku = (inner_row && ku == 0) ? N_x - 1 : ku + 1)
+        {
+            int offset[6];
+            for (int i = 0; i < 6; ++i) {
+                int const u = ku + du[i];
+                int const v = kv + dv[i];
+                offset[i] = (u >= 0 && u < N_x && v >= 0 && v < N_y) ? inner[i] : 0;
+            }
+            grid_normal_range<S>(c, offset, k_row + ku, k_row + ku + 1);
+        }
+
+        if (inner_row) {
+            int const k = grid_normal_range<V>(c, inner, k_row + 1, k_row + N_x - 1);
+            grid_normal_range<S>(c, inner, k, k_row + N_x - 1);
+        }
+    }
+}
+
+// Conversions between the arrays of vec3 and the lanes, element by element (the x86 kernels transpose 4 vertices at
+//  once, see kernels_x86.hpp)
+template <typename S>
+void kernel_deinterleave(float const* aos, float* x, float* y, float* z, int k_begin, int k_end)
+{
+    for (int k = k_begin; k < k_end; ++k) {
+        S::load(aos + 3 * k).store(x + k);
+        S::load(aos + 3 * k + 1).store(y + k);
+        S::load(aos + 3 * k + 2).store(z + k);
+    }
+}
+
+template <typename S>
+void kernel_interleave(float const* x, float const* y, float const* z, float* aos, int k_begin, int k_end)
+{
+    for (int k = k_begin; k < k_end; ++k) {
+        S::load(x + k).store(aos + 3 * k);
+        S::load(y + k).store(aos + 3 * k + 1);
+        S::load(z + k).store(aos + 3 * k + 2);
+    }
+}
+
+} // namespace
@@ -0,0 +1,47 @@
+#include "kernels_impl.hpp"
+
+#include <cmath>
+
+// Portable fallback: the generic kernels instantiated on plain floats
+
+namespace {
+
+struct float_scalar
+{
+    static const int width = 1;
+    float v;
+
+    static float_scalar load(float const* p) { return { *p }; }
+    static float_scalar set1(float a) { return { a }; }
+    void store(float* p) const { *p = v; }
+};
+inline float_scalar operator+(float_scalar a, float_scalar b) { return { a.v + b.v }; }
+inline float_scalar operator-(float_scalar a, float_scalar b) { return { a.v - b.v }; }
+inline float_scalar operator*(float_scalar a, float_scalar b) { return { a.v * b.v }; }
+inline float_scalar operator/(float_scalar a, float_scalar b) { return { a.v / b.v }; }
+inline float_scalar sqrt(float_scalar a) { return { std::sqrt(a.v) }; }
+inline float_scalar min(float_scalar a, float_scalar b) { return { a.v < b.v ? a.v : b.v }; }
+inline float_scalar max(float_scalar a, float_scalar b) { return { a.v > b.v ? a.v : b.v }; }
+inline float_scalar if_less(float_scalar a, float_scalar b, float_scalar x, float_scalar y) { return { a.v < b.v ? x.v : y.v }; }
+
+simd_kernel_table const table = {
+    "scalar",
+    kernel_external_force<float_scalar, float_scalar>,
+    kernel_spring_force<float_scalar, float_scalar>,
+    kernel_spring_force_gather<float_scalar, float_scalar>,
+    kernel_aerodynamic_force<float_scalar, float_scalar>,
+    kernel_aerodynamic_gather<float_scalar, float_scalar>,
+    kernel_integrate<float_scalar, float_scalar>,
+    kernel_wire_impact<float_scalar, float_scalar>,
+    kernel_sweep_bounds<float_scalar, float_scalar>,
+    kernel_grid_normal<float_scalar, float_scalar>,
+    kernel_deinterleave<float_scalar>,
+    kernel_interleave<float_scalar>
+};
+
+} // namespace
+
+simd_kernel_table const* simd_kernel_table_scalar()
+{
+    return &table;
+}
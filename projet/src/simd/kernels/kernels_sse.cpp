@@ -0,0 +1,60 @@
+#include "kernels_impl.hpp"
+#include "kernels_x86.hpp"
+
+// SSE kernels: 4 floats per register
+
+#ifdef SIMD_KERNELS_X86
+
+namespace {
+
+struct float_sse
+{
+    static const int width = 4;
+    __m128 v;
+
+    static float_sse load(float const* p) { return { _mm_loadu_ps(p) }; }
+    static float_sse set1(float a) { return { _mm_set1_ps(a) }; }
+    void store(float* p) const { _mm_storeu_ps(p, v); }
+};
+inline float_sse operator+(float_sse a, float_sse b) { return { _mm_add_ps(a.v, b.v) }; }
+inline float_sse operator-(float_sse a, float_sse b) { return { _mm_sub_ps(a.v, b.v) }; }
+inline float_sse operator*(float_sse a, float_sse b) { return { _mm_mul_ps(a.v, b.v) }; }
+inline float_sse operator/(float_sse a, float_sse b) { return { _mm_div_ps(a.v, b.v) }; }
+inline float_sse sqrt(float_sse a) { return { _mm_sqrt_ps(a.v) }; }
+inline float_sse min(float_sse a, float_sse b) { return { _mm_min_ps(a.v, b.v) }; }
+inline float_sse max(float_sse a, float_sse b) { return { _mm_max_ps(a.v, b.v) }; }
+inline float_sse if_less(float_sse a, float_sse b, float_sse x, float_sse y) {
+    __m128 const mask = _mm_cmplt_ps(a.v, b.v);
+    return { _mm_or_ps(_mm_and_ps(mask, x.v), _mm_andnot_ps(mask, y.v)) };
+}
+
+simd_kernel_table const table = {
+    "sse",
+    kernel_external_force<float_sse, float_ss>,
+    kernel_spring_force<float_sse, float_ss>,
+    kernel_spring_force_gather<float_sse, float_ss>,
+    kernel_aerodynamic_force<float_sse, float_ss>,
+    kernel_aerodynamic_gather<float_sse, float_ss>,
+    kernel_integrate<float_sse, float_ss>,
+    kernel_wire_impact<float_sse, float_ss>,
+    kernel_sweep_bounds<float_sse, float_ss>,
+    kernel_grid_normal<float_sse, float_ss>,
+    kernel_deinterleave_x86,
+    kernel_interleave_x86
+};
+
+} // namespace
+
+simd_kernel_table const* simd_kernel_table_sse()
+{
+    return &table;
+}
+
+#else
+
+simd_kernel_table const* simd_kernel_table_sse()
+{
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "kernels.hpp"
+
+#ifdef SIMD_KERNELS_X86
+
+#include <immintrin.h>
+
+// Single-float type on the low element of an SSE register, used for the remaining elements of the x86 kernels
+namespace {
+
+struct float_ss
+{
+    static const int width = 1;
+    __m128 v;
+
+    static float_ss load(float const* p) { return { _mm_load_ss(p) }; }
+    static float_ss set1(float a) { return { _mm_set_ss(a) }; }
+    void store(float* p) const { _mm_store_ss(p, v); }
+};
+inline float_ss operator+(float_ss a, float_ss b) { return { _mm_add_ss(a.v, b.v) }; }
+inline float_ss operator-(float_ss a, float_ss b) { return { _mm_sub_ss(a.v, b.v) }; }
+inline float_ss operator*(float_ss a, float_ss b) { return { _mm_mul_ss(a.v, b.v) }; }
+inline float_ss operator/(float_ss a, float_ss b) { return { _mm_div_ss(a.v, b.v) }; }
+inline float_ss sqrt(float_ss a) { return { _mm_sqrt_ss(a.v) }; }
+inline float_ss min(float_ss a, float_ss b) { return { _mm_min_ss(a.v, b.v) }; }
+inline float_ss max(float_ss a, float_ss b) { return { _mm_max_ss(a.v, b.v) }; }
+inline float_ss if_less(float_ss a, float_ss b, float_ss x, float_ss y) {
+    __m128 const mask = _mm_cmplt_ss(a.v, b.v);
+    return { _mm_or_ps(_mm_and_ps(mask, x.v), _mm_andnot_ps(mask, y.v)) };
+}
+
+// Conversions between the arrays of vec3 and the lanes: 4 vertices (3 registers) are transposed at once by shuffles.
+//  Shared by all the x86 kernels (SSE is available in each of them).
+inline void kernel_deinterleave_x86(float const* aos, float* x, float* y, float* z, int k_begin, int k_end)
+{
+    int k = k_begin;
+    for (; k + 4 <= k_end; k += 4)
+    {
+        // a = x0 y0 z0 x1, b = y1 z1 x2 y2, c = z2 x3 y3 z3
+        __m128 const a = _mm_loadu_ps(aos + 3 * k);
+        __m128 const b = _mm_loadu_ps(aos + 3 * k + 4);
+        __m128 const c = _mm_loadu_ps(aos + 3 * k + 8);
+        _mm_storeu_ps(x + k, _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0)));
+        _mm_storeu_ps(y + k, _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(z + k, _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0)));
+    }
+    for (; k < k_end; ++k) {
+        x[k] = aos[3 * k];
+        y[k] = aos[3 * k + 1];
+        z[k] = aos[3 * k + 2];
+    }
+}
+
+inline void kernel_interleave_x86(float const* x, float const* y, float const* z, float* aos, int k_begin, int k_end)
+{
+    int k = k_begin;
+    for (; k + 4 <= k_end; k += 4)
+    {
+        __m128 const xs = _mm_loadu_ps(x + k);
+        __m128 const ys = _mm_loadu_ps(y + k);
+        __m128 const zs = _mm_loadu_ps(z + k);
+        _mm_storeu_ps(aos + 3 * k, _mm_shuffle_ps(_mm_shuffle_ps(xs, ys, _MM_SHUFFLE(0, 0, 0, 0)), _mm_shuffle_ps(zs, xs, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(aos + 3 * k + 4, _mm_shuffle_ps(_mm_shuffle_ps(ys, zs, _MM_SHUFFLE(1, 1, 1, 1)), _mm_shuffle_ps(xs, ys, _MM_SHUFFLE(2, 2, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(aos + 3 * k + 8, _mm_shuffle_ps(_mm_shuffle_ps(zs, xs, _MM_SHUFFLE(3, 3, 2, 2)), _mm_shuffle_ps(ys, zs, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0)));
+    }
+    for (; k < k_end; ++k) {
+        aos[3 * k] = x[k];
+        aos[3 * k + 1] = y[k];
+        aos[3 * k + 2] = z[k];
+    }
+}
+
+} // namespace
+
+#endif
@@ -0,0 +1,9 @@
+#pragma once
+
+// Thresholds of the parallel loops of the simulation, shared by its modules so that they are tuned in one place.
+//  Large cloths are split into tiles of rows (forces, integration, constraints, collisions, normals), each tile being
+//  processed by one thread.
+int const tile_rows = 8;                      // number of rows of a tile
+int const parallel_vertex_threshold = 16384;  // minimal number of vertices of a cloth to use several threads
+int const parallel_spring_threshold = 20000;  // minimal number of springs to share the runs of a batch between threads
+int const parallel_solve_threshold = 2000;    // minimal number of vertices to solve the 3 coordinates in parallel
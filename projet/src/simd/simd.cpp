@@ -0,0 +1,146 @@
+#include "simd.hpp"
+
+#if defined(SIMD_KERNELS_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+using namespace cgp;
+
+static_assert(sizeof(vec3) == 3 * sizeof(float), "vec3 is expected to be stored as 3 contiguous floats");
+
+
+// Kernel table of a given instruction set (nullptr if not compiled in)
+static simd_kernel_table const* kernel_table(simd_isa isa)
+{
+    switch (isa)
+    {
+    case simd_isa::avx512: return simd_kernel_table_avx512();
+    case simd_isa::avx2: return simd_kernel_table_avx2();
+    case simd_isa::sse: return simd_kernel_table_sse();
+    default: return simd_kernel_table_scalar();
+    }
+}
+
+// Check if the CPU (and the OS) supports the instruction set
+static bool cpu_supports(simd_isa isa)
+{
+#if defined(SIMD_KERNELS_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    int const max_leaf = info[0];
+    __cpuid(info, 1);
+    bool const sse2 = (info[3] & (1 << 26)) != 0;
+    bool const osxsave = (info[2] & (1 << 27)) != 0;
+    unsigned long long const xcr0 = osxsave ? _xgetbv(0) : 0;
+    bool avx2 = false, avx512f = false;
+    if (max_leaf >= 7) {
+        __cpuidex(info, 7, 0);
+        avx2 = (info[1] & (1 << 5)) != 0;
+        avx512f = (info[1] & (1 << 16)) != 0;
+    }
+    switch (isa)
+    {
+    case simd_isa::avx512: return avx512f && (xcr0 & 0xe6) == 0xe6; // OS saves the zmm/opmask registers
+    case simd_isa::avx2: return avx2 && (xcr0 & 0x6) == 0x6;        // OS saves the ymm registers
+    case simd_isa::sse: return sse2;
+    default: return true;
+    }
+#elif defined(SIMD_KERNELS_X86)
+    __builtin_cpu_init();
+    switch (isa)
+    {
+    case simd_isa::avx512: return __builtin_cpu_supports("avx512f");
+    case simd_isa::avx2: return __builtin_cpu_supports("avx2");
+    case simd_isa::sse: return __builtin_cpu_supports("sse2");
+    default: return true;
+    }
+#else
+    return isa == simd_isa::scalar;
+#endif
+}
+
+// Best available instruction set that is lower or equal to the requested one
+static simd_isa best_isa(simd_isa requested)
+{
+    for (int k = static_cast<int>(requested); k > 0; --k) {
+        simd_isa const isa = static_cast<simd_isa>(k);
+        if (kernel_table(isa) != nullptr && cpu_supports(isa))
+            return isa;
+    }
+    return simd_isa::scalar;
+}
+
+static simd_isa& selected_isa()
+{
+    static simd_isa isa = simd_detect_isa();
+    return isa;
+}
+
+simd_isa simd_detect_isa()
+{
+    static simd_isa const isa = best_isa(simd_isa::avx512);
+    return isa;
+}
+
+simd_kernel_table const& simd_kernels()
+{
+    return *kernel_table(selected_isa());
+}
+
+simd_isa simd_current_isa()
+{
+    return selected_isa();
+}
+
+void simd_select_isa(simd_isa isa)
+{
+    selected_isa() = best_isa(isa);
+}
+
+
+
+void simd_vec3_lanes::resize(int N)
+{
+    x.resize(N);
+    y.resize(N);
+    z.resize(N);
+}
+
+int simd_vec3_lanes::size() const
+{
+    return static_cast<int>(x.size());
+}
+
+void simd_vec3_lanes::load(numarray<vec3> const& buffer)
+{
+    int const N = buffer.size();
+    resize(N);
+    load(buffer, 0, N);
+}
+
+void simd_vec3_lanes::store(numarray<vec3>& buffer) const
+{
+    int const N = size();
+    buffer.resize(N);
+    store(buffer, 0, N);
+}
+
+void simd_vec3_lanes::load(numarray<vec3> const& buffer, int k_begin, int k_end)
+{
+    simd_kernels().deinterleave(simd_flat(buffer), x.data(), y.data(), z.data(), k_begin, k_end);
+}
+
+void simd_vec3_lanes::store(numarray<vec3>& buffer, int k_begin, int k_end) const
+{
+    simd_kernels().interleave(x.data(), y.data(), z.data(), simd_flat(buffer), k_begin, k_end);
+}
+
+float* simd_flat(numarray<vec3>& buffer)
+{
+    return reinterpret_cast<float*>(buffer.data.data());
+}
+
+float const* simd_flat(numarray<vec3> const& buffer)
+{
+    return reinterpret_cast<float const*>(buffer.data.data());
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "../cgp_headless.hpp"
+#include "kernels/kernels.hpp"
+
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+
+// Instruction sets of the vectorized simulation kernels, ordered by preference
+enum class simd_isa { scalar, sse, avx2, avx512 };
+
+// Best instruction set supported both by the CPU and by the compiled kernels (detected once)
+simd_isa simd_detect_isa();
+
+// Kernels used by the simulation (the best detected instruction set by default)
+simd_kernel_table const& simd_kernels();
+simd_isa simd_current_isa();
+
+// Force the use of a given instruction set (ex. to compare the performances).
+//  Falls back to the best supported one if the requested one is not available.
+void simd_select_isa(simd_isa isa);
+
+
+// Allocator returning memory aligned on a cache line (suitable for any vector register up to 512 bits)
+template <typename T>
+struct simd_allocator
+{
+    using value_type = T;
+    static const std::size_t alignment = 64;
+
+    simd_allocator() = default;
+    template <typename U> simd_allocator(simd_allocator<U> const&) {}
+
+    T* allocate(std::size_t n);
+    void deallocate(T* p, std::size_t n);
+};
+template <typename T, typename U> bool operator==(simd_allocator<T> const&, simd_allocator<U> const&) { return true; }
+template <typename T, typename U> bool operator!=(simd_allocator<T> const&, simd_allocator<U> const&) { return false; }
+
+// Aligned buffer of floats
+using simd_buffer = std::vector<float, simd_allocator<float> >;
+
+// Structure-of-arrays storage of a buffer of vec3: x, y and z are stored in separate aligned lanes
+struct simd_vec3_lanes
+{
+    simd_buffer x;
+    simd_buffer y;
+    simd_buffer z;
+
+    void resize(int N);
+    int size() const;
+
+    void load(cgp::numarray<cgp::vec3> const& buffer); // Copy from an array of vec3 (AoS -> SoA)
+    void store(cgp::numarray<cgp::vec3>& buffer) const; // Copy to an array of vec3 (SoA -> AoS)
+
+    // Copy of the elements [k_begin, k_end) only (the lanes and the buffer must already have the same size)
+    void load(cgp::numarray<cgp::vec3> const& buffer, int k_begin, int k_end);
+    void store(cgp::numarray<cgp::vec3>& buffer, int k_begin, int k_end) const;
+};
+
+// Access to an array of vec3 as a flat buffer of 3N floats
+float* simd_flat(cgp::numarray<cgp::vec3>& buffer);
+float const* simd_flat(cgp::numarray<cgp::vec3> const& buffer);
+
+
+
+template <typename T>
+T* simd_allocator<T>::allocate(std::size_t n)
+{
+    // Over-allocate and store the original pointer just before the aligned block
+    void* raw = std::malloc(n * sizeof(T) + alignment + sizeof(void*));
+    if (raw == nullptr)
+        throw std::bad_alloc();
+    std::size_t const address = reinterpret_cast<std::size_t>(raw) + sizeof(void*);
+    void* aligned = reinterpret_cast<void*>((address + alignment - 1) & ~(alignment - 1));
+    static_cast<void**>(aligned)[-1] = raw;
+    return static_cast<T*>(aligned);
+}
+
+template <typename T>
+void simd_allocator<T>::deallocate(T* p, std::size_t)
+{
+    if (p != nullptr)
+        std::free(reinterpret_cast<void**>(p)[-1]);
+}
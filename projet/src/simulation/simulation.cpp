@@ -1,14 +1,50 @@
 #include "simulation.hpp"
 
+#include "../simd/parallel.hpp"
+
 using namespace cgp;
 
 
+// Enlargement of the bounding box of a cloth in the broadphase of the obstacles
+static float const obstacle_margin = 0.05f;
+
+static int tile_count(cloth_structure const& cloth)
+{
+    return (cloth.N_samples_y() + tile_rows - 1) / tile_rows;
+}
+
+// Air velocity at the vertices of the rows [kv_begin, kv_end), sampled in the wind field shared by the cloths
+//  (or evaluated from the cone of the fan)
+static void sample_air_velocity(cloth_structure& cloth, simulation_parameters const& parameters, int kv_begin, int kv_end)
+{
+    wind_field_structure const* field = parameters.wind.field;
+    simd_vec3_lanes& air = cloth.air_velocity_lanes;
+    int const N_x = cloth.N_samples_x();
+    for (int k = N_x * kv_begin; k < N_x * kv_end; ++k)
+    {
+        vec3 const& p = cloth.position.data[k];
+        vec3 const w = field != nullptr ? field->sample(p) : wind_fan_evaluate(p, parameters.wind.source, parameters.wind.direction, parameters.wind.magnitude, parameters.wind.aperture);
+        air.x[k] = w.x;
+        air.y[k] = w.y;
+        air.z[k] = w.z;
+    }
+}
+
+static simd_aerodynamic_lanes aerodynamic_lanes(cloth_structure& cloth)
+{
+    simd_aerodynamic_lanes air;
+    air.ax = cloth.air_velocity_lanes.x.data(); air.ay = cloth.air_velocity_lanes.y.data(); air.az = cloth.air_velocity_lanes.z.data();
+    air.f0x = cloth.triangle_force_lanes[0].x.data(); air.f0y = cloth.triangle_force_lanes[0].y.data(); air.f0z = cloth.triangle_force_lanes[0].z.data();
+    air.f1x = cloth.triangle_force_lanes[1].x.data(); air.f1y = cloth.triangle_force_lanes[1].y.data(); air.f1z = cloth.triangle_force_lanes[1].z.data();
+    return air;
+}
+
 // Fill value of force applied on each particle
 // - Gravity
 // - Drag
-// - Spring force
-// - Wind force
-void simulation_compute_force(cloth_structure& cloth, simulation_parameters const& parameters)
+// - Spring force (if with_springs is true)
+// - Wind force (aerodynamic drag and lift of the triangles)
+static void compute_force(cloth_structure& cloth, simulation_parameters const& parameters, bool with_springs)
 {
     // Direct access to the variables
     //  Note: A grid_2D is a structure you can access using its 2d-local index coordinates as grid_2d(k1,k2)
@@ -18,7 +54,6 @@ void simulation_compute_force(cloth_structure& cloth, simulation_parameters cons
 
     grid_2D<vec3> const& position = cloth.position;  // Storage for the positions of the vertices
     grid_2D<vec3> const& velocity = cloth.velocity;  // Storage for the normals of the vertices
-    grid_2D<vec3> const& normal = cloth.normal;      // Storage for the velocity of the vertices
     
 
     size_t const N_total = cloth.position.size();       // total number of vertices
@@ -30,119 +65,245 @@ void simulation_compute_force(cloth_structure& cloth, simulation_parameters cons
     float const K = cloth.K;              // spring stifness
     float const m = cloth.mass_total / N_total; // mass of a particle
     float const mu = cloth.mu;            // damping/friction coefficient
-    float const	L0_x = cloth.lenght_x / (N_x - 1.0f);        // rest length between two direct neighboring particle
-    float const	L0_y = cloth.lenght_y / (N_y - 1.0f);        // rest length between two direct neighboring particle
 
 
-    // Gravity
-    const vec3 g = { 0,0,-9.81f };
-    for (int ku = 0; ku < N_x; ++ku)
-        for (int kv = 0; kv < N_y; ++kv)
-            force(ku, kv) = m * g;
+    // Gravity, drag and spring forces
+    //  Evaluated by the vectorized kernels (SSE/AVX2/AVX-512 selected at runtime, scalar fallback) on the
+    //  structure-of-arrays copy of the state. The arrays of vec3 stay the state of the cloth, shared with the solvers,
+    //  the collisions and the rendering: the copy (transposed by the kernels) is the price of the vectorized forces.
+    cloth.position_lanes.resize(N_total);
+    cloth.velocity_lanes.resize(N_total);
+    cloth.force_lanes.resize(N_total);
+
+    simd_cloth_lanes lanes;
+    lanes.px = cloth.position_lanes.x.data(); lanes.py = cloth.position_lanes.y.data(); lanes.pz = cloth.position_lanes.z.data();
+    lanes.vx = cloth.velocity_lanes.x.data(); lanes.vy = cloth.velocity_lanes.y.data(); lanes.vz = cloth.velocity_lanes.z.data();
+    lanes.fx = cloth.force_lanes.x.data(); lanes.fy = cloth.force_lanes.y.data(); lanes.fz = cloth.force_lanes.z.data();
+    lanes.N_x = N_x;
+    lanes.N_y = N_y;
+
+    simd_force_parameters kernel_parameters;
+    kernel_parameters.m = m;
+    kernel_parameters.mu = mu;
+    kernel_parameters.K[spring_structural] = K;
+    kernel_parameters.K[spring_shear] = K;
+    kernel_parameters.K[spring_bending] = K;
+    kernel_parameters.gx = 0.0f;
+    kernel_parameters.gy = 0.0f;
+    kernel_parameters.gz = -9.81f;
+
+    simd_kernel_table const& kernels = simd_kernels();
+    spring_structure const& springs = cloth.springs;
+
+    bool const with_wind = parameters.wind.magnitude != 0;
+    simd_aerodynamic_lanes const air = aerodynamic_lanes(cloth);
+    simd_aerodynamic_parameters aerodynamic_parameters;
+    aerodynamic_parameters.drag = parameters.wind.air_density * parameters.wind.drag_coefficient / 12.0f;
+    aerodynamic_parameters.lift = parameters.wind.air_density * parameters.wind.lift_coefficient / 12.0f;
+
+    if (N_total < parallel_vertex_threshold)
+    {
+        cloth.position_lanes.load(position.data);
+        cloth.velocity_lanes.load(velocity.data);
+        kernels.external_force(lanes, kernel_parameters, 0, N_total);
+
+        // Each spring is evaluated once and applied to its two extremities
+        if (with_springs)
+            kernels.spring_force(lanes, springs.runs.data(), springs.runs.size(), kernel_parameters);
+
+        if (with_wind) {
+            sample_air_velocity(cloth, parameters, 0, N_y);
+            kernels.aerodynamic_force(lanes, air, aerodynamic_parameters, 0, N_y - 1);
+            kernels.aerodynamic_gather(lanes, air, 0, N_total);
+        }
 
-    // Drag (= friction)
-    for (int ku = 0; ku < N_x; ++ku)
-        for (int kv = 0; kv < N_y; ++kv)
-            force(ku, kv) += -mu * m * velocity(ku, kv);
+        cloth.force_lanes.store(force.data);
+        return;
+    }
 
+    // Large cloth: tiles of rows processed in parallel.
+    //  The springs reach up to 2 rows above and below a tile (bending springs), and the triangles one row above: the
+    //  state of these halo rows must be copied to the lanes by the other tiles before any force is evaluated.
+    int const N_tile = tile_count(cloth);
+    #pragma omp parallel for
+    for (int t = 0; t < N_tile; ++t)
+    {
+        int const kv_begin = t * tile_rows;
+        int const kv_end = std::min<int>(kv_begin + tile_rows, N_y);
+        cloth.position_lanes.load(position.data, N_x * kv_begin, N_x * kv_end);
+        cloth.velocity_lanes.load(velocity.data, N_x * kv_begin, N_x * kv_end);
+        if (with_wind)
+            sample_air_velocity(cloth, parameters, kv_begin, kv_end);
+    }
 
-    // TO DO: Add spring forces ...
-    for (int ku = 0; ku < N_x; ++ku) {
-        for (int kv = 0; kv < N_y; ++kv) 
-        {
-            // ...
-            // force(ku,kv) = ... fill here the force exerted by all the springs attached to the vertex at coordinates (ku,kv).
-            // 
-            // Notes:
-            //   - The vertex positions can be accessed as position(ku,kv)
-            //   - The neighbors are at position(ku+1,kv), position(ku-1,kv), position(ku,kv+1), etc. when ku+offset is still in the grid dimension.
-            //   - You may want to loop over all the neighbors of a vertex to add each contributing force to this vertex
-            //   - To void repetitions and limit the need of debuging, it may be a good idea to define a generic function that computes the spring force between two positions given the parameters K and L0
-            //   - If the simulation is a bit too slow, you can speed it up in adapting the parameter N_step in scene.cpp that loops over several simulation step between two displays.
-
-            auto spring_force = [&](int x, int y, float L) 
-            {
-                vec3 const& p1 = position(ku, kv);
-                vec3 const& p2 = position(x, y);
-                force(ku, kv) += K * (norm(p2 - p1) - L) * (p2 - p1) / norm(p2 - p1);
-            };
-
-            // voisins a 1 de distance
-            if (ku + 1 < N_x) spring_force(ku + 1, kv, L0_x);
-            if (ku - 1 >= 0) spring_force(ku - 1, kv, L0_x);
-            if (kv + 1 < N_y) spring_force(ku, kv + 1, L0_y);
-            if (kv - 1 >= 0) spring_force(ku, kv - 1, L0_y);
-
-            // voisins diagonales
-            if (ku + 1 < N_x && kv + 1 < N_y) spring_force(ku + 1, kv + 1, sqrt(L0_x*L0_x + L0_y*L0_y));
-            if (ku - 1 >= 0 && kv - 1 >= 0) spring_force(ku - 1, kv - 1, sqrt(L0_x*L0_x + L0_y*L0_y));
-            if (ku + 1 < N_x && kv - 1 >= 0) spring_force(ku + 1, kv - 1, sqrt(L0_x*L0_x + L0_y*L0_y));
-            if (ku - 1 >= 0 && kv + 1 < N_y) spring_force(ku - 1, kv + 1, sqrt(L0_x*L0_x + L0_y*L0_y));
-
-            // voisins à 2 de distance
-            if (ku + 2 < N_x) spring_force(ku + 2, kv, 2 * L0_x);
-            if (ku - 2 >= 0) spring_force(ku - 2, kv, 2 * L0_x);
-            if (kv + 2 < N_y) spring_force(ku, kv + 2, 2 * L0_y);
-            if (kv - 2 >= 0) spring_force(ku, kv - 2, 2 * L0_y);
+    //  Each tile only writes the forces of its own vertices: every spring is evaluated from both of its extremities
+    //  (gather table), and the halo rows are only read. The triangles of the quads of the tile are evaluated once.
+    #pragma omp parallel for
+    for (int t = 0; t < N_tile; ++t)
+    {
+        int const kv_begin = t * tile_rows;
+        int const kv_end = std::min<int>(kv_begin + tile_rows, N_y);
+        int const k_begin = N_x * kv_begin;
+        int const k_end = N_x * kv_end;
+
+        kernels.external_force(lanes, kernel_parameters, k_begin, k_end);
+        if (with_springs) {
+            int const run_begin = springs.gather_row_offset[kv_begin];
+            int const run_end = springs.gather_row_offset[kv_end];
+            kernels.spring_force_gather(lanes, springs.gather_runs.data() + run_begin, run_end - run_begin, kernel_parameters);
         }
+        if (with_wind)
+            kernels.aerodynamic_force(lanes, air, aerodynamic_parameters, kv_begin, std::min<int>(kv_end, N_y - 1));
+        else
+            cloth.force_lanes.store(force.data, k_begin, k_end);
     }
 
-    // Wind force
-
-    for (int ku = 0; ku < N_x; ++ku) {
-        for (int kv = 0; kv < N_y; ++kv) 
+    //  The vertices of the first row of a tile also receive the forces of the triangles of the previous tile
+    if (with_wind)
+    {
+        #pragma omp parallel for
+        for (int t = 0; t < N_tile; ++t)
         {
-            if (parameters.wind.magnitude == 0)
-                continue;
+            int const k_begin = N_x * (t * tile_rows);
+            int const k_end = N_x * std::min<int>((t + 1) * tile_rows, N_y);
+            kernels.aerodynamic_gather(lanes, air, k_begin, k_end);
+            cloth.force_lanes.store(force.data, k_begin, k_end);
+        }
+    }
+}
 
-            // Calcul vector from wind source to vertex
-            vec3 windToVertex = normalize(cloth.position(ku, kv) - parameters.wind.source);
-            
-            auto length = [](vec3 const& v) { return sqrt(v.x * v.x + v.y * v.y + v.z * v.z); };
+void simulation_compute_force(cloth_structure& cloth, simulation_parameters const& parameters)
+{
+    compute_force(cloth, parameters, true);
+}
 
-            // Calcul scalaire product between windToVertex and wind direction
-            float dotProduct = dot(windToVertex, parameters.wind.direction);
-            float angleInRadians = acos(dotProduct / (length(windToVertex) * length(parameters.wind.direction)));
-            float angleInDegrees = angleInRadians * (180.0f / Pi);
+void simulation_compute_external_force(cloth_structure& cloth, simulation_parameters const& parameters)
+{
+    compute_force(cloth, parameters, false);
+}
 
-            float v = dot(windToVertex, normal(ku, kv));
+void simulation_numerical_integration(cloth_structure& cloth, constraint_structure const& constraint, float dt)
+{
+    int const N_total = cloth.position.size();
+    float const m = cloth.mass_total/ static_cast<float>(N_total);
 
-            // Calcul distance between wind source and vertex
-            float distance = norm(cloth.position(ku, kv) - parameters.wind.source);
+    // Standard semi-implicit numerical integration (v += dt*f/m, p += dt*v), the fixed vertices keep a null velocity
+    //  Each coordinate is updated independently: the kernel runs directly on the 3*N_total floats of the buffers.
+    float* p = simd_flat(cloth.position.data);
+    float* v = simd_flat(cloth.velocity.data);
+    float const* f = simd_flat(cloth.force.data);
+    float const* w = simd_flat(constraint.inverse_mass);
+    if (N_total < parallel_vertex_threshold) {
+        simd_kernels().integrate(p, v, f, w, 3 * N_total, dt, dt / m);
+        cloth.update_bounding_box();
+        return;
+    }
 
-            // Calcul new wind mignitude with distance
-            float newMagnitude = parameters.wind.magnitude / (distance * distance);
-            
-            // Verify if it is in the wind direction cone
-            if (cgp::abs(angleInDegrees) <= 40.0f) {
-                vec3 windForce = v * normal(ku, kv) * newMagnitude;
-                force(ku, kv) += windForce;
-            }
+    // Large cloth: each tile of rows is integrated by a thread, and gives the bounding box of its rows
+    int const N_x = cloth.N_samples_x();
+    int const N_y = cloth.N_samples_y();
+    int const N_tile = tile_count(cloth);
+    std::vector<vec3> tile_min(N_tile), tile_max(N_tile);
+    #pragma omp parallel for
+    for (int t = 0; t < N_tile; ++t)
+    {
+        int const kv_begin = t * tile_rows;
+        int const kv_end = std::min<int>(kv_begin + tile_rows, N_y);
+        int const k_begin = 3 * N_x * kv_begin;
+        int const k_end = 3 * N_x * kv_end;
+        simd_kernels().integrate(p + k_begin, v + k_begin, f + k_begin, w + k_begin, k_end - k_begin, dt, dt / m);
+        cloth.bounding_box(N_x * kv_begin, N_x * kv_end, tile_min[t], tile_max[t]);
+    }
+
+    cloth.bounding_box_min = tile_min[0];
+    cloth.bounding_box_max = tile_max[0];
+    for (int t = 1; t < N_tile; ++t) {
+        for (int c = 0; c < 3; ++c) {
+            cloth.bounding_box_min[c] = std::min(cloth.bounding_box_min[c], tile_min[t][c]);
+            cloth.bounding_box_max[c] = std::max(cloth.bounding_box_max[c], tile_max[t][c]);
         }
     }
+}
+
+void simulation_step(cloth_structure& cloth, constraint_structure const& constraint, simulation_parameters const& parameters, float dt)
+{
+    assert_cgp(constraint.inverse_mass.size() == cloth.position.size(), "The constraint of the cloth must be initialized with it (constraint_structure::initialize)");
+    simulation_clothesline_begin_step(cloth);
 
+    switch (parameters.solver)
+    {
+    case simulation_solver::xpbd: {
+        simulation_parameters step_parameters = parameters;
+        step_parameters.xpbd.dt = dt;
+        simulation_xpbd_step(cloth, constraint, step_parameters);
+        break;
+    }
+    case simulation_solver::projective: {
+        simulation_parameters step_parameters = parameters;
+        step_parameters.projective.dt = dt;
+        simulation_projective_step(cloth, constraint, step_parameters);
+        break;
+    }
+    case simulation_solver::implicit_euler: {
+        implicit_parameters implicit = parameters.implicit;
+        implicit.dt = dt;
+        simulation_compute_force(cloth, parameters);
+        simulation_implicit_integration(cloth, constraint, implicit);
+        simulation_adaptive_measure(cloth, cloth.stepper.saved_position.data.data());
+        simulation_apply_constraints(cloth, constraint, parameters);
+        break;
+    }
+    default:
+        simulation_compute_force(cloth, parameters);
+        simulation_numerical_integration(cloth, constraint, dt);
+        simulation_adaptive_measure(cloth, cloth.stepper.saved_position.data.data());
+        simulation_apply_constraints(cloth, constraint, parameters);
+    }
 }
 
-void simulation_numerical_integration(cloth_structure& cloth, float dt)
+bool simulation_advance(cloth_structure& cloth, constraint_structure const& constraint, simulation_parameters const& parameters)
 {
-    int const N_x = cloth.N_samples_x();
-    int const N_y = cloth.N_samples_y();
-    int const N_total = cloth.position.size();
-    float const m = cloth.mass_total/ static_cast<float>(N_total);
+    int const N_step = simulation_steps_per_frame(parameters);
+    float const dt = simulation_time_step(parameters);
 
-    for (int ku = 0; ku < N_x; ++ku) {
-        for (int kv = 0; kv < N_y; ++kv) 
-        {
-            vec3& v = cloth.velocity(ku, kv);
-            vec3& p = cloth.position(ku, kv);
-            vec3 const& f = cloth.force(ku, kv);
+    // Adaptive substeps: a diverging cloth is rolled back and halted alone
+    if (parameters.adaptive.enabled)
+        return simulation_adaptive_step(cloth, constraint, parameters, N_step * dt);
 
-            // Standard semi-implicit numerical integration
-            v = v + dt * f / m;
-            p = p + dt * v;
+    for (int k_step = 0; k_step < N_step; ++k_step)
+    {
+        simulation_step(cloth, constraint, parameters, dt);
+        if (simulation_detect_divergence(cloth))
+        {
+            std::cout << "\n *** Simulation has diverged for ***" << std::endl;
+            std::cout << " > The simulation is stoped" << std::endl;
+            return false;
         }
     }
-    
+    return true;
+}
+
+void simulation_update_wind_field(wind_field_structure& field, simulation_parameters& parameters)
+{
+    field.update(parameters.wind.source, parameters.wind.direction, parameters.wind.magnitude, parameters.wind.aperture);
+    parameters.wind.field = &field;
+}
+
+float simulation_time_step(simulation_parameters const& parameters)
+{
+    switch (parameters.solver)
+    {
+    case simulation_solver::implicit_euler: return parameters.implicit.dt;
+    case simulation_solver::xpbd: return parameters.xpbd.dt;
+    case simulation_solver::projective: return parameters.projective.dt;
+    default: return parameters.dt;
+    }
+}
+
+int simulation_steps_per_frame(simulation_parameters const& parameters)
+{
+    // The implicit, position-based and projective solvers are stable with large time steps: a single step per frame is enough
+    return parameters.solver == simulation_solver::explicit_euler ? 5 : 1;
 }
 
 // Vector length
@@ -224,106 +385,75 @@ vec3 projectPointOntoCapsule(vec3 point, vec3 capsuleStart, vec3 capsuleEnd, flo
 }
 
 
-void simulation_apply_constraints(cloth_structure& cloth, constraint_structure const& constraint, simulation_parameters const& parameters)
+// Obstacles overlapping the bounding box of the cloth on the rows [kv_begin, kv_end)
+static void apply_obstacles(cloth_structure& cloth, simulation_parameters const& parameters, int kv_begin, int kv_end)
 {
-    // Fixed positions of the cloth
-    for (auto const& it : constraint.fixed_sample) 
-    {
-        position_contraint c = it.second;
-        cloth.position(c.ku, c.kv) = c.position; // set the position to the fixed one
-    }
+    int const N_x = cloth.N_samples_x();
+    parameters.obstacles.collide(cloth.obstacle_candidates, &cloth.position.data[0], N_x * kv_begin, N_x * kv_end);
+}
+
+void simulation_initialize_obstacles(simulation_parameters& parameters, float ground_z)
+{
+    obstacle_registry_structure& obstacles = parameters.obstacles;
+    obstacles.clear();
 
     // Floor
-    for (int ku = 0; ku < cloth.N_samples_x(); ++ku) 
-    {
-        for (int kv = 0; kv < cloth.N_samples_y(); ++kv) 
-        {
-            vec3& p = cloth.position(ku, kv);
-            if (p.z < constraint.ground_z) 
-                p.z = constraint.ground_z + 0.001f;
-        }
-    }
+    obstacles.add_plane({ 0,0,1 }, ground_z);
 
-    // Fan collision
-    vec3 capsuleStart = parameters.fan_position +  vec3({ 0.0f, 0.0f, -1.5 });
-    vec3 capsuleEnd = parameters.fan_position +  vec3({ 0.0f, 0.0f, 1.2f });
-    float capsuleRadius = 1.55f;
+    // Fan, placed by simulation_update_obstacles
+    parameters.fan_obstacle = obstacles.add_capsule({ 0,0,0 }, { 0,0,1 }, 1.0f);
+    simulation_update_obstacles(parameters);
 
-    for (int ku = 0; ku < cloth.N_samples_x(); ++ku) 
-    {
-        for (int kv = 0; kv < cloth.N_samples_y(); ++kv) 
-        {
-            vec3& p = cloth.position(ku, kv);
-            // Calcul distance between p and capsule
-            float distanceToCapsule = DistanceToSegment(p, capsuleStart, capsuleEnd);
+    // Clothesline poles
+    float const pole_radius = 0.3f;
+    for (auto const& pole : parameters.clothesline_poles)
+        obstacles.add_capsule(pole.first, pole.second, pole_radius);
+}
 
-            // If the p is in collision with the capsule
-            if (distanceToCapsule < capsuleRadius) 
-            {
-                // Adjust the position of the point
-                vec3 correctedPosition = projectPointOntoCapsule(p, capsuleStart, capsuleEnd, capsuleRadius);
-                p = correctedPosition;
-            }
-        }
-    }
+void simulation_update_obstacles(simulation_parameters& parameters)
+{
+    vec3 const fan_start = parameters.fan_position + vec3(0.0f, 0.0f, -1.5f);
+    vec3 const fan_end = parameters.fan_position + vec3(0.0f, 0.0f, 1.2f);
+    float const fan_radius = 1.55f;
+    if (parameters.fan_obstacle >= 0)
+        parameters.obstacles.set_capsule(parameters.fan_obstacle, fan_start, fan_end, fan_radius);
+}
 
-    
-    // Clothesline poles collision
-    for (int i = 0; i < parameters.clothesline_poles.size(); i++)
-    {
-        vec3 cylinderStart = parameters.clothesline_poles[i].first;
-        vec3 cylinderEnd = parameters.clothesline_poles[i].second;
-        float cylinderRadius = 0.3f;
+void simulation_apply_constraints(cloth_structure& cloth, constraint_structure const& constraint, simulation_parameters const& parameters)
+{
+    // Collisions of the cloth with itself, before the fixed positions and obstacles which have the last word
+    simulation_self_collision(cloth, constraint, parameters.self_collision);
 
-        for (int ku = 0; ku < cloth.N_samples_x(); ++ku) 
-        {
-            for (int kv = 0; kv < cloth.N_samples_y(); ++kv) 
-            {
-                vec3& p = cloth.position(ku, kv);
-                // Calcul distance between p and capsule
-                float distanceToCylinder = DistanceToSegment(p, cylinderStart, cylinderEnd);
+    // Wires of the clotheslines: swept from the positions at the beginning of the (sub)step, as they are too thin for the
+    //  discrete tests of the obstacles
+    simulation_clothesline_collision(cloth, constraint, parameters.clothesline, parameters.clothesline_collision);
 
-                // If the p is in collision with the capsule
-                if (distanceToCylinder < cylinderRadius) 
-                {
-                    // Adjust the position of the point
-                    vec3 correctedPosition = projectPointOntoCapsule(p, cylinderStart, cylinderEnd, cylinderRadius);
-                    p = correctedPosition;
-                }
-            }
-        }
-    }
-    
-    /*
-    // Clothesline collision
+    // Fixed positions of the cloth
+    for (position_contraint const& c : constraint.fixed_sample)
+        cloth.position.data[c.k] = c.position; // set the position to the fixed one
 
-    for (int i = 0; i < parameters.clothesline_poles.size(); i++)
-    {
-        vec3 lineStart = parameters.clothesline[i].first;
-        vec3 lineEnd = parameters.clothesline[i].second;
-        float threshold = 0.1f;
+    simulation_apply_obstacles(cloth, parameters);
+}
 
-        for (int ku = 0; ku < cloth.N_samples_x(); ++ku) 
-        {
-            for (int kv = 0; kv < cloth.N_samples_y(); ++kv) 
-            {
-                vec3& p = cloth.position(ku, kv);
-                // Calculate the distance between p and the line
-                float distanceToLine = DistanceToSegment(p, lineStart, lineEnd);
+void simulation_apply_obstacles(cloth_structure& cloth, simulation_parameters const& parameters)
+{
+    // Broadphase: obstacles overlapping the bounding box of the cloth (the margin covers the motion since its update)
+    parameters.obstacles.overlap(cloth.bounding_box_min, cloth.bounding_box_max, obstacle_margin, cloth.obstacle_candidates);
+    if (cloth.obstacle_candidates.empty())
+        return;
 
-                distanceToLine = std::round(distanceToLine * 100.0f) / 100.0f;
-                // If p is in collision with the line
-                if (distanceToLine < threshold && p.z >= 6.05f) 
-                {
-                    // Adjust the position of the point
-                    vec3 correctedPosition = projectPointOntoCapsule(p, lineStart, lineEnd, threshold);
-                    p = correctedPosition;
-                    std::cout << correctedPosition << std::endl;
-                }
-            }
-        }
-    }*/   
-}  
+    // Obstacles: each vertex is handled independently, large cloths are processed by tiles of rows in parallel
+    int const N_y = cloth.N_samples_y();
+    if (cloth.position.size() < parallel_vertex_threshold) {
+        apply_obstacles(cloth, parameters, 0, N_y);
+        return;
+    }
+
+    int const N_tile = tile_count(cloth);
+    #pragma omp parallel for
+    for (int t = 0; t < N_tile; ++t)
+        apply_obstacles(cloth, parameters, t * tile_rows, std::min<int>((t + 1) * tile_rows, N_y));
+}
 
 
 vec3 simulation_fan_clothesline(simulation_parameters &parameters, char axis)
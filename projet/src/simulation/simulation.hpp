@@ -1,20 +1,44 @@
 #pragma once
 
-#include "cgp/cgp.hpp"
+#include "../cgp_headless.hpp"
 #include "../cloth/cloth.hpp"
 #include "../constraint/constraint.hpp"
+#include "../implicit/implicit.hpp"
+#include "../xpbd/xpbd.hpp"
+#include "../projective/projective.hpp"
+#include "../adaptive/adaptive.hpp"
+#include "../wind/wind.hpp"
+#include "../obstacle/obstacle.hpp"
+#include "../self_collision/self_collision.hpp"
+#include "../clothesline/clothesline.hpp"
+#include "../cloth_collision/cloth_collision.hpp"
+#include "../sleeping/sleeping.hpp"
+#include "../lod/lod.hpp"
 
 
+// Numerical scheme used to advance the cloth in time
+enum class simulation_solver {
+    explicit_euler, // semi-implicit Euler on the forces, small time step (parameters.dt) and several steps per frame
+    implicit_euler, // backward Euler solved by conjugate gradient, one large time step per frame (parameters.implicit.dt)
+    xpbd,           // extended position-based dynamics, springs and collisions as constraints (parameters.xpbd)
+    projective      // projective dynamics with a prefactored system, one large time step per frame (parameters.projective)
+};
+
 struct simulation_parameters
 {
     float dt = 0.005f;        // time step for the numerical integration
-    vec3 fan_position = { 0,0,0 }; // position of the fan
+    simulation_solver solver = simulation_solver::explicit_euler;
+    implicit_parameters implicit; // settings of the implicit integrator
+    xpbd_parameters xpbd;         // settings of the position-based solver
+    projective_parameters projective; // settings of the projective dynamics solver
+    adaptive_parameters adaptive;     // settings of the adaptive time stepping
+    cgp::vec3 fan_position = { 0,0,0 }; // position of the fan
     bool fan_min_x = false;
     bool fan_max_x = false;
     bool fan_min_y = false;
     bool fan_max_y = false;
 
-    std::vector<std::pair<vec3, vec3>> clothesline_poles = {
+    std::vector<std::pair<cgp::vec3, cgp::vec3>> clothesline_poles = {
                                                     {{-8,-8,0}, {-8,-8,6.5f}},
                                                     {{-8,8,0}, {-8,8,6.5f}},
                                                     {{8,-8,0}, {8,-8,6.5f}},
@@ -23,19 +47,34 @@ struct simulation_parameters
                                                     {{4,2,0}, {4,2,6.5f}},
                                                     };
 
-    std::vector<std::pair<vec3, vec3>> clothesline = {
+    // Obstacles of the cloths (floor, fan, clothesline poles and any added obstacle), see simulation_initialize_obstacles
+    obstacle_registry_structure obstacles;
+    int fan_obstacle = -1; // index of the capsule of the fan
+
+    self_collision_parameters self_collision; // settings of the collisions of each cloth with itself
+
+    std::vector<std::pair<cgp::vec3, cgp::vec3>> clothesline = {
                                                     {{-8,-8,6}, {-8,8,6}},
                                                     {{-8,-8,6}, {8,-8,6}},
                                                     {{-8,8,6}, {8,8,6}},
                                                     {{4,2,6}, {4,6,6}},
                                                     };
+    clothesline_parameters clothesline_collision; // continuous collisions of the cloths with the wires above
+    cloth_collision_parameters cloth_collision;   // collisions between the cloths (see simulation_cloth_islands)
+    sleeping_parameters sleeping;                 // cloths at rest skipped until something changes around them
+    lod_parameters lod;                           // resolution of each cloth chosen from its size on the screen
 
-    //  Wind magnitude and direction
+    //  Wind of the fan and aerodynamic coefficients of the cloths
     struct {
-        float magnitude = 0.0f;
+        float magnitude = 0.0f; // air speed at 1m from the fan
         cgp::vec3 initial_direction = { -1,0,1 };
         cgp::vec3 direction = { -1,0,1 };
         cgp::vec3 source = {0, 0, 2};
+        float aperture = 40.0f; // half angle of the cone of the fan (degrees)
+        float air_density = 1.2f;
+        float drag_coefficient = 1.0f;
+        float lift_coefficient = 0.5f;
+        wind_field_structure const* field = nullptr; // sampled wind shared by the cloths (nullptr: evaluated at each vertex)
     } wind;
 };
 
@@ -43,13 +82,39 @@ struct simulation_parameters
 // Fill the forces in the cloth given the position and velocity
 void simulation_compute_force(cloth_structure& cloth, simulation_parameters const& parameters);
 
-// Perform 1 step of a semi-implicit integration with time step dt
-void simulation_numerical_integration(cloth_structure& cloth, float dt);
+// Fill the forces in the cloth without the springs (gravity, drag and wind)
+void simulation_compute_external_force(cloth_structure& cloth, simulation_parameters const& parameters);
+
+// Perform 1 step of a semi-implicit integration with time step dt (the fixed vertices of the constraint have no inverse mass)
+void simulation_numerical_integration(cloth_structure& cloth, constraint_structure const& constraint, float dt);
+
+// One step of the selected solver with the time step dt (replaces the time step set in the parameters of the solver)
+//  Includes the forces, the integration and the constraints.
+void simulation_step(cloth_structure& cloth, constraint_structure const& constraint, simulation_parameters const& parameters, float dt);
+
+// Advance the cloth by one frame: simulation_steps_per_frame() steps of the solver, or the same duration with adaptive
+//  substeps if parameters.adaptive.enabled. Returns false if the cloth diverged (fixed steps) or is halted (adaptive).
+bool simulation_advance(cloth_structure& cloth, constraint_structure const& constraint, simulation_parameters const& parameters);
+
+// Rasterize the wind of the fan in the field and share it with the cloths through the parameters (once per frame, before the steps)
+void simulation_update_wind_field(wind_field_structure& field, simulation_parameters& parameters);
+
+// Time step and number of steps per frame of the selected solver
+float simulation_time_step(simulation_parameters const& parameters);
+int simulation_steps_per_frame(simulation_parameters const& parameters);
+
+// Register the floor at the height ground_z, the fan and the clothesline poles as obstacles (replaces the previous obstacles)
+void simulation_initialize_obstacles(simulation_parameters& parameters, float ground_z);
+// Move the capsule of the fan to parameters.fan_position
+void simulation_update_obstacles(simulation_parameters& parameters);
 
-// Apply the constraints (fixed position, obstacles) on the cloth position and velocity
+// Apply the constraints (self-collision, clothesline wires, fixed position, obstacles) on the cloth position and velocity
+//  Only the obstacles and wires overlapping the bounding box of the cloth are tested.
 void simulation_apply_constraints(cloth_structure& cloth, constraint_structure const& constraint, simulation_parameters const& parameters);
+// Project the cloth out of the obstacles (floor, fan, poles) overlapping its bounding box, the last pass of the constraints
+void simulation_apply_obstacles(cloth_structure& cloth, simulation_parameters const& parameters);
 
-vec3 simulation_fan_clothesline(simulation_parameters &parameters, char axis);
+cgp::vec3 simulation_fan_clothesline(simulation_parameters &parameters, char axis);
 
 // Helper function that tries to detect if the simulation diverged 
 bool simulation_detect_divergence(cloth_structure const& cloth);
\ No newline at end of file
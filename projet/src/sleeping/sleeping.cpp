@@ -0,0 +1,148 @@
+#include "sleeping.hpp"
+
+#include "../simulation/simulation.hpp"
+
+#include <algorithm>
+
+using namespace cgp;
+
+
+// Number of samples of the wind along each side of the cloth when it changes
+static int const wind_samples = 8;
+
+static bool same(vec3 const& a, vec3 const& b)
+{
+    return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+float simulation_cloth_wind_speed(cloth_structure const& cloth, simulation_parameters const& parameters)
+{
+    auto const& wind = parameters.wind;
+    if (wind.magnitude == 0)
+        return 0.0f;
+
+    int const N_x = cloth.N_samples_x();
+    int const N_y = cloth.N_samples_y();
+    int const step_x = std::max(1, (N_x - 1) / wind_samples);
+    int const step_y = std::max(1, (N_y - 1) / wind_samples);
+    float speed2 = 0.0f;
+    for (int kv = 0; kv < N_y; kv += step_y) {
+        for (int ku = 0; ku < N_x; ku += step_x) {
+            vec3 const& p = cloth.position(ku, kv);
+            vec3 const air = wind.field != nullptr ? wind.field->sample(p) : wind_fan_evaluate(p, wind.source, wind.direction, wind.magnitude, wind.aperture);
+            speed2 = std::max(speed2, dot(air, air));
+        }
+    }
+    return std::sqrt(speed2);
+}
+
+// Save the surroundings of the cloth
+static void save_surroundings(sleeping_structure& sleeping, cloth_structure const& cloth, constraint_structure const& constraint, simulation_parameters const& parameters)
+{
+    sleeping.constraint_version = constraint.version;
+    sleeping.obstacle_version = parameters.obstacles.version;
+    parameters.obstacles.overlap(cloth.bounding_box_min, cloth.bounding_box_max, parameters.sleeping.margin, sleeping.obstacles);
+    sleeping.wind_source = parameters.wind.source;
+    sleeping.wind_direction = parameters.wind.direction;
+    sleeping.wind_magnitude = parameters.wind.magnitude;
+    sleeping.wind_aperture = parameters.wind.aperture;
+}
+
+void simulation_sleeping_update(cloth_structure& cloth, constraint_structure const& constraint, simulation_parameters const& parameters)
+{
+    sleeping_parameters const& settings = parameters.sleeping;
+    sleeping_structure& sleeping = cloth.sleeping;
+    if (!settings.enabled || sleeping.asleep)
+        return;
+
+    // Kinetic energy per unit of mass and largest displacement during the step. The velocities are those of the
+    //  displacements: the velocities of the solvers ignore the corrections of the collisions (ex. a cloth hung on a wire
+    //  keeps the velocity of its fall).
+    int const N = cloth.position.size();
+    numarray<vec3> const& start = cloth.cloth_collision.start;
+    if (start.size() != N) {
+        sleeping.rest_steps = 0;
+        return;
+    }
+    float sum_displacement2 = 0.0f;
+    float displacement2 = 0.0f;
+    for (int k = 0; k < N; ++k) {
+        vec3 const d = cloth.position.data[k] - start[k];
+        sum_displacement2 += dot(d, d);
+        displacement2 = std::max(displacement2, dot(d, d));
+    }
+    float const duration = simulation_steps_per_frame(parameters) * simulation_time_step(parameters);
+    float const kinetic_energy = 0.5f * sum_displacement2 / (N * duration * duration);
+    bool const rest = kinetic_energy < settings.kinetic_energy && displacement2 < settings.displacement * settings.displacement;
+    sleeping.rest_steps = rest ? sleeping.rest_steps + 1 : 0;
+    if (sleeping.rest_steps < settings.steps)
+        return;
+
+    // Asleep: the display shows the current state without interpolation
+    sleeping.asleep = true;
+    sleeping.rest_steps = 0;
+    cloth.velocity.data.fill({ 0, 0, 0 });
+    cloth.previous_position = cloth.position.data;
+    cloth.previous_normal = cloth.normal.data;
+    save_surroundings(sleeping, cloth, constraint, parameters);
+}
+
+void simulation_sleeping_check(cloth_structure& cloth, constraint_structure const& constraint, simulation_parameters const& parameters)
+{
+    sleeping_structure& sleeping = cloth.sleeping;
+    if (!sleeping.asleep)
+        return;
+    if (!parameters.sleeping.enabled || constraint.version != sleeping.constraint_version) {
+        simulation_sleeping_wake_up(cloth);
+        return;
+    }
+
+    // Obstacles which were or are around the cloth, changed since it fell asleep
+    obstacle_registry_structure const& obstacles = parameters.obstacles;
+    if (obstacles.version != sleeping.obstacle_version)
+    {
+        obstacle_candidates_structure around;
+        obstacles.overlap(cloth.bounding_box_min, cloth.bounding_box_max, parameters.sleeping.margin, around);
+        if (obstacles.last_change(sleeping.obstacles) > sleeping.obstacle_version || obstacles.last_change(around) > sleeping.obstacle_version) {
+            simulation_sleeping_wake_up(cloth);
+            return;
+        }
+        sleeping.obstacles = around;
+        sleeping.obstacle_version = obstacles.version;
+    }
+
+    // Wind of the fan changed: sampled on the cloth
+    auto const& wind = parameters.wind;
+    if (!same(wind.source, sleeping.wind_source) || !same(wind.direction, sleeping.wind_direction) || wind.magnitude != sleeping.wind_magnitude || wind.aperture != sleeping.wind_aperture)
+    {
+        if (simulation_cloth_wind_speed(cloth, parameters) > parameters.sleeping.wind) {
+            simulation_sleeping_wake_up(cloth);
+            return;
+        }
+        sleeping.wind_source = wind.source;
+        sleeping.wind_direction = wind.direction;
+        sleeping.wind_magnitude = wind.magnitude;
+        sleeping.wind_aperture = wind.aperture;
+    }
+}
+
+bool simulation_sleeping_island(cloth_islands_structure const& islands, int island, cloth_structure* const* cloths)
+{
+    int const i_begin = islands.island_start[island];
+    int const i_end = islands.island_start[island + 1];
+    bool awake = false;
+    for (int i = i_begin; i < i_end; ++i)
+        awake = awake || !cloths[islands.cloth_index[i]]->sleeping.asleep;
+    if (awake)
+        for (int i = i_begin; i < i_end; ++i)
+            simulation_sleeping_wake_up(*cloths[islands.cloth_index[i]]);
+    return awake;
+}
+
+void simulation_sleeping_wake_up(cloth_structure& cloth)
+{
+    if (!cloth.sleeping.asleep)
+        return;
+    cloth.sleeping.asleep = false;
+    cloth.sleeping.rest_steps = 0;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "../cgp_headless.hpp"
+#include "../obstacle/obstacle.hpp"
+
+struct cloth_structure;
+struct constraint_structure;
+struct simulation_parameters;
+struct cloth_islands_structure;
+
+
+// Settings of the sleeping of the cloths at rest
+struct sleeping_parameters
+{
+    bool enabled = true;
+    float kinetic_energy = 1e-5f; // kinetic energy per unit of mass (J/kg) below which a cloth is at rest
+    float displacement = 2e-4f;   // largest displacement of a vertex during a step below which a cloth is at rest
+    int steps = 60;               // number of consecutive steps at rest before the cloth falls asleep
+    float wind = 0.2f;            // air speed at the cloth waking it up
+    float margin = 0.5f;          // distance around the cloth in which a change of the obstacles wakes it up
+};
+
+// Rest state of a cloth: a sleeping cloth is not simulated nor sent again to the GPU
+struct sleeping_structure
+{
+    bool asleep = false;
+    int rest_steps = 0; // consecutive steps at rest of the awake cloth
+
+    // Surroundings of the sleeping cloth when it fell asleep (or at their last change without consequence)
+    int constraint_version = 0;
+    int obstacle_version = 0;
+    obstacle_candidates_structure obstacles; // obstacles around the cloth
+    cgp::vec3 wind_source;
+    cgp::vec3 wind_direction;
+    float wind_magnitude = 0.0f;
+    float wind_aperture = 0.0f;
+};
+
+
+// After a step of an awake cloth: count the steps at rest (kinetic energy and largest displacement from the positions at
+//  the beginning of the step, see simulation_cloth_collision_begin_step), and put the cloth to sleep after
+//  parameters.sleeping.steps of them. The velocities of a sleeping cloth are null.
+void simulation_sleeping_update(cloth_structure& cloth, constraint_structure const& constraint, simulation_parameters const& parameters);
+
+// Before the steps of a frame: wake a sleeping cloth up if its fixed positions changed, if an obstacle around it changed,
+//  or if the wind changed and blows on it (sampled on a subset of the vertices)
+void simulation_sleeping_check(cloth_structure& cloth, constraint_structure const& constraint, simulation_parameters const& parameters);
+
+// Wake the sleeping cloths of an island up if one of its cloths is awake (it may touch them). Returns false if the whole
+//  island sleeps: there is nothing to simulate.
+bool simulation_sleeping_island(cloth_islands_structure const& islands, int island, cloth_structure* const* cloths);
+
+void simulation_sleeping_wake_up(cloth_structure& cloth);
+
+// Largest air speed on a subset of the vertices of the cloth (also its exposure to the wind for the level of detail)
+float simulation_cloth_wind_speed(cloth_structure const& cloth, simulation_parameters const& parameters);
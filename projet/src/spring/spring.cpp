@@ -0,0 +1,150 @@
+#include "spring.hpp"
+
+#include "../cgp_headless.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+using namespace cgp;
+
+
+void spring_structure::clear()
+{
+    runs.clear();
+    batch_offset.clear();
+    run_first_spring.clear();
+    N_springs = 0;
+    gather_runs.clear();
+    gather_row_offset.clear();
+}
+
+void spring_structure::add_run(spring_run const& run)
+{
+    if (run.count <= 0)
+        return;
+    runs.push_back(run);
+    N_springs += run.count;
+}
+
+void spring_structure::add_spring(int a, int b, float L0, int type)
+{
+    add_run({ a, b, 1, type, L0 });
+}
+
+void spring_structure::build_batches(int N_vertex)
+{
+    // Greedy coloring: each run takes the first color that is not used yet by one of its vertices
+    std::vector<uint64_t> used_colors(N_vertex, 0);
+    std::vector<int> color(runs.size());
+    int N_color = 0;
+    for (size_t k = 0; k < runs.size(); ++k)
+    {
+        spring_run const& run = runs[k];
+
+        uint64_t used = 0;
+        for (int i = 0; i < run.count; ++i)
+            used |= used_colors[run.a + i] | used_colors[run.b + i];
+
+        int c = 0;
+        while (c < 64 && (used & (uint64_t(1) << c)))
+            ++c;
+        assert_cgp(c < 64, "Too many spring batches: the vertex degree of the cloth topology is too high");
+
+        for (int i = 0; i < run.count; ++i) {
+            used_colors[run.a + i] |= uint64_t(1) << c;
+            used_colors[run.b + i] |= uint64_t(1) << c;
+        }
+        color[k] = c;
+        N_color = std::max(N_color, c + 1);
+    }
+
+    // Sort the runs by color (counting sort, keeps the initial order within a batch)
+    batch_offset.assign(N_color + 1, 0);
+    for (int c : color)
+        batch_offset[c + 1]++;
+    for (int c = 0; c < N_color; ++c)
+        batch_offset[c + 1] += batch_offset[c];
+
+    std::vector<spring_run> sorted(runs.size());
+    std::vector<int> position(batch_offset.begin(), batch_offset.end() - 1);
+    for (size_t k = 0; k < runs.size(); ++k)
+        sorted[position[color[k]]++] = runs[k];
+    runs.swap(sorted);
+
+    run_first_spring.resize(runs.size());
+    int counter = 0;
+    for (size_t k = 0; k < runs.size(); ++k) {
+        run_first_spring[k] = counter;
+        counter += runs[k].count;
+    }
+}
+
+void spring_structure::build_gather(int N_x, int N_y)
+{
+    // Runs of each row, each spring being added in both directions
+    std::vector<std::vector<spring_run> > row_runs(N_y);
+    auto add_directed = [&](int a, int b, int count, int type, float L0)
+    {
+        // Split the run at the end of the rows of a
+        int i = 0;
+        while (i < count)
+        {
+            int const kv = (a + i) / N_x;
+            int const n = std::min(count - i, N_x * (kv + 1) - (a + i));
+            row_runs[kv].push_back({ a + i, b + i, n, type, L0 });
+            i += n;
+        }
+    };
+    for (spring_run const& run : runs) {
+        add_directed(run.a, run.b, run.count, run.type, run.L0);
+        add_directed(run.b, run.a, run.count, run.type, run.L0);
+    }
+
+    gather_runs.clear();
+    gather_row_offset.assign(N_y + 1, 0);
+    for (int kv = 0; kv < N_y; ++kv) {
+        gather_runs.insert(gather_runs.end(), row_runs[kv].begin(), row_runs[kv].end());
+        gather_row_offset[kv + 1] = static_cast<int>(gather_runs.size());
+    }
+}
+
+void spring_structure::initialize_grid(int N_x, int N_y, float L0_x, float L0_y)
+{
+    clear();
+
+    float const L0_diagonal = std::sqrt(L0_x * L0_x + L0_y * L0_y);
+
+    // Only the neighbors in the "forward" directions are stored: each spring appears once
+    struct offset { int du; int dv; float L0; int type; };
+    offset const offsets[6] = {
+        { 1, 0, L0_x, spring_structural }, { 0, 1, L0_y, spring_structural },
+        { 1, 1, L0_diagonal, spring_shear }, { -1, 1, L0_diagonal, spring_shear },
+        { 2, 0, 2 * L0_x, spring_bending }, { 0, 2, 2 * L0_y, spring_bending }
+    };
+
+    for (int kv = 0; kv < N_y; ++kv)
+    {
+        for (offset const& o : offsets)
+        {
+            if (kv + o.dv >= N_y)
+                continue;
+
+            // Range of ku such that both (ku,kv) and (ku+du,kv+dv) are in the grid
+            int const ku_begin = std::max(0, -o.du);
+            int const ku_end = std::min(N_x, N_x - o.du);
+
+            int const a = ku_begin + N_x * kv;
+            int const b = (ku_begin + o.du) + N_x * (kv + o.dv);
+            add_run({ a, b, ku_end - ku_begin, o.type, o.L0 });
+        }
+    }
+
+    build_batches(N_x * N_y);
+    build_gather(N_x, N_y);
+}
+
+int spring_structure::N_batch() const
+{
+    return batch_offset.empty() ? 0 : static_cast<int>(batch_offset.size()) - 1;
+}
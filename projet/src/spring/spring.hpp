@@ -0,0 +1,40 @@
+#pragma once
+
+#include "spring_run.hpp"
+
+#include <vector>
+
+
+// Table of the springs of a cloth, built once at initialization.
+//  Each spring is stored once: its force is applied to both extremities (action/reaction).
+//  The runs are sorted into batches such that two runs of the same batch never share a vertex:
+//  the runs of a batch can therefore be evaluated in parallel without write conflicts.
+struct spring_structure
+{
+    std::vector<spring_run> runs;   // Runs of springs, sorted by batch
+    std::vector<int> batch_offset;  // The batch b contains the runs [batch_offset[b], batch_offset[b+1])
+    std::vector<int> run_first_spring; // Index of the first spring of each run (for per-spring buffers of the solvers)
+    int N_springs = 0;              // Total number of springs
+
+    // Gather table used by the parallel row tiles: each spring appears twice (a->b and b->a) so that a vertex
+    //  accumulates all its forces by itself. The runs are split and sorted by the row of their first vertex a.
+    std::vector<spring_run> gather_runs;   // Runs of the gather table
+    std::vector<int> gather_row_offset;    // The runs writing to the row kv are [gather_row_offset[kv], gather_row_offset[kv+1])
+
+    void clear();
+
+    // Add springs to the table (build_batches must be called after the last addition)
+    void add_run(spring_run const& run);
+    void add_spring(int a, int b, float L0, int type);
+
+    // Sort the runs into conflict-free batches (greedy coloring of the runs sharing a vertex)
+    void build_batches(int N_vertex);
+
+    // Build the gather table from the runs of a N_x x N_y grid
+    void build_gather(int N_x, int N_y);
+
+    // Structural, shear and bending springs of a N_x x N_y grid where vertex (ku,kv) has index ku + N_x*kv
+    void initialize_grid(int N_x, int N_y, float L0_x, float L0_y);
+
+    int N_batch() const;
+};
@@ -0,0 +1,21 @@
+#pragma once
+
+// Plain description of springs shared with the vectorized kernels (no dependency on purpose, see simd/kernels/kernels.hpp)
+
+// Class of a spring, used to select its stiffness
+enum spring_type {
+    spring_structural = 0, // direct neighbors
+    spring_shear = 1,      // diagonal neighbors
+    spring_bending = 2     // neighbors at distance 2
+};
+
+// Set of consecutive springs with the same rest length:
+//  the spring k of the run connects the vertices (a+k) and (b+k), for k in [0,count).
+//  A grid row gives one run per neighbor offset, while an arbitrary topology gives runs of a single spring.
+struct spring_run {
+    int a;       // index of the first extremity of the first spring
+    int b;       // index of the second extremity of the first spring
+    int count;   // number of springs in the run
+    int type;    // spring_type
+    float L0;    // rest length
+};
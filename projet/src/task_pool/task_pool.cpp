@@ -0,0 +1,150 @@
+#include "task_pool.hpp"
+
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+
+task_pool::~task_pool()
+{
+    clear();
+}
+
+void task_pool::initialize(int N_worker_arg)
+{
+    clear();
+
+    int N = N_worker_arg > 0 ? N_worker_arg : static_cast<int>(std::thread::hardware_concurrency());
+    N = std::max(N, 1);
+
+    queues.reset(new worker_queue[N]);
+    stop = false;
+    generation = 0;
+    for (int k = 1; k < N; ++k)
+        threads.push_back(std::thread(&task_pool::worker_loop, this, k));
+}
+
+void task_pool::clear()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    wake_condition.notify_all();
+    for (std::thread& thread : threads)
+        thread.join();
+    threads.clear();
+    queues.reset();
+}
+
+int task_pool::N_worker() const
+{
+    return static_cast<int>(threads.size()) + 1;
+}
+
+void task_pool::run(int N_task, std::function<void(int)> const& task)
+{
+    if (N_task <= 0)
+        return;
+
+    // Sequential execution if the pool is not initialized, or if there is nothing to share
+    if (threads.empty() || N_task == 1) {
+        for (int k = 0; k < N_task; ++k)
+            task(k);
+        return;
+    }
+
+    int const N = N_worker();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        current_task = &task;
+        remaining = N_task;
+        for (int k = 0; k < N_task; ++k) {
+            worker_queue& queue = queues[k % N];
+            std::lock_guard<std::mutex> queue_lock(queue.mutex);
+            queue.tasks.push_back(k);
+        }
+        generation++;
+    }
+    wake_condition.notify_all();
+
+    // The calling thread works as well, then waits for the tasks stolen by the other workers
+#ifdef _OPENMP
+    int const omp_threads = omp_get_max_threads();
+    omp_set_num_threads(1);
+#endif
+    execute(0);
+#ifdef _OPENMP
+    omp_set_num_threads(omp_threads);
+#endif
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done_condition.wait(lock, [this]() { return remaining == 0; });
+    current_task = nullptr;
+}
+
+void task_pool::worker_loop(int worker)
+{
+    // The tasks already share the cores: the parallel loops of a task (tiles of rows of a large cloth) run on its own thread
+#ifdef _OPENMP
+    omp_set_num_threads(1);
+#endif
+
+    size_t seen_generation = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake_condition.wait(lock, [&]() { return stop || generation != seen_generation; });
+            if (stop)
+                return;
+            seen_generation = generation;
+        }
+        execute(worker);
+    }
+}
+
+void task_pool::execute(int worker)
+{
+    int task = 0;
+    while (pop_task(worker, task))
+    {
+        (*current_task)(task);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        remaining--;
+        if (remaining == 0)
+            done_condition.notify_all();
+    }
+}
+
+bool task_pool::pop_task(int worker, int& task)
+{
+    int const N = N_worker();
+
+    // Own tasks first, in order
+    {
+        worker_queue& queue = queues[worker];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = queue.tasks.front();
+            queue.tasks.pop_front();
+            return true;
+        }
+    }
+
+    // Steal the last task of another worker
+    for (int k = 1; k < N; ++k)
+    {
+        worker_queue& queue = queues[(worker + k) % N];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = queue.tasks.back();
+            queue.tasks.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
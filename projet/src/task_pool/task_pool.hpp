@@ -0,0 +1,56 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+// Pool of worker threads executing independent tasks with work stealing.
+//  The task k is first queued on the worker (k % N_worker): running the same set of tasks at every frame keeps each
+//  task (ex. a cloth) on the same thread and its data in the same cache. An idle worker steals the tasks remaining
+//  at the back of the queues of the other workers. The calling thread is the worker 0.
+//  The OpenMP loops inside the tasks run on a single thread when the tasks are shared between several workers (the pool
+//  and OpenMP would otherwise start N_worker x N_core threads), and on all the cores when the tasks run sequentially.
+struct task_pool
+{
+    task_pool() = default;
+    ~task_pool();
+    task_pool(task_pool const&) = delete;
+    task_pool& operator=(task_pool const&) = delete;
+
+    // Start the worker threads (N_worker=0: one worker per hardware thread)
+    void initialize(int N_worker = 0);
+    // Stop and join the worker threads
+    void clear();
+
+    // Execute task(k) for k in [0, N_task[ and wait for all of them to be finished
+    void run(int N_task, std::function<void(int)> const& task);
+
+    // Number of workers, including the calling thread
+    int N_worker() const;
+
+private:
+    struct worker_queue {
+        std::mutex mutex;
+        std::deque<int> tasks;
+    };
+
+    void worker_loop(int worker);
+    void execute(int worker);
+    bool pop_task(int worker, int& task);
+
+    std::vector<std::thread> threads;
+    std::unique_ptr<worker_queue[]> queues;
+
+    std::function<void(int)> const* current_task = nullptr;
+    std::mutex mutex;
+    std::condition_variable wake_condition;
+    std::condition_variable done_condition;
+    size_t generation = 0; // incremented at each call to run
+    int remaining = 0;     // tasks not finished in the current run
+    bool stop = false;
+};
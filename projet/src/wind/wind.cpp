@@ -0,0 +1,71 @@
+#include "wind.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace cgp;
+
+
+vec3 wind_fan_evaluate(vec3 const& p, vec3 const& source, vec3 const& direction, float magnitude, float aperture)
+{
+    vec3 const to_vertex = p - source;
+    float const distance = norm(to_vertex);
+    if (distance < 1e-6f)
+        return { 0,0,0 };
+
+    // Inside the cone: angle between the direction of the fan and the vertex below the aperture
+    vec3 const u = to_vertex / distance;
+    float const cos_aperture = std::cos(aperture * Pi / 180.0f);
+    if (dot(u, direction) < cos_aperture * norm(direction))
+        return { 0,0,0 };
+
+    return u * (magnitude / distance);
+}
+
+void wind_field_structure::update(vec3 const& source_arg, vec3 const& direction_arg, float magnitude_arg, float aperture_arg)
+{
+    empty = (magnitude_arg == 0);
+    if (empty)
+        return;
+
+    // Same fan as the previous frame: the field is kept
+    int3 const N = { int(std::ceil((p_max.x - p_min.x) / cell_size)) + 1, int(std::ceil((p_max.y - p_min.y) / cell_size)) + 1, int(std::ceil((p_max.z - p_min.z) / cell_size)) + 1 };
+    auto const same = [](vec3 const& a, vec3 const& b) { return a.x == b.x && a.y == b.y && a.z == b.z; };
+    if (field.dimension.x == N.x && field.dimension.y == N.y && field.dimension.z == N.z && same(source_arg, source) && same(direction_arg, direction) && magnitude_arg == magnitude && aperture_arg == aperture)
+        return;
+    source = source_arg;
+    direction = direction_arg;
+    magnitude = magnitude_arg;
+    aperture = aperture_arg;
+
+    field.resize(N);
+    #pragma omp parallel for
+    for (int kz = 0; kz < N.z; ++kz)
+        for (int ky = 0; ky < N.y; ++ky)
+            for (int kx = 0; kx < N.x; ++kx)
+                field(kx, ky, kz) = wind_fan_evaluate(p_min + cell_size * vec3(kx, ky, kz), source, direction, magnitude, aperture);
+}
+
+vec3 wind_field_structure::sample(vec3 const& p) const
+{
+    if (empty)
+        return { 0,0,0 };
+
+    // Cell containing p and relative coordinates in the cell
+    vec3 const q = (p - p_min) / cell_size;
+    int3 const N = field.dimension;
+    if (q.x < 0 || q.y < 0 || q.z < 0 || q.x >= N.x - 1 || q.y >= N.y - 1 || q.z >= N.z - 1)
+        return wind_fan_evaluate(p, source, direction, magnitude, aperture);
+
+    int const kx = int(q.x), ky = int(q.y), kz = int(q.z);
+    float const ax = q.x - kx, ay = q.y - ky, az = q.z - kz;
+
+    vec3 const* w = field.data.data.data() + field.index_to_offset(kx, ky, kz);
+    int const dy = N.x;
+    int const dz = N.x * N.y;
+    vec3 const w00 = (1 - ax) * w[0] + ax * w[1];
+    vec3 const w10 = (1 - ax) * w[dy] + ax * w[dy + 1];
+    vec3 const w01 = (1 - ax) * w[dz] + ax * w[dz + 1];
+    vec3 const w11 = (1 - ax) * w[dz + dy] + ax * w[dz + dy + 1];
+    return (1 - az) * ((1 - ay) * w00 + ay * w10) + az * ((1 - ay) * w01 + ay * w11);
+}
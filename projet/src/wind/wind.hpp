@@ -0,0 +1,32 @@
+#pragma once
+
+#include "../cgp_headless.hpp"
+
+
+// Air velocity of the fan sampled on a regular grid over the scene, shared by all the cloths.
+//  The grid is rasterized once per frame (the fan moves between two frames) and every vertex reads its air velocity
+//  with a trilinear interpolation instead of evaluating the cone of the fan.
+struct wind_field_structure
+{
+    cgp::grid_3D<cgp::vec3> field;     // air velocity at the nodes of the grid
+    cgp::vec3 p_min = { -9,-9,0 };     // bounds of the grid (clotheslines and cloths of the scene)
+    cgp::vec3 p_max = { 9,9,8 };
+    float cell_size = 0.5f;            // distance between two nodes
+    bool empty = true;                 // no wind: the field is not sampled
+
+    // Rasterize the wind of a fan (replaces the previous field, kept if the fan did not change)
+    void update(cgp::vec3 const& source, cgp::vec3 const& direction, float magnitude, float aperture);
+
+    // Trilinear interpolation of the field, evaluated exactly outside of the bounds
+    cgp::vec3 sample(cgp::vec3 const& p) const;
+
+private:
+    cgp::vec3 source;
+    cgp::vec3 direction;
+    float magnitude = 0.0f;
+    float aperture = 0.0f;
+};
+
+// Air velocity of a fan at the position p: along the direction from the source, magnitude/distance (the dynamic
+//  pressure decreases as 1/distance^2), zero outside of the cone of half angle aperture (degrees)
+cgp::vec3 wind_fan_evaluate(cgp::vec3 const& p, cgp::vec3 const& source, cgp::vec3 const& direction, float magnitude, float aperture);
@@ -0,0 +1,99 @@
+#include "xpbd.hpp"
+
+#include "../simulation/simulation.hpp"
+#include "../simd/parallel.hpp"
+
+using namespace cgp;
+
+
+// Project the distance constraints of the springs of the run r
+static void project_run(spring_run const& run, float* lambda, float alpha, std::vector<float> const& inverse_mass, numarray<vec3>& position)
+{
+    for (int i = 0; i < run.count; ++i)
+    {
+        int const ka = run.a + i;
+        int const kb = run.b + i;
+        float const wa = inverse_mass[ka];
+        float const wb = inverse_mass[kb];
+        if (wa + wb == 0.0f)
+            continue;
+
+        vec3 const d = position.data[kb] - position.data[ka];
+        float const L = norm(d);
+        if (L < 1e-8f)
+            continue;
+        vec3 const n = d / L;
+
+        float const C = L - run.L0;
+        float const delta_lambda = (-C - alpha * lambda[i]) / (wa + wb + alpha);
+        lambda[i] += delta_lambda;
+
+        position.data[ka] -= wa * delta_lambda * n;
+        position.data[kb] += wb * delta_lambda * n;
+    }
+}
+
+void simulation_xpbd_step(cloth_structure& cloth, constraint_structure const& constraint, simulation_parameters const& parameters)
+{
+    xpbd_solver_structure& solver = cloth.xpbd_solver;
+    spring_structure const& springs = cloth.springs;
+    xpbd_parameters const& xpbd = parameters.xpbd;
+
+    int const N = cloth.position.size();
+    int const N_substeps = std::max(xpbd.substeps, 1);
+    float const h = xpbd.dt / N_substeps;
+    float const m = cloth.mass_total / N;
+    float const alpha = 1.0f / (cloth.K * h * h); // compliance of the springs divided by h^2
+
+    numarray<vec3>& position = cloth.position.data;
+    numarray<vec3>& velocity = cloth.velocity.data;
+
+    // Fixed vertices have an infinite mass
+    solver.inverse_mass.resize(N);
+    for (int k = 0; k < N; ++k)
+        solver.inverse_mass[k] = constraint.weight(k) / m;
+
+    solver.lambda.resize(springs.N_springs);
+    solver.previous_position.resize(N);
+
+    for (int k_substep = 0; k_substep < N_substeps; ++k_substep)
+    {
+        // Prediction with the external forces (gravity, drag, wind)
+        simulation_compute_external_force(cloth, parameters);
+        for (int k = 0; k < N; ++k)
+        {
+            solver.previous_position[k] = position.data[k];
+            velocity.data[k] += h * solver.inverse_mass[k] * cloth.force.data.data[k];
+            position.data[k] += h * velocity.data[k];
+        }
+
+        // Distance constraints: Gauss-Seidel within a run, parallel between the runs of a batch. The contacts with the
+        //  obstacles are projected after the springs in each iteration, so that the next iterations see them (the last
+        //  iteration ends with all the inequality constraints below).
+        std::fill(solver.lambda.begin(), solver.lambda.end(), 0.0f);
+        if (xpbd.iterations > 1)
+            cloth.update_bounding_box();
+        for (int k_iteration = 0; k_iteration < xpbd.iterations; ++k_iteration)
+        {
+            for (int b = 0; b < springs.N_batch(); ++b)
+            {
+                int const run_begin = springs.batch_offset[b];
+                int const run_end = springs.batch_offset[b + 1];
+                #pragma omp parallel for if(springs.N_springs > parallel_spring_threshold)
+                for (int r = run_begin; r < run_end; ++r)
+                    project_run(springs.runs[r], &solver.lambda[springs.run_first_spring[r]], alpha, solver.inverse_mass, position);
+            }
+            if (k_iteration + 1 < xpbd.iterations)
+                simulation_apply_obstacles(cloth, parameters);
+        }
+
+        // Inequality constraints (fixed positions, floor, fan and poles)
+        cloth.update_bounding_box();
+        simulation_adaptive_measure(cloth, solver.previous_position.data());
+        simulation_apply_constraints(cloth, constraint, parameters);
+
+        // Velocity deduced from the displacement
+        for (int k = 0; k < N; ++k)
+            velocity.data[k] = (position.data[k] - solver.previous_position[k]) / h;
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "../cgp_headless.hpp"
+
+#include <vector>
+
+struct cloth_structure;
+struct constraint_structure;
+struct simulation_parameters;
+
+
+// Settings of the position-based solver
+struct xpbd_parameters
+{
+    float dt = 1.0f / 60.0f; // time step of a frame
+    int substeps = 10;       // number of substeps per time step
+    int iterations = 1;      // number of constraint projections per substep
+};
+
+// Buffers used by the position-based solver (kept between the steps to avoid reallocations)
+struct xpbd_solver_structure
+{
+    std::vector<cgp::vec3> previous_position; // positions at the beginning of the substep
+    std::vector<float> inverse_mass;          // 0 for the fixed vertices
+    std::vector<float> lambda;                // Lagrange multiplier of each spring constraint
+};
+
+
+// One time step of extended position-based dynamics (XPBD, Macklin et al. 2016).
+//  The springs become distance constraints with compliance 1/K projected by Gauss-Seidel: the conflict-free
+//  batches of the spring table act as a graph coloring, so the runs of a batch are projected in parallel.
+//  The fixed positions, floor, fan and poles collisions of simulation_apply_constraints are projected
+//  after the springs as inequality constraints at each substep.
+void simulation_xpbd_step(cloth_structure& cloth, constraint_structure const& constraint, simulation_parameters const& parameters);